@@ -0,0 +1,65 @@
+###############################################################################
+#  Copyright (c) 2014-2020 libbitcoin developers (see COPYING).
+#
+###############################################################################
+# FindZlib
+#
+# Use this module by invoking find_package with the form::
+#
+#   find_package( Zlib
+#     [version]           # Minimum version (ignored)
+#     [REQUIRED]          # Fail with error if zlib is not found
+#   )
+#
+#   Defines the following for use:
+#
+#   zlib_FOUND            - true if headers and requested libraries were found
+#   zlib_LIBRARIES        - zlib libraries to be linked
+#   zlib_LIBS             - zlib libraries to be linked
+#
+
+if (DEFINED Zlib_FIND_VERSION)
+    message( SEND_ERROR
+        "Library 'zlib' unable to process version: ${Zlib_FIND_VERSION}" )
+endif()
+
+
+if (MSVC)
+    set( zlib_FOUND false )
+    message( STATUS
+        "MSVC environment detection for 'zlib' not currently supported." )
+else ()
+    # conditionally include static library suffix
+    if (BUILD_SHARED_LIBS)
+        set( _zlib_lib_name "z" )
+    else ()
+        set( _zlib_lib_name "libz.a" )
+    endif()
+
+    find_library( z_LIBRARIES "${_zlib_lib_name}" )
+
+    if (z_LIBRARIES-NOTFOUND)
+        set( zlib_FOUND false )
+    else ()
+        set( zlib_FOUND true )
+        set( zlib_LIBRARIES "${z_LIBRARIES}" )
+        set( zlib_LIBS "-lz" )
+    endif()
+
+    if (NOT BUILD_SHARED_LIBS)
+        set( zlib_STATIC_LIBRARIES "${zlib_LIBRARIES}" )
+    endif()
+endif()
+
+
+if (NOT zlib_FOUND)
+    if ( Zlib_FIND_REQUIRED )
+        set( _zlib_MSG_STATUS "SEND_ERROR" )
+    else ()
+        set( _zlib_MSG_STATUS "STATUS" )
+    endif()
+
+    message( _zlib_MSG_STATUS "Library 'zlib'  not found (${_zlib_MSG_STATUS})." )
+else ()
+    message( "Library 'zlib' found." )
+endif()
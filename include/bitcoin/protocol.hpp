@@ -15,27 +15,45 @@
  */
 
 #include <bitcoin/system.hpp>
+#include <bitcoin/protocol/affinity.hpp>
 #include <bitcoin/protocol/define.hpp>
 #include <bitcoin/protocol/settings.hpp>
 #include <bitcoin/protocol/version.hpp>
+#include <bitcoin/protocol/web/asset_cache.hpp>
+#include <bitcoin/protocol/web/binary_query.hpp>
 #include <bitcoin/protocol/web/bind_options.hpp>
+#include <bitcoin/protocol/web/buffer_pool.hpp>
+#include <bitcoin/protocol/web/compressor.hpp>
 #include <bitcoin/protocol/web/connection.hpp>
 #include <bitcoin/protocol/web/connection_state.hpp>
 #include <bitcoin/protocol/web/event.hpp>
+#include <bitcoin/protocol/web/file_pool.hpp>
 #include <bitcoin/protocol/web/file_transfer.hpp>
+#include <bitcoin/protocol/web/hpack.hpp>
 #include <bitcoin/protocol/web/http.hpp>
+#include <bitcoin/protocol/web/http2_session.hpp>
+#include <bitcoin/protocol/web/http_parser.hpp>
 #include <bitcoin/protocol/web/http_reply.hpp>
 #include <bitcoin/protocol/web/http_request.hpp>
 #include <bitcoin/protocol/web/json_string.hpp>
+#include <bitcoin/protocol/web/loop_monitor.hpp>
 #include <bitcoin/protocol/web/manager.hpp>
 #include <bitcoin/protocol/web/protocol_status.hpp>
+#include <bitcoin/protocol/web/route_table.hpp>
 #include <bitcoin/protocol/web/socket.hpp>
 #include <bitcoin/protocol/web/ssl.hpp>
+#include <bitcoin/protocol/web/subscription_index.hpp>
+#include <bitcoin/protocol/web/utf8_validator.hpp>
 #include <bitcoin/protocol/web/utilities.hpp>
+#include <bitcoin/protocol/web/vector_kernel.hpp>
+#include <bitcoin/protocol/web/websocket_assembler.hpp>
+#include <bitcoin/protocol/web/websocket_decoder.hpp>
+#include <bitcoin/protocol/web/websocket_deflate.hpp>
 #include <bitcoin/protocol/web/websocket_frame.hpp>
+#include <bitcoin/protocol/web/websocket_keepalive.hpp>
+#include <bitcoin/protocol/web/websocket_mask.hpp>
 #include <bitcoin/protocol/web/websocket_message.hpp>
 #include <bitcoin/protocol/web/websocket_op.hpp>
-#include <bitcoin/protocol/web/websocket_transfer.hpp>
 #include <bitcoin/protocol/zmq/authenticator.hpp>
 #include <bitcoin/protocol/zmq/certificate.hpp>
 #include <bitcoin/protocol/zmq/context.hpp>
@@ -0,0 +1,39 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_PROTOCOL_AFFINITY_HPP
+#define LIBBITCOIN_PROTOCOL_AFFINITY_HPP
+
+#include <cstdint>
+#include <vector>
+#include <bitcoin/protocol/define.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+
+/// A set of logical processor indexes (empty implies no pinning).
+typedef std::vector<uint32_t> cpu_list;
+
+/// Restrict the calling thread to the given processors.
+/// Returns true if the list is empty (nop) or the affinity was applied.
+BCP_API bool set_affinity(const cpu_list& cpus);
+
+} // namespace protocol
+} // namespace libbitcoin
+
+#endif
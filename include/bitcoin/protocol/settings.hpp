@@ -21,6 +21,7 @@
 
 #include <cstdint>
 #include <bitcoin/system.hpp>
+#include <bitcoin/protocol/affinity.hpp>
 #include <bitcoin/protocol/define.hpp>
 
 namespace libbitcoin {
@@ -59,8 +60,29 @@ public:
     // ZMQ_SNDTIMEO (0 unlimited)
     uint32_t send_milliseconds;
 
+    /// Processors for the web socket's zmq worker thread (empty unpinned)
+    /// Context I/O threads are pinned by the context's own affinity list.
+    cpu_list worker_affinity;
+
     /// Websocket/HTTP(s)/JSON-RPC related settings
     bool web_priority;
+
+    /// Processors for the websocket (connection handling) thread.
+    cpu_list web_affinity;
+    uint32_t web_loop_budget_milliseconds;
+    uint32_t web_connection_limit;
+    uint32_t web_pending_query_limit;
+    uint64_t web_outbound_byte_limit;
+    bool web_reject_overload;
+    uint64_t web_asset_cache_bytes;
+    uint32_t web_asset_file_bytes;
+    uint32_t web_compression_level;
+    uint32_t web_compression_threshold;
+    uint32_t web_websocket_message_bytes;
+    uint32_t web_websocket_window_bits;
+    bool web_websocket_context_takeover;
+    uint32_t web_websocket_ping_seconds;
+    uint32_t web_websocket_missed_pongs;
     system::config::endpoint::list web_origins;
     boost::filesystem::path web_root;
     boost::filesystem::path web_ca_certificate;
@@ -0,0 +1,164 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_PROTOCOL_WEB_ASSET_CACHE_HPP
+#define LIBBITCOIN_PROTOCOL_WEB_ASSET_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <bitcoin/system.hpp>
+#include <bitcoin/protocol/define.hpp>
+#include <bitcoin/protocol/web/compressor.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+// Bounded, least recently used cache of static files keyed by request uri.
+// Each asset holds its body (and any precompressed .gz/.br siblings) in
+// memory along with pre-encoded response header fields and validators, so a
+// hit requires no file system access. Entries are invalidated by inotify on
+// Linux and by a modification time check elsewhere. Not thread safe, used
+// only on the manager thread.
+class BCP_API asset_cache
+  : system::noncopyable
+{
+public:
+    enum class encoding
+    {
+        identity,
+        gzip,
+        brotli
+    };
+
+    struct variant
+    {
+        encoding coding;
+        system::data_chunk body;
+
+        // Quoted strong validator, distinct for each encoding.
+        std::string etag;
+
+        // Header fields (CRLF terminated) of the 200 and 304 responses.
+        std::string fields;
+        std::string not_modified_fields;
+    };
+
+    struct asset
+    {
+        boost::filesystem::path path;
+        std::time_t modified;
+
+        // Variants in order of preference, identity is always last.
+        std::vector<variant> variants;
+
+        size_t size() const;
+        const variant& select(const std::string& accept_encoding) const;
+    };
+
+    typedef std::shared_ptr<const asset> ptr;
+
+    // Files larger than the per-file limit are not cached (zero disables).
+    asset_cache(size_t maximum_bytes=0, size_t maximum_file_bytes=0);
+    ~asset_cache();
+
+    void set_limits(size_t maximum_bytes, size_t maximum_file_bytes);
+
+    // Compressible files without a .gz sibling are gzipped once as loaded.
+    void set_compressor(http::compressor* compressor);
+    bool enabled() const;
+    size_t size() const;
+    size_t count() const;
+
+    // Returns the cached asset for the uri, or nullptr if absent or stale.
+    ptr find(const std::string& uri);
+
+    // Reads the file (and siblings) and caches it under the uri, returns
+    // nullptr if the file cannot be cached.
+    ptr load(const std::string& uri, const boost::filesystem::path& path);
+
+    // Off-loop loading: the version is captured on the manager thread, the
+    // asset is read on another and then inserted on the manager thread.
+
+    // Count of change notifications applied.
+    uint64_t version() const;
+
+    // Reads the file (and siblings) within the limits without caching it,
+    // returns nullptr if it cannot be cached. This is thread safe given a
+    // compressor used only by the calling thread (or null).
+    ptr read(const boost::filesystem::path& path,
+        http::compressor* compressor) const;
+
+    // Caches an asset read since the version was captured, false if it is
+    // too large or a change to it may have been missed in the meantime.
+    bool insert(const std::string& uri, ptr value, uint64_t version);
+
+    void invalidate(const std::string& uri);
+    void clear();
+
+    // Apply pending file change notifications (inotify only).
+    void refresh();
+
+    // True if the If-None-Match header value matches the etag.
+    static bool matches(const std::string& if_none_match,
+        const std::string& etag);
+
+    // Format a time as an HTTP-date (RFC 7231).
+    static std::string to_http_date(std::time_t time);
+
+private:
+    typedef std::list<std::string> recency;
+
+    struct entry
+    {
+        ptr value;
+        recency::iterator position;
+    };
+
+    typedef std::unordered_map<std::string, entry> entry_map;
+
+    void erase(entry_map::iterator it);
+    void trim();
+    bool watch(const boost::filesystem::path& directory);
+    bool watched(const boost::filesystem::path& directory) const;
+
+    size_t maximum_bytes_;
+    size_t maximum_file_bytes_;
+    size_t size_;
+    uint64_t version_;
+    http::compressor* compressor_;
+    entry_map entries_;
+    recency recency_;
+
+    // Linux only, inotify descriptor and watched directory by watch id.
+    int notifier_;
+    std::unordered_map<int, boost::filesystem::path> watches_;
+};
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
+
+#endif
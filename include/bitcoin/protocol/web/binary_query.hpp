@@ -0,0 +1,64 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_PROTOCOL_WEB_BINARY_QUERY_HPP
+#define LIBBITCOIN_PROTOCOL_WEB_BINARY_QUERY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <bitcoin/system.hpp>
+#include <bitcoin/protocol/define.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+// A query or response of the binary websocket subprotocol, which carries the
+// parts of a zmq query (command, id and payload) in one binary message, so
+// that it is forwarded without translation to or from JSON:
+//
+//   [command size:1][command][id:4, little endian][payload]
+//
+// The payload of a request is the zmq request data, and that of a response
+// is the zmq response data (the error code followed by the result).
+struct BCP_API binary_query
+{
+    // The Sec-WebSocket-Protocol name of the subprotocol.
+    static const std::string protocol;
+
+    static constexpr size_t id_size = sizeof(uint32_t);
+    static constexpr size_t maximum_command = 255;
+
+    // False if the message is truncated or the command is empty.
+    static bool decode(binary_query& out, const uint8_t* data, size_t size);
+
+    // Empty if the command is empty or too long.
+    static system::data_chunk encode(const std::string& command, uint32_t id,
+        const system::data_chunk& payload);
+
+    std::string command;
+    uint32_t id;
+    system::data_chunk payload;
+};
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
+
+#endif
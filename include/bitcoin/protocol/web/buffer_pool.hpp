@@ -0,0 +1,62 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_PROTOCOL_WEB_BUFFER_POOL_HPP
+#define LIBBITCOIN_PROTOCOL_WEB_BUFFER_POOL_HPP
+
+#include <cstddef>
+#include <vector>
+#include <bitcoin/system.hpp>
+#include <bitcoin/protocol/define.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+// Buffers released for reuse keep their capacity, so that once warm the
+// buffers of a manager (reactor) thread are appended to without allocating.
+// Not thread safe.
+class BCP_API buffer_pool
+  : system::noncopyable
+{
+public:
+    static constexpr size_t default_buffers = 16;
+
+    // The number of released buffers that are kept.
+    buffer_pool(size_t buffers=default_buffers);
+
+    // An empty buffer, with the capacity of a released buffer if any.
+    system::data_chunk acquire();
+
+    // Keep the buffer (cleared) unless the pool is full, the buffer is left
+    // empty and without capacity either way.
+    void release(system::data_chunk& buffer);
+
+    // The number of buffers kept.
+    size_t size() const;
+
+private:
+    const size_t buffers_;
+    std::vector<system::data_chunk> pool_;
+};
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,93 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_PROTOCOL_WEB_COMPRESSOR_HPP
+#define LIBBITCOIN_PROTOCOL_WEB_COMPRESSOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <bitcoin/system.hpp>
+#include <bitcoin/protocol/define.hpp>
+
+#ifdef WITH_ZLIB
+    #include <zlib.h>
+#endif
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+enum class content_coding
+{
+    identity,
+    gzip,
+    deflate
+};
+
+// Response body compression with deflate state that is allocated once and
+// reset for each body, so one compressor serves all responses of a manager
+// (reactor) thread. Not thread safe. Without zlib (WITH_ZLIB) nothing is
+// negotiated and bodies are sent as is.
+class BCP_API compressor
+  : system::noncopyable
+{
+public:
+    static constexpr int32_t default_level = 6;
+    static constexpr size_t default_threshold = 1024;
+
+    // Level is 1 (fastest) to 9 (smallest), zero disables compression.
+    compressor(int32_t level=default_level,
+        size_t threshold=default_threshold);
+    ~compressor();
+
+    static bool available();
+    static std::string to_string(content_coding coding);
+
+    void configure(int32_t level, size_t threshold);
+    int32_t level() const;
+    size_t threshold() const;
+
+    // The supported coding preferred by the Accept-Encoding header value.
+    content_coding negotiate(const std::string& accept_encoding) const;
+
+    // Compress the body into out, returns false (out unspecified) if the
+    // body is below the threshold, would not shrink or the coding is
+    // unsupported, in which case the body should be sent as is.
+    bool compress(std::string& out, const std::string& body,
+        content_coding coding);
+
+private:
+    void release();
+
+    int32_t level_;
+    size_t threshold_;
+
+#ifdef WITH_ZLIB
+    bool gzip_ready_;
+    bool deflate_ready_;
+    z_stream gzip_;
+    z_stream deflate_;
+#endif
+};
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
+
+#endif
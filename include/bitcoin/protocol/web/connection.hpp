@@ -25,22 +25,32 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <deque>
 #include <functional>
+#include <map>
 #include <set>
 #include <string>
 #include <memory>
 #include <vector>
 #include <bitcoin/system.hpp>
 #include <bitcoin/protocol/define.hpp>
+#include <bitcoin/protocol/web/compressor.hpp>
 #include <bitcoin/protocol/web/connection_state.hpp>
 #include <bitcoin/protocol/web/event.hpp>
 #include <bitcoin/protocol/web/file_transfer.hpp>
 #include <bitcoin/protocol/web/http.hpp>
+#include <bitcoin/protocol/web/http2_session.hpp>
+#include <bitcoin/protocol/web/http_parser.hpp>
+#include <bitcoin/protocol/web/http_reply.hpp>
+#include <bitcoin/protocol/web/protocol_status.hpp>
 #include <bitcoin/protocol/web/ssl.hpp>
 #include <bitcoin/protocol/web/utilities.hpp>
+#include <bitcoin/protocol/web/websocket_assembler.hpp>
+#include <bitcoin/protocol/web/websocket_decoder.hpp>
+#include <bitcoin/protocol/web/websocket_deflate.hpp>
 #include <bitcoin/protocol/web/websocket_frame.hpp>
+#include <bitcoin/protocol/web/websocket_keepalive.hpp>
 #include <bitcoin/protocol/web/websocket_op.hpp>
-#include <bitcoin/protocol/web/websocket_transfer.hpp>
 
 namespace libbitcoin {
 namespace protocol {
@@ -52,6 +62,9 @@ class connection;
 typedef std::shared_ptr<connection> connection_ptr;
 typedef std::set<connection_ptr> connection_set;
 typedef std::vector<connection_ptr> connection_list;
+
+// A websocket message payload shared by the connections it is written to.
+typedef std::shared_ptr<const system::data_chunk> shared_payload;
 typedef std::function<bool(connection_ptr, event, void* data)> event_handler;
 
 // This class is instantiated from accepted/incoming HTTP clients.
@@ -77,13 +90,37 @@ public:
     bool websocket() const;
     void set_websocket(bool websocket);
 
+    // The websocket subprotocol agreed on upgrade, empty if none.
+    const std::string& websocket_protocol() const;
+    void set_websocket_protocol(const std::string& protocol);
+
     bool json_rpc() const;
     void set_json_rpc(bool json_rpc);
 
+    // Server-Sent Events, the response is a chunked stream of events and
+    // no further requests are read from the connection.
+    bool event_stream() const;
+    void set_event_stream(bool event_stream);
+
+    // Set from each request, the connection is closed once idle if false.
+    bool keep_alive() const;
+    void set_keep_alive(bool keep_alive);
+
+    // Set from each request, an HTTP/1.0 client cannot decode chunked
+    // transfer coding, so its streamed bodies are otherwise delimited.
+    double protocol_version() const;
+    void set_protocol_version(double protocol_version);
+    bool chunked() const;
+
     // The connection endpoint is a request uri, such as '/'.
     const std::string& uri() const;
     void set_uri(const std::string& uri);
 
+    // HTTP/2 is started by the client connection preface, after which the
+    // stream identifier of each request is its response slot (null if not).
+    http2_session* http2();
+    http2_session* start_http2(size_t maximum_body);
+
     // Readers and Writers.
     // ------------------------------------------------------------------------
     // Signed integer results overload negative range for error code.
@@ -91,17 +128,121 @@ public:
     http::read_buffer& read_buffer();
     system::data_chunk& write_buffer();
 
+    // Request bytes accumulated across reads and the parse state over them.
+    system::data_chunk& input_buffer();
+    http::http_parser& parser();
+
     int32_t read();
     int32_t read_length();
 
+    // Buffer the data (as a websocket message if upgraded), failing (-1)
+    // without buffering anything if high water would be exceeded.
     int32_t write(const system::data_chunk& buffer);
     int32_t write(const std::string& buffer);
-    int32_t write(const uint8_t* data, size_t length);
+    int32_t write(const uint8_t* data, size_t length,
+        websocket_op code=websocket_op::text);
+
+    // Queue a websocket frame of a payload (compressed if so flagged) that
+    // is shared by many connections, dropped (not failed) if high water
+    // would be exceeded. The header is encoded in place and the payload is not
+    // copied.
+    bool write_frame(const shared_payload& payload,
+        websocket_op code=websocket_op::text, bool compressed=false);
+
+    // As above, for a message compressed by this connection (if negotiated)
+    // as its compression context is taken over between messages.
+    bool write_frame(const uint8_t* data, size_t length,
+        websocket_op code=websocket_op::text);
+
+    // Frames dropped at high water (above) since the connection opened.
+    size_t dropped() const;
+
+    // Buffer a websocket control frame (payload of at most 125 bytes),
+    // which is never compressed or dropped.
+    bool write_control(websocket_op code, const uint8_t* data, size_t size);
+
+    // Format a response header directly into the write buffer, failing (-1)
+    // as above.
+    int32_t write_header(protocol_status status, const std::string& mime_type,
+        size_t content_length, bool keep_alive);
+
+    // As above, with pre-encoded fields in place of the content headers.
+    int32_t write_header(protocol_status status, const std::string& fields,
+        bool keep_alive);
+
+    // Bytes buffered and queued (in frames) that await writing.
+    size_t buffered() const;
+
+    // The running total of bytes buffered by all connections is shared with
+    // the manager (null detaches), and kept current as this buffer changes.
+    // It also counts responses held behind their predecessors.
+    // It is shared as a connection may outlive its manager.
+    typedef std::shared_ptr<size_t> counter_ptr;
+    void set_outbound_counter(counter_ptr counter);
+
+    // Write up to the limit from the buffer and then the queued frames,
+    // with one vectored write where possible. Returns the number of bytes
+    // written (zero if the socket would block) or negative on failure.
+    int32_t flush(size_t limit);
 
     int32_t unbuffered_write(const system::data_chunk& buffer);
     int32_t unbuffered_write(const std::string& buffer);
     int32_t unbuffered_write(const uint8_t* data, size_t length);
 
+    // Pipelined responses.
+    // ------------------------------------------------------------------------
+    // Each request reserves the next slot and responses are written in slot
+    // order, regardless of the order in which they complete. The active slot
+    // identifies the request being answered on the manager thread. On an
+    // HTTP/2 connection responses are instead framed on their streams as
+    // they complete.
+
+    uint32_t reserve_slot();
+    uint32_t active_slot() const;
+    void set_active_slot(uint32_t slot);
+    size_t pending_responses() const;
+    bool write_response(uint32_t slot, const std::string& response);
+
+    // As above, with the header for the body formatted in place if in order.
+    // The body is compressed with the negotiated coding if worthwhile, and
+    // a large body is streamed (as by write_stream) rather than buffered.
+    bool write_response(uint32_t slot, protocol_status status,
+        const std::string& body);
+
+    // The compressor is owned by the manager (null disables compression)
+    // and the coding is negotiated by each request, so is kept for its slot
+    // (or stream) until the response is written.
+    void set_compressor(http::compressor* compressor);
+    void set_content_coding(uint32_t slot, content_coding coding);
+    content_coding coding(uint32_t slot) const;
+
+    // The websocket compressor is owned by the manager (null disables
+    // compression) and the parameters are negotiated by the upgrade.
+    // Messages are then compressed on write if worthwhile.
+    void set_websocket_deflate(http::websocket_deflate* deflate,
+        const websocket_deflate::parameters& agreed);
+    websocket_deflate::session& deflate_session();
+
+    // A streamed response body is pulled from the producer in pieces as the
+    // connection drains and written with chunked transfer encoding. The
+    // producer appends the next piece and returns false after the last.
+    // HTTP/2 frames its own DATA, and HTTP/1.0 cannot be chunked, so there
+    // the pieces are sent as one body (with a length, the header is unused).
+    typedef std::function<bool(std::string& piece)> producer;
+
+    bool write_stream(uint32_t slot, const std::string& header,
+        producer next);
+
+    // Write an event to the event stream as one chunk (unframed if not
+    // chunked, the stream is then delimited by close). Ids must increase,
+    // an event that is not beyond the last written (replayed) is ignored.
+    bool write_event(uint64_t id, const std::string& data);
+    bool streaming() const;
+
+    // Pull pieces (or HTTP/2 frames) until the write buffer reaches the
+    // given size.
+    bool continue_stream(size_t high_water);
+
     // Other.
     // ------------------------------------------------------------------------
 
@@ -115,7 +256,15 @@ public:
     bool ssl_enabled() const;
 
     http::file_transfer& file_transfer();
-    http::websocket_transfer& websocket_transfer();
+
+    // Decoding state of a websocket frame partially held in the input.
+    http::websocket_decoder& websocket_decoder();
+
+    // Fragments of the websocket message being received.
+    http::websocket_assembler& websocket_assembler();
+
+    // Server ping state and round trip time of a websocket connection.
+    http::websocket_keepalive& keepalive();
 
     // Operator overloads.
     // ------------------------------------------------------------------------
@@ -123,6 +272,27 @@ public:
     bool operator==(const connection& other);
 
 private:
+    // A websocket frame awaiting write, the offset spans header and payload.
+    struct queued_frame
+    {
+        websocket_frame::header_buffer header;
+        size_t header_length;
+        shared_payload payload;
+        size_t offset;
+    };
+
+    bool advance();
+    bool write_chunk(const std::string& piece);
+    bool write_piece(const std::string& piece);
+    bool queue_stream(uint32_t slot, const std::string& header,
+        producer next);
+    bool queue_frame(const shared_payload& payload, websocket_op code,
+        bool compressed);
+    bool drop_frame(size_t length, websocket_op code);
+    void consume(size_t written);
+    void account();
+    int32_t write_once(const uint8_t* data, size_t length);
+
     void* user_data_;
     connection_state state_;
     sock_t socket_;
@@ -131,16 +301,47 @@ private:
     ssl ssl_context_;
     std::string uri_;
     bool websocket_;
+    std::string websocket_protocol_;
     bool json_rpc_;
+    bool event_stream_;
+    bool keep_alive_;
+    double protocol_version_;
+    http::compressor* compressor_;
+    std::map<uint32_t, content_coding> codings_;
+    http::websocket_deflate* deflate_;
+    websocket_deflate::session deflate_session_;
+
+    // Response sequencing state, only accessed on the manager thread.
+    uint32_t next_slot_;
+    uint32_t write_slot_;
+    uint32_t active_slot_;
+    std::map<uint32_t, std::string> responses_;
+    std::map<uint32_t, std::pair<std::string, producer>> streams_;
+    producer stream_;
+    std::unique_ptr<http2_session> http2_;
+    uint64_t last_event_id_;
 
     // Transfer states used for read continuations, particularly for when the
     // read_buffer_ size is too small to hold all of the incoming data.
     http::file_transfer file_transfer_;
-    http::websocket_transfer websocket_transfer_;
+    http::websocket_decoder websocket_decoder_;
+    http::websocket_assembler websocket_assembler_;
+    http::websocket_keepalive keepalive_;
 
     int32_t bytes_read_;
     http::read_buffer read_buffer_;
     system::data_chunk write_buffer_;
+
+    // Frames queued behind the write buffer, and their unwritten bytes.
+    // Nothing is appended to the write buffer while frames are queued.
+    std::deque<queued_frame> frames_;
+    size_t queued_;
+    size_t dropped_;
+    counter_ptr outbound_;
+    size_t accounted_;
+    size_t held_;
+    system::data_chunk input_buffer_;
+    http::http_parser parser_;
 };
 
 } // namespace http
@@ -35,7 +35,8 @@ enum class event : uint8_t
     closing,
     websocket_frame,
     websocket_control_frame,
-    json_rpc
+    json_rpc,
+    event_stream
 };
 
 } // namespace http
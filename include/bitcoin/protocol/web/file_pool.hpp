@@ -0,0 +1,77 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_PROTOCOL_WEB_FILE_POOL_HPP
+#define LIBBITCOIN_PROTOCOL_WEB_FILE_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <bitcoin/system.hpp>
+#include <bitcoin/protocol/define.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+// Small fixed pool of threads for blocking file system work (open, stat and
+// read), so that a cold or busy disk never stalls the manager thread. Jobs
+// run in the order posted and post their own completions back to the
+// manager (via manager::execute). Threads are started by the first post.
+class BCP_API file_pool
+  : system::noncopyable
+{
+public:
+    typedef std::function<void()> job;
+
+    static constexpr size_t default_threads = 2;
+
+    file_pool(size_t threads=default_threads);
+    ~file_pool();
+
+    // False if the pool has been stopped.
+    bool post(job work);
+
+    // Joins the threads, jobs not yet started are discarded.
+    void stop();
+
+    // Jobs posted and not yet started.
+    size_t pending() const;
+
+private:
+    typedef std::shared_ptr<system::asio::thread> thread_ptr;
+
+    void run();
+
+    const size_t threads_;
+    bool stopped_;
+    std::deque<job> jobs_;
+    std::vector<thread_ptr> workers_;
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+};
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
+
+#endif
@@ -20,19 +20,45 @@
 #define LIBBITCOIN_PROTOCOL_WEB_FILE_TRANSFER_HPP
 
 #include <cstddef>
-#include <iostream>
+#include <deque>
+#include <string>
+#include <vector>
 #include <bitcoin/protocol/define.hpp>
 
 namespace libbitcoin {
 namespace protocol {
 namespace http {
 
+struct BCP_API byte_range
+{
+    size_t offset;
+    size_t length;
+};
+
+typedef std::vector<byte_range> byte_range_list;
+
+// A part of a multipart/byteranges response, the preamble (boundary and part
+// headers) is buffered before the range of the file is sent.
+struct BCP_API file_part
+{
+    std::string preamble;
+    byte_range range;
+};
+
+// The descriptor is a file descriptor (CRT on Windows), the offset is the
+// next byte of the file to send and the transfer (or part) ends before end.
+// Remaining parts follow in order and the trailer is buffered after the last.
+// While pending, file pool work for the connection (an open or a read) is
+// outstanding and owns the descriptor.
 struct BCP_API file_transfer
 {
     bool in_progress;
-    FILE* descriptor;
+    bool pending;
+    int descriptor;
     size_t offset;
-    size_t length;
+    size_t end;
+    std::deque<file_part> parts;
+    std::string trailer;
 };
 
 } // namespace http
@@ -0,0 +1,90 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_PROTOCOL_WEB_HPACK_HPP
+#define LIBBITCOIN_PROTOCOL_WEB_HPACK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+#include <bitcoin/system.hpp>
+#include <bitcoin/protocol/define.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+// HTTP/2 header compression (RFC 7541). The decoder maintains the dynamic
+// table of one connection direction, so every header block received on the
+// connection must be decoded in order. The encoder emits only static table
+// references and literals without indexing, so it has no state.
+class BCP_API hpack
+{
+public:
+    typedef std::pair<std::string, std::string> header;
+    typedef std::vector<header> header_list;
+
+    static constexpr size_t default_table_size = 4096;
+
+    // Decoded header list size (names, values and 32 bytes per field, as
+    // RFC 7540 section 6.5.2), comparable to the HTTP/1 header limit.
+    static constexpr size_t default_list_size = 16384;
+
+    hpack(size_t maximum_table_size=default_table_size,
+        size_t maximum_list_size=default_list_size);
+
+    // Decode a complete header block, false indicates a compression error or
+    // a list beyond the maximum size (the connection must then be closed, as
+    // the dynamic table is incomplete). Names are not validated.
+    bool decode(header_list& out, const uint8_t* data, size_t size);
+
+    // Size of the dynamic table entries (RFC 7541 section 4.1).
+    size_t table_size() const;
+
+    static void encode(system::data_chunk& out, const header_list& headers);
+
+    // Primitives (RFC 7541 section 5).
+    static void encode_integer(system::data_chunk& out, size_t value,
+        uint8_t prefix_bits, uint8_t flags);
+    static bool decode_integer(size_t& out, const uint8_t*& it,
+        const uint8_t* end, uint8_t prefix_bits);
+    static bool decode_huffman(std::string& out, const uint8_t* data,
+        size_t size);
+
+private:
+    bool decode_string(std::string& out, const uint8_t*& it,
+        const uint8_t* end);
+    bool find(header& out, size_t index) const;
+    void insert(const header& entry);
+    void evict(size_t maximum);
+
+    const size_t maximum_table_size_;
+    const size_t maximum_list_size_;
+    size_t table_limit_;
+    size_t table_size_;
+    std::deque<header> table_;
+};
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
+
+#endif
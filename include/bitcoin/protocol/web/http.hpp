@@ -27,6 +27,8 @@
 
 // Centrally including headers here.
 #ifdef _MSC_VER
+    #include <fcntl.h>
+    #include <io.h>
     #include <process.h>
     #include <strsafe.h>
     #include <windows.h>
@@ -34,6 +36,7 @@
     #include <ws2tcpip.h>
 #else
     #include <arpa/inet.h>
+    #include <fcntl.h>
     #include <netdb.h>
     #include <netinet/in.h>
     #include <unistd.h>
@@ -61,9 +64,11 @@ namespace http {
     typedef SOCKET sock_t;
     typedef uint32_t in_addr_t;
     #define CLOSE_SOCKET closesocket
+    #define CLOSE_FILE _close
 #else
     typedef uint32_t sock_t;
     #define CLOSE_SOCKET ::close
+    #define CLOSE_FILE ::close
 #endif
 
 #ifdef WITH_MBEDTLS
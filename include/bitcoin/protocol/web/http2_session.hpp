@@ -0,0 +1,180 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_PROTOCOL_WEB_HTTP2_SESSION_HPP
+#define LIBBITCOIN_PROTOCOL_WEB_HTTP2_SESSION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include <bitcoin/system.hpp>
+#include <bitcoin/protocol/define.hpp>
+#include <bitcoin/protocol/web/hpack.hpp>
+#include <bitcoin/protocol/web/http_request.hpp>
+#include <bitcoin/protocol/web/protocol_status.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+// Server side of an HTTP/2 connection (RFC 7540), after the client preface
+// has been recognized. Received frames produce complete stream requests and
+// any control frames in reply, and responses are framed into DATA as the
+// peer's flow control windows allow. Only accessed on the manager thread.
+class BCP_API http2_session
+  : system::noncopyable
+{
+public:
+    enum class frame_type : uint8_t
+    {
+        data = 0x0,
+        headers = 0x1,
+        priority = 0x2,
+        rst_stream = 0x3,
+        settings = 0x4,
+        push_promise = 0x5,
+        ping = 0x6,
+        goaway = 0x7,
+        window_update = 0x8,
+        continuation = 0x9
+    };
+
+    enum class error : uint32_t
+    {
+        no_error = 0x0,
+        protocol_error = 0x1,
+        internal_error = 0x2,
+        flow_control_error = 0x3,
+        settings_timeout = 0x4,
+        stream_closed = 0x5,
+        frame_size_error = 0x6,
+        refused_stream = 0x7,
+        cancel = 0x8,
+        compression_error = 0x9,
+        connect_error = 0xa,
+        enhance_your_calm = 0xb,
+        inadequate_security = 0xc,
+        http_1_1_required = 0xd
+    };
+
+    struct stream_request
+    {
+        uint32_t stream;
+        http_request request;
+    };
+
+    typedef std::vector<stream_request> request_list;
+
+    static const std::string preface;
+    static constexpr size_t frame_header_size = 9;
+    static constexpr uint32_t default_window_size = 65535;
+    static constexpr uint32_t default_frame_size = 16384;
+    static constexpr uint32_t default_concurrent_streams = 100;
+
+    // True if the data is (or may yet become) the client connection preface.
+    static bool match_preface(const uint8_t* data, size_t size);
+
+    http2_session(size_t maximum_body,
+        uint32_t concurrent_streams=default_concurrent_streams);
+
+    // Consume complete frames from the input, appending completed requests
+    // and writing replies (settings, acknowledgements, window updates and
+    // stream resets) to the output. False indicates a connection error, for
+    // which GOAWAY has been written and the connection must then be closed.
+    bool receive(request_list& out, system::data_chunk& input,
+        system::data_chunk& output);
+
+    // Queue the response to a completed request, ignored if the stream has
+    // since been reset. The content length field is added.
+    void respond(uint32_t stream, protocol_status status,
+        const hpack::header_list& fields, const std::string& body);
+
+    // Write queued frames, with DATA limited by the flow control windows,
+    // until the output reaches the given size.
+    void flush(system::data_chunk& output, size_t high_water);
+
+    // True if queued frames can be written now.
+    bool writable() const;
+
+    // True once GOAWAY has been sent or received.
+    bool closing() const;
+
+    size_t streams() const;
+
+    static void write_frame(system::data_chunk& out, frame_type type,
+        uint8_t flags, uint32_t stream, const uint8_t* payload, size_t size);
+
+private:
+    struct stream_state
+    {
+        int64_t send_window;
+        bool remote_closed;
+        bool responded;
+        system::data_chunk body;
+        hpack::header_list headers;
+        std::string response;
+        size_t sent;
+
+        // Reset after its request was dispatched, the response is dropped.
+        bool cancelled;
+    };
+
+    typedef std::map<uint32_t, stream_state> stream_map;
+
+    bool handle_frame(request_list& out, uint8_t type, uint8_t flags,
+        uint32_t stream, const uint8_t* payload, size_t size);
+    bool handle_data(request_list& out, uint8_t flags, uint32_t stream,
+        const uint8_t* payload, size_t size);
+    bool handle_headers(request_list& out, uint8_t flags, uint32_t stream,
+        const uint8_t* payload, size_t size);
+    bool handle_continuation(request_list& out, uint8_t flags,
+        uint32_t stream, const uint8_t* payload, size_t size);
+    bool handle_settings(uint8_t flags, uint32_t stream,
+        const uint8_t* payload, size_t size);
+    bool handle_window_update(uint32_t stream, const uint8_t* payload,
+        size_t size);
+    bool end_headers(request_list& out, uint32_t stream, bool end_stream);
+    void complete(request_list& out, stream_map::iterator it);
+    void reset(uint32_t stream, error code);
+    void close(uint32_t stream);
+    bool fail(error code);
+
+    const size_t maximum_body_;
+    const uint32_t concurrent_streams_;
+    bool preface_received_;
+    bool closing_;
+    uint32_t last_stream_;
+    uint32_t continuation_stream_;
+    bool continuation_end_stream_;
+    uint32_t cancellations_;
+    uint32_t peer_frame_size_;
+    int64_t peer_window_size_;
+    int64_t send_window_;
+    system::data_chunk header_block_;
+    system::data_chunk replies_;
+    hpack decoder_;
+    stream_map streams_;
+};
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
+
+#endif
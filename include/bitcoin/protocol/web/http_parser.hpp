@@ -0,0 +1,145 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_PROTOCOL_WEB_HTTP_PARSER_HPP
+#define LIBBITCOIN_PROTOCOL_WEB_HTTP_PARSER_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <boost/utility/string_view.hpp>
+#include <bitcoin/protocol/define.hpp>
+#include <bitcoin/protocol/web/http_request.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+// Resumable HTTP/1.1 request parser. Each call to parse is given the entire
+// input accumulated so far (starting at the first byte of the request), and
+// scanning resumes where the previous call stopped. Only offsets are stored,
+// so the input buffer may be reallocated between calls. Views returned by
+// the accessors refer to the buffer passed to the most recent parse call and
+// are invalidated when that buffer is modified. No allocation is performed.
+class BCP_API http_parser
+{
+public:
+    typedef boost::string_view string_view;
+
+    static constexpr size_t maximum_headers = 64;
+    static constexpr size_t maximum_header_length = 8 * 1024;
+
+    enum class result
+    {
+        incomplete,
+        complete,
+        error
+    };
+
+    http_parser();
+
+    // Parse from the start of the request, resuming any previous progress.
+    result parse(const uint8_t* data, size_t size);
+
+    // Clear state in preparation for the next request.
+    void reset();
+
+    // Headers parsed so far are available before the request is complete.
+    bool headers_complete() const;
+
+    // A complete request has been parsed (and not yet reset).
+    bool complete() const;
+
+    string_view method() const;
+    string_view target() const;
+    string_view path() const;
+    string_view query() const;
+    string_view protocol() const;
+
+    // The minor version of HTTP/1.x (HTTP/1.0 is 0, HTTP/1.1 is 1).
+    uint8_t minor_version() const;
+
+    size_t header_count() const;
+    string_view header_name(size_t index) const;
+    string_view header_value(size_t index) const;
+
+    // Case insensitive lookup of the first matching header.
+    string_view header(const string_view& name) const;
+
+    // Size of the request line and headers, including the empty line.
+    size_t header_length() const;
+    size_t content_length() const;
+
+    // Size of the complete request, header and content.
+    size_t message_length() const;
+    string_view body() const;
+
+    // Populate the legacy request representation (allocates).
+    bool to_request(http_request& out) const;
+
+private:
+    enum class state
+    {
+        request_line,
+        headers,
+        body,
+        complete,
+        error
+    };
+
+    struct span
+    {
+        size_t offset;
+        size_t length;
+    };
+
+    struct field
+    {
+        span name;
+        span value;
+    };
+
+    string_view view(const span& value) const;
+    bool parse_request_line(size_t begin, size_t end);
+    bool parse_header_line(size_t begin, size_t end);
+    bool parse_content_length();
+    result fail();
+
+    const char* data_;
+    size_t size_;
+    size_t position_;
+    state state_;
+
+    span method_;
+    span target_;
+    span path_;
+    span query_;
+    span protocol_;
+    uint8_t minor_version_;
+
+    size_t header_count_;
+    std::array<field, maximum_headers> headers_;
+    size_t header_length_;
+    size_t content_length_;
+};
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
+
+#endif
@@ -21,6 +21,7 @@
 
 #include <string>
 #include <unordered_map>
+#include <bitcoin/system.hpp>
 #include <bitcoin/protocol/define.hpp>
 #include <bitcoin/protocol/web/http.hpp>
 #include <bitcoin/protocol/web/protocol_status.hpp>
@@ -37,8 +38,29 @@ public:
     static std::string generate(protocol_status status,
         const std::string& mime_type, size_t content_length, bool keep_alive);
 
+    // Append the header of generate to the buffer without allocating (other
+    // than to grow the buffer). The Date line is cached once per second.
+    static void write(system::data_chunk& out, protocol_status status,
+        const std::string& mime_type, size_t content_length, bool keep_alive);
+
+    // Generate a header with pre-encoded fields (each CRLF terminated)
+    // following the status, Date and Connection lines.
+    static std::string generate(protocol_status status,
+        const std::string& fields, bool keep_alive);
+
+    // Append a header with pre-encoded fields (each CRLF terminated)
+    // following the status, Date and Connection lines.
+    static void write(system::data_chunk& out, protocol_status status,
+        const std::string& fields, bool keep_alive);
+
+    // The body must follow in chunks, which requires an HTTP/1.1 client.
+    static std::string generate_chunked(protocol_status status,
+        const std::string& mime_type, bool keep_alive);
+
+    // Protocol is the agreed subprotocol and extensions the agreed
+    // Sec-WebSocket-Extensions value, each omitted if empty.
     static std::string generate_upgrade(const std::string& key_response,
-        const std::string& protocol);
+        const std::string& protocol, const std::string& extensions={});
 
     protocol_status status;
     string_map headers;
@@ -0,0 +1,113 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_PROTOCOL_WEB_LOOP_MONITOR_HPP
+#define LIBBITCOIN_PROTOCOL_WEB_LOOP_MONITOR_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/system.hpp>
+#include <bitcoin/protocol/define.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+// Records event loop cost on the manager thread. Readers may sample the
+// histograms from any thread (values are individually atomic).
+class BCP_API loop_monitor
+  : system::noncopyable
+{
+public:
+    typedef system::asio::steady_clock clock;
+    typedef system::asio::microseconds microseconds;
+    typedef system::asio::milliseconds milliseconds;
+
+    // Log2 bucketed histogram, bucket N counts values in [2^(N-1), 2^N).
+    class BCP_API histogram
+      : system::noncopyable
+    {
+    public:
+        static constexpr size_t buckets = 40;
+
+        histogram();
+
+        void record(uint64_t value);
+        void reset();
+
+        uint64_t count() const;
+        uint64_t total() const;
+        uint64_t maximum() const;
+        uint64_t bucket(size_t index) const;
+
+        // Upper bound of the bucket containing the given percentile (0-100).
+        uint64_t percentile(double percent) const;
+
+    private:
+        std::array<std::atomic<uint64_t>, buckets> counts_;
+        std::atomic<uint64_t> count_;
+        std::atomic<uint64_t> total_;
+        std::atomic<uint64_t> maximum_;
+    };
+
+    loop_monitor();
+
+    // An iteration that spends longer than the budget handling events (time
+    // waiting in select is excluded) is logged (zero disables).
+    void set_budget(const milliseconds& budget);
+    milliseconds budget() const;
+
+    // Called by the manager at the end of each run_once iteration.
+    void record_iteration(const microseconds& total,
+        const microseconds& polling, size_t events);
+
+    // Called by the manager as each queued task is run.
+    void record_queue_latency(const microseconds& latency);
+
+    // Called by the manager as each websocket pong is matched to its ping.
+    void record_round_trip(const microseconds& round_trip);
+
+    void reset();
+
+    // Values in microseconds.
+    const histogram& iterations() const;
+    const histogram& polling() const;
+    const histogram& handling() const;
+    const histogram& queue_latency() const;
+    const histogram& round_trips() const;
+
+    // Values in events per iteration.
+    const histogram& events() const;
+
+private:
+    std::atomic<int64_t> budget_;
+    histogram iterations_;
+    histogram polling_;
+    histogram handling_;
+    histogram queue_latency_;
+    histogram round_trips_;
+    histogram events_;
+};
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
+
+#endif
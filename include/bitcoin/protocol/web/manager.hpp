@@ -23,18 +23,29 @@
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <ctime>
 #include <string>
 #include <vector>
 #include <boost/filesystem.hpp>
 #include <bitcoin/system.hpp>
 #include <bitcoin/protocol/define.hpp>
+#include <bitcoin/protocol/web/asset_cache.hpp>
 #include <bitcoin/protocol/web/bind_options.hpp>
+#include <bitcoin/protocol/web/buffer_pool.hpp>
+#include <bitcoin/protocol/web/compressor.hpp>
 #include <bitcoin/protocol/web/connection.hpp>
+#include <bitcoin/protocol/web/file_pool.hpp>
 #include <bitcoin/protocol/web/http.hpp>
 #include <bitcoin/protocol/web/http_reply.hpp>
 #include <bitcoin/protocol/web/http_request.hpp>
+#include <bitcoin/protocol/web/loop_monitor.hpp>
+#include <bitcoin/protocol/web/route_table.hpp>
+#include <bitcoin/protocol/web/utf8_validator.hpp>
 #include <bitcoin/protocol/web/utilities.hpp>
+#include <bitcoin/protocol/web/websocket_assembler.hpp>
+#include <bitcoin/protocol/web/websocket_deflate.hpp>
 #include <bitcoin/protocol/web/websocket_frame.hpp>
+#include <bitcoin/protocol/web/websocket_mask.hpp>
 #include <bitcoin/protocol/web/websocket_message.hpp>
 #include <bitcoin/protocol/web/websocket_op.hpp>
 
@@ -67,6 +78,22 @@ public:
     typedef std::shared_ptr<manager> ptr;
     typedef std::function<void()> handler;
     typedef std::vector<std::string> origin_list;
+    typedef std::vector<std::string> protocol_list;
+    typedef std::function<size_t()> pending_counter;
+
+    static constexpr size_t default_websocket_limit = 64 * 1024;
+
+    // Admission control applied before accepting, zero disables a limit.
+    struct admission_limits
+    {
+        size_t connections;
+        size_t pending_queries;
+        size_t outbound_bytes;
+
+        // Reply 503 and close when over limit, otherwise leave the
+        // connection in the listen backlog until load subsides.
+        bool reject;
+    };
 
     manager(bool ssl, event_handler handler, path document_root,
         const origin_list origins);
@@ -85,6 +112,17 @@ public:
     void add_connection(connection_ptr connection);
     void remove_connection(connection_ptr connection);
     size_t connection_count() const;
+    size_t outbound_bytes() const;
+
+    // Broadcast frames dropped for slow consumers, by all connections.
+    size_t dropped_frames() const;
+
+    // The pending counter is invoked on the manager thread.
+    void set_admission_limits(const admission_limits& limits,
+        pending_counter pending_queries);
+
+    // A new connection is within the admission limits.
+    bool admit() const;
 
     bool ssl() const;
     bool listening() const;
@@ -98,10 +136,71 @@ public:
     void execute(task_ptr task);
     void run_tasks();
 
+    // Write the text message to each of the websocket connections, sharing
+    // one copy of its payload, and compressing it once for those that agreed
+    // to compression without context takeover (manager thread only). The
+    // message is dropped for any connection that is at high water.
+    void broadcast(const connection_list& connections,
+        const std::string& message);
+
     void poll(size_t timeout_milliseconds);
     bool handle_connection(connection_ptr connection, event current_event);
 
+    // Event loop cost histograms, may be sampled from any thread.
+    loop_monitor& monitor();
+
+    // Static file cache, configure before start (manager thread only).
+    asset_cache& assets();
+
+    // In process request handlers, which take precedence over JSON-RPC and
+    // static files, configure before start (manager thread only).
+    route_table& routes();
+
+    // Response compression level (zero disables) and minimum body size,
+    // configure before start.
+    void set_compression(int32_t level, size_t threshold);
+
+    // Largest websocket message (after reassembly of its fragments) accepted
+    // on each connection, configure before start.
+    void set_websocket_limit(size_t bytes);
+
+    // Websocket message compression (permessage-deflate) level (zero
+    // disables), largest window and whether compression context is kept
+    // between messages (more memory per connection), configure before start.
+    void set_websocket_compression(int32_t level, size_t window_bits,
+        bool context_takeover);
+
+    // Ping websocket connections at the interval (zero disables) and close
+    // those that miss the given number of pongs in a row (zero never closes),
+    // configure before start. Round trips are recorded by the monitor.
+    void set_websocket_keepalive(const system::asio::seconds& interval,
+        size_t missed_pongs);
+
+    // Websocket subprotocols that may be agreed on upgrade, the first offered
+    // by the client that is supported is agreed, configure before start.
+    void set_websocket_protocols(const protocol_list& protocols);
+
 private:
+    struct queued_task
+    {
+        task_ptr task;
+        loop_monitor::clock::time_point queued;
+    };
+
+    typedef std::vector<queued_task> queued_task_list;
+
+    // A file resolved on the file pool, read into an asset or else opened
+    // for transfer (the descriptor is negative if it could not be).
+    struct file_result
+    {
+        bool found;
+        asset_cache::ptr asset;
+        int descriptor;
+        size_t size;
+        std::time_t modified;
+        std::string mime_type;
+    };
+
 #ifdef WITH_MBEDTLS
     // Passed to mbedtls for internal use only.
     static int32_t ssl_send(void* data, const uint8_t* buffer, size_t length);
@@ -111,13 +210,42 @@ private:
     void run_once();
     void select(size_t timeout_milliseconds, connection_list& sockets);
     bool transfer_file_data(connection_ptr connection);
-    bool send_http_file(connection_ptr connection, const path& path, bool keep_alive);
+    bool read_file_data(connection_ptr connection, size_t amount);
+    bool complete_read(connection_ptr connection,
+        const system::data_chunk& data);
+    void resolve_file(connection_ptr connection, const http_request& request,
+        bool cacheable, uint64_t version);
+    bool complete_file(connection_ptr connection, const http_request& request,
+        const file_result& file, uint64_t version);
+    bool send_http_file(connection_ptr connection, const file_result& file,
+        const http_request& request);
     bool handle_websocket(connection_ptr connection);
+    bool handle_websocket_frame(connection_ptr connection,
+        const websocket_frame& frame, const uint8_t* payload);
+    bool handle_websocket_data(connection_ptr connection, uint8_t flags,
+        const uint8_t* data, size_t size);
+    bool handle_websocket_message(connection_ptr connection, uint8_t flags,
+        websocket_op code, const uint8_t* data, size_t size);
+    shared_payload compressed_payload(
+        const websocket_deflate::parameters& agreed,
+        const std::string& message);
+    void close_websocket(connection_ptr connection, uint16_t status);
+    void ping_websockets(loop_monitor::clock::time_point now);
+    bool handle_requests(connection_ptr connection);
+    bool handle_http2(connection_ptr connection);
     bool send_response(connection_ptr connection, const http_request& request);
+    bool send_asset(connection_ptr connection, const http_request& request,
+        const asset_cache::asset& asset);
     bool send_generated_reply(connection_ptr connection, protocol_status status);
+    bool send_route(connection_ptr connection, const http_request& request,
+        const route_table::handler* route,
+        const route_table::parameter_map& parameters,
+        const std::string& allowed);
     bool upgrade_connection(connection_ptr connection, const http_request& request);
+    bool start_event_stream(connection_ptr connection, http_request& request);
     bool validate_origin(const std::string& origin);
     bool initialize_ssl(connection_ptr connection, bool listener);
+    void shed(sock_t socket);
 
     // These are thread safe.
     const bool ssl_;
@@ -139,13 +267,35 @@ private:
     connection_list connections_;
     connection_ptr listener_;
     sockaddr_in listener_address_;
+    admission_limits limits_;
+    pending_counter pending_queries_;
+
+    // These are only accessed on the manager thread.
+    size_t events_;
+    connection::counter_ptr outbound_bytes_;
+    size_t dropped_frames_;
+    loop_monitor::microseconds polling_;
+    loop_monitor monitor_;
+    http::compressor compressor_;
+    asset_cache assets_;
+    route_table routes_;
+    size_t websocket_limit_;
+    buffer_pool websocket_buffers_;
+    websocket_deflate deflate_;
+    system::asio::duration ping_interval_;
+    size_t missed_pongs_;
+    loop_monitor::clock::time_point keepalive_sweep_;
+    protocol_list websocket_protocols_;
 
     // This is protected by mutex.
-    task_list tasks_;
+    queued_task_list tasks_;
     system::shared_mutex task_mutex_;
 
     const origin_list origins_;
     std::string page_data_;
+
+    // Stopped first on destruction, since its jobs use the above.
+    file_pool files_;
 };
 
 } // namespace http
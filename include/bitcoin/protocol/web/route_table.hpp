@@ -0,0 +1,98 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_PROTOCOL_WEB_ROUTE_TABLE_HPP
+#define LIBBITCOIN_PROTOCOL_WEB_ROUTE_TABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+#include <bitcoin/protocol/define.hpp>
+#include <bitcoin/protocol/web/connection.hpp>
+#include <bitcoin/protocol/web/http.hpp>
+#include <bitcoin/protocol/web/http_request.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+// Request handlers served in process by method and path pattern, without
+// file system access. A pattern is a path in which any segment may instead
+// be a parameter (":name") that captures the segment of a request path, as
+// in "/v1/block/:height/header". Patterns are held in a compressed (radix)
+// trie and static segments take precedence over parameters. A parameter is
+// tried where the static branch fails to match the rest of the path, so a
+// path is matched in time proportional to its length, except that each
+// segment with both a static and a parameter branch can double the work.
+class BCP_API route_table
+{
+public:
+    typedef string_map parameter_map;
+
+    // The handler answers the connection's active slot, immediately or later
+    // on the manager thread (via manager::execute). False closes the
+    // connection.
+    typedef std::function<bool(connection_ptr connection,
+        const http_request& request, const parameter_map& parameters)>
+            handler;
+
+    route_table();
+
+    // False if the pattern is invalid, its parameter names conflict with a
+    // pattern already added, or the method is already routed at the pattern.
+    bool add(const std::string& method, const std::string& pattern,
+        handler target);
+
+    bool empty() const;
+
+    // The handler of the method at the path, null if not routed. Parameters
+    // captured by the matched pattern are added. If the path is matched but
+    // not the method, allowed lists the methods of the path (comma separated
+    // and upper case, as in an Allow header), otherwise it is empty.
+    const handler* find(parameter_map& parameters, std::string& allowed,
+        const std::string& method, const std::string& path) const;
+
+private:
+    typedef std::vector<std::pair<std::string, handler>> method_list;
+
+    // A static node matches its label, a parameter node one segment. Nodes
+    // refer to each other by index into the table, the first is the root.
+    struct node
+    {
+        std::string label;
+        std::string name;
+        std::vector<uint32_t> children;
+        uint32_t parameter;
+        method_list methods;
+    };
+
+    uint32_t insert(uint32_t parent, const std::string& label);
+    uint32_t match(uint32_t index, const std::string& path, size_t offset,
+        parameter_map& parameters) const;
+
+    std::vector<node> nodes_;
+};
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
+
+#endif
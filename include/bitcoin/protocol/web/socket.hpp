@@ -21,6 +21,7 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <string>
@@ -32,12 +33,15 @@
 #include <bitcoin/protocol.hpp>
 #include <bitcoin/protocol/define.hpp>
 #include <bitcoin/protocol/zmq/worker.hpp>
+#include <bitcoin/protocol/web/binary_query.hpp>
 #include <bitcoin/protocol/web/connection.hpp>
 #include <bitcoin/protocol/web/event.hpp>
 #include <bitcoin/protocol/web/http.hpp>
 #include <bitcoin/protocol/web/http_reply.hpp>
 #include <bitcoin/protocol/web/json_string.hpp>
 #include <bitcoin/protocol/web/manager.hpp>
+#include <bitcoin/protocol/web/route_table.hpp>
+#include <bitcoin/protocol/web/subscription_index.hpp>
 #include <bitcoin/protocol/web/utilities.hpp>
 #include <bitcoin/protocol/web/websocket_message.hpp>
 
@@ -84,6 +88,12 @@ public:
         connection_ptr connection;
         std::string command;
         std::string arguments;
+
+        // Response order of a pipelined JSON-RPC request.
+        uint32_t slot;
+
+        // Sent with the binary subprotocol, the response is not decoded.
+        bool binary;
     };
 
     typedef std::unordered_map<uint32_t, std::pair<connection_ptr, uint32_t>>
@@ -105,10 +115,13 @@ public:
     bool send_query_responses();
 
     size_t connection_count() const;
+    size_t pending_query_count() const;
     void add_connection(connection_ptr connection);
     void remove_connection(connection_ptr connection);
     void notify_query_work(connection_ptr connection,
         const std::string& method, uint32_t id, const std::string& parameters);
+    void notify_binary_query(connection_ptr connection,
+        const binary_query& query);
 
 protected:
     // Initialize the websocket event loop and start a thread to poll events.
@@ -123,12 +136,35 @@ protected:
     virtual const system::config::endpoint& websocket_endpoint() const = 0;
     virtual const std::shared_ptr<bc::protocol::zmq::socket> service() const;
 
-    // Send a message to the websocket client.
+    // Response compression level of this endpoint (zero disables).
+    virtual int32_t compression_level() const;
+
+    // Send a message to the websocket, JSON-RPC or event stream client.
     void send(connection_ptr connection, const std::string& json);
 
-    // Send a message to every connected websocket client.
+    // Send a JSON-RPC reply whose body is pulled from the producer as the
+    // connection drains, so it is never serialized in full. As with send,
+    // replies are made from a decode handler on the websocket thread.
+    // Websocket clients receive the pieces joined into one message.
+    void send_stream(connection_ptr connection,
+        connection::producer producer);
+
+    // Send a message to every connected websocket and event stream client
+    // (not JSON-RPC clients). Event stream clients that reconnect with a
+    // Last-Event-ID are resent recent broadcasts they missed.
     void broadcast(const std::string& json);
 
+    // Send a message to the websocket clients subscribed to the topic (see
+    // subscription_index), which subscribe with the "subscribe" method and a
+    // topic parameter, and unsubscribe with the "unsubscribe" method.
+    void publish(const std::string& topic, const std::string& json);
+
+    // Serve requests for the method at the path pattern in process (see
+    // route_table), the handler is called on the websocket thread. Routes
+    // must be added before the service is started.
+    bool route(const std::string& method, const std::string& pattern,
+        route_table::handler handler);
+
     // Optionally set a fixed reply instead of returning a 404 not found if
     // the web root cannot be found.
     void set_default_page_data(const std::string& data);
@@ -155,10 +191,31 @@ protected:
     query_correlation_map correlations_;
 
 private:
+    typedef std::deque<std::pair<uint64_t, std::string>> event_list;
+
+    // The number of recent broadcasts retained for event stream replay.
+    static constexpr size_t event_replay_limit = 256;
+
     static bool handle_event(connection_ptr connection, http::event event,
         const void* data);
 
+    void send(connection_ptr connection, const std::string& json,
+        uint64_t event_id);
+    void replay(connection_ptr connection, uint64_t last_event_id);
+    bool subscription(connection_ptr connection, const std::string& method,
+        uint32_t id, const std::string& topic);
+
     manager::ptr manager_;
+    route_table routes_;
+
+    // These are protected by mutex.
+    uint64_t event_id_;
+    event_list events_;
+    system::shared_mutex event_mutex_;
+
+    // This is protected by mutex.
+    subscription_index subscriptions_;
+    system::shared_mutex subscription_mutex_;
 
     // This is protected by mutex.
     query_response_task_list query_response_tasks_;
@@ -0,0 +1,78 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_PROTOCOL_WEB_SUBSCRIPTION_INDEX_HPP
+#define LIBBITCOIN_PROTOCOL_WEB_SUBSCRIPTION_INDEX_HPP
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <bitcoin/system.hpp>
+#include <bitcoin/protocol/define.hpp>
+#include <bitcoin/protocol/web/connection.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+// Connections subscribed to each topic, such as "address:<hash>",
+// "transaction:<hash>" or "headers", so that a notification is only sent to
+// its subscribers. Topics are opaque to the index. Each connection's topics
+// are also kept so that a closing connection is removed in proportion to its
+// subscriptions. Not thread safe.
+class BCP_API subscription_index
+  : system::noncopyable
+{
+public:
+    static constexpr size_t default_topic_limit = 1024;
+    static constexpr size_t maximum_topic_length = 128;
+
+    // The limit is the number of topics of each connection.
+    subscription_index(size_t topic_limit=default_topic_limit);
+
+    // False if the topic is empty or too long, or the limit is reached.
+    // Subscribing again to a topic is not an error.
+    bool subscribe(connection_ptr connection, const std::string& topic);
+
+    // False if the connection is not subscribed to the topic.
+    bool unsubscribe(connection_ptr connection, const std::string& topic);
+
+    // Remove all subscriptions of the connection.
+    void remove(connection_ptr connection);
+
+    // The connections subscribed to the topic.
+    connection_list subscribers(const std::string& topic) const;
+
+    size_t topics() const;
+    size_t topics(connection_ptr connection) const;
+
+private:
+    typedef std::unordered_set<connection_ptr> connection_hash_set;
+    typedef std::unordered_set<std::string> topic_set;
+
+    const size_t topic_limit_;
+    std::unordered_map<std::string, connection_hash_set> subscribers_;
+    std::unordered_map<connection_ptr, topic_set> topics_;
+};
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,77 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_PROTOCOL_WEB_UTF8_VALIDATOR_HPP
+#define LIBBITCOIN_PROTOCOL_WEB_UTF8_VALIDATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <bitcoin/protocol/define.hpp>
+#include <bitcoin/protocol/web/vector_kernel.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+// UTF-8 validation (RFC 3629) of websocket text (RFC 6455 section 8.1). The
+// AVX2 kernel validates all text a vector at a time (Keiser and Lemire's
+// lookup method), the SSE2 and NEON kernels skip ASCII a vector at a time,
+// and the scalar fallback skips ASCII a word at a time. Other text is checked
+// a character at a time. The kernel is chosen by runtime CPU detection.
+//
+// An instance validates a text given in parts, such as the frames of a
+// message as they are received, with characters split between parts.
+class BCP_API utf8_validator
+{
+public:
+    typedef vector_kernel kernel;
+
+    // The fastest kernel supported by this build and processor.
+    static kernel best();
+    static bool supported(kernel type);
+    static std::string to_string(kernel type);
+
+    // The data is entirely valid UTF-8, ending on a complete character.
+    static bool validate(const uint8_t* data, size_t size);
+
+    // As above, with the given kernel, which must be supported.
+    static bool validate(kernel type, const uint8_t* data, size_t size);
+
+    utf8_validator();
+
+    // Validate the next part of the text, false once any part is invalid.
+    bool update(const uint8_t* data, size_t size);
+
+    // The text so far is valid and does not end within a character.
+    bool complete() const;
+
+    // Start a new text.
+    void reset();
+
+private:
+    bool valid_;
+    uint8_t pending_[4];
+    size_t pending_size_;
+};
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
+
+#endif
@@ -29,6 +29,7 @@
 
 #include <boost/filesystem.hpp>
 #include <bitcoin/system.hpp>
+#include <bitcoin/protocol/web/file_transfer.hpp>
 #include <bitcoin/protocol/web/http.hpp>
 #include <bitcoin/protocol/web/http_request.hpp>
 #include <bitcoin/protocol/web/websocket_op.hpp>
@@ -67,6 +68,16 @@ BCP_API bool is_json_request(const std::string& header_value);
 BCP_API bool parse_http(http_request& out, const std::string& request);
 BCP_API std::string mime_type(const boost::filesystem::path& path);
 
+// True if the Accept-Encoding header value accepts the coding (q > 0).
+BCP_API bool accepts_encoding(const std::string& accept_encoding,
+    const std::string& coding);
+
+// Parse a Range header value (RFC 7233) against the representation size.
+// Returns false if the header is invalid (and should be ignored), otherwise
+// out holds the satisfiable ranges in request order (empty for a 416).
+BCP_API bool parse_ranges(byte_range_list& out, const std::string& header,
+    size_t size);
+
 } // namespace http
 } // namespace protocol
 } // namespace libbitcoin
@@ -16,25 +16,20 @@
  * You should have received a copy of the GNU Affero General Public License
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
-#ifndef LIBBITCOIN_PROTOCOL_WEB_WEBSOCKET_TRANSFER_HPP
-#define LIBBITCOIN_PROTOCOL_WEB_WEBSOCKET_TRANSFER_HPP
-
-#include <cstddef>
-#include <bitcoin/system.hpp>
-#include <bitcoin/protocol/define.hpp>
+#ifndef LIBBITCOIN_PROTOCOL_WEB_VECTOR_KERNEL_HPP
+#define LIBBITCOIN_PROTOCOL_WEB_VECTOR_KERNEL_HPP
 
 namespace libbitcoin {
 namespace protocol {
 namespace http {
 
-struct BCP_API websocket_transfer
+// The instruction set of a kernel with vector and scalar implementations.
+enum class vector_kernel
 {
-    bool in_progress;
-    size_t offset;
-    size_t length;
-    size_t header_length;
-    system::data_chunk mask;
-    system::data_chunk data;
+    scalar,
+    sse2,
+    avx2,
+    neon
 };
 
 } // namespace http
@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_PROTOCOL_WEB_WEBSOCKET_ASSEMBLER_HPP
+#define LIBBITCOIN_PROTOCOL_WEB_WEBSOCKET_ASSEMBLER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/system.hpp>
+#include <bitcoin/protocol/define.hpp>
+#include <bitcoin/protocol/web/buffer_pool.hpp>
+#include <bitcoin/protocol/web/websocket_op.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+// Reassembly of a websocket message sent in fragments (RFC 6455 section
+// 5.4). Only data frames are given, control frames are never fragmented and
+// may be handled between fragments. Unmasked payloads are appended to a
+// buffer taken from the pool when a message begins and returned by reset.
+class BCP_API websocket_assembler
+  : system::noncopyable
+{
+public:
+    enum class result
+    {
+        // An unfragmented message, the payload is the message.
+        single,
+
+        // The last fragment was added, the message is assembled.
+        complete,
+
+        // The fragment was added, more are required.
+        incomplete,
+
+        // A continuation without a message, or a new message before the
+        // last was completed.
+        invalid,
+
+        // The message would exceed the limit.
+        oversized
+    };
+
+    websocket_assembler();
+
+    // Add the payload of a data frame, limiting the assembled message size.
+    result append(buffer_pool& pool, uint8_t flags, const uint8_t* data,
+        size_t size, size_t limit);
+
+    // Return the buffer to the pool, abandoning any message in progress.
+    void reset(buffer_pool& pool);
+
+    bool in_progress() const;
+
+    // The message being assembled, with the flags of its first frame (and
+    // the final bit set once complete).
+    const system::data_chunk& message() const;
+    uint8_t flags() const;
+    websocket_op code() const;
+
+private:
+    bool in_progress_;
+    bool complete_;
+    uint8_t flags_;
+    system::data_chunk message_;
+};
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
+
+#endif
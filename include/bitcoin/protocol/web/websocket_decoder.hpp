@@ -0,0 +1,85 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_PROTOCOL_WEB_WEBSOCKET_DECODER_HPP
+#define LIBBITCOIN_PROTOCOL_WEB_WEBSOCKET_DECODER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <bitcoin/system.hpp>
+#include <bitcoin/protocol/define.hpp>
+#include <bitcoin/protocol/web/utf8_validator.hpp>
+#include <bitcoin/protocol/web/websocket_frame.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+// Decodes the websocket frames accumulated in a connection's input, any
+// number per read. Each complete frame is unmasked in place and passed to
+// the handler, then removed from the input. A frame with a partial header
+// or payload is left at the front of the input and decoding resumes there
+// once more is read, with payload unmasked as it arrives (so each byte is
+// unmasked once, while in cache). Uncompressed text is validated as UTF-8
+// in the same pass, across the fragments of its message. Not thread safe.
+class BCP_API websocket_decoder
+{
+public:
+    enum class result
+    {
+        // All complete frames are decoded, any remainder awaits more input.
+        incomplete,
+
+        // A frame is invalid (unmasked, or an invalid control frame).
+        invalid,
+
+        // A frame payload exceeds the limit.
+        oversized,
+
+        // A text message is not valid UTF-8 (close status 1007).
+        invalid_text,
+
+        // The handler returned false.
+        stopped
+    };
+
+    // The payload of the frame is unmasked and may be modified in place.
+    typedef std::function<bool(const websocket_frame& frame,
+        uint8_t* payload)> handler;
+
+    websocket_decoder();
+
+    // Decode the frames of the input, whose payloads are within the limit.
+    result decode(system::data_chunk& input, size_t limit,
+        const handler& handler);
+
+    // Discard the state of a partial frame and message.
+    void reset();
+
+private:
+    size_t unmasked_;
+    bool validating_;
+    utf8_validator text_;
+};
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,128 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_PROTOCOL_WEB_WEBSOCKET_DEFLATE_HPP
+#define LIBBITCOIN_PROTOCOL_WEB_WEBSOCKET_DEFLATE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <bitcoin/system.hpp>
+#include <bitcoin/protocol/define.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+// The permessage-deflate websocket extension (RFC 7692). Negotiated on
+// upgrade, after which messages may be sent and received compressed (RSV1).
+// Without context takeover the zlib state is only held for the duration of
+// a message, so streams are taken from a pool and reset on return, and idle
+// connections hold no zlib window. With context takeover each connection
+// holds its streams until closed (they are then returned to the pool). One
+// instance serves all connections of a manager (reactor) thread. Not thread
+// safe. Without zlib (WITH_ZLIB) nothing is negotiated.
+class BCP_API websocket_deflate
+  : system::noncopyable
+{
+public:
+    static constexpr size_t minimum_window_bits = 9;
+    static constexpr size_t maximum_window_bits = 15;
+    static constexpr size_t default_threshold = 128;
+
+    // The terms agreed with a client.
+    struct parameters
+    {
+        bool enabled;
+        uint8_t server_window_bits;
+        uint8_t client_window_bits;
+        bool client_window_bits_offered;
+        bool server_no_context_takeover;
+        bool client_no_context_takeover;
+    };
+
+    // zlib state, defined only with zlib.
+    struct stream;
+    struct stream_deleter
+    {
+        void operator()(stream* value) const;
+    };
+
+    typedef std::unique_ptr<stream, stream_deleter> stream_ptr;
+
+    // The state of a connection.
+    struct session
+    {
+        parameters agreed;
+        stream_ptr deflater;
+        stream_ptr inflater;
+    };
+
+    // Level is 1 (fastest) to 9 (smallest), zero disables compression.
+    websocket_deflate(int32_t level=0,
+        size_t window_bits=maximum_window_bits, bool context_takeover=false,
+        size_t threshold=default_threshold);
+
+    static bool available();
+
+    void configure(int32_t level, size_t window_bits, bool context_takeover,
+        size_t threshold=default_threshold);
+    bool enabled() const;
+
+    // Accept the first acceptable offer of a Sec-WebSocket-Extensions
+    // request header value, false if none is acceptable.
+    bool negotiate(parameters& out, const std::string& offers) const;
+
+    // The Sec-WebSocket-Extensions response header value of the agreement.
+    static std::string to_string(const parameters& agreed);
+
+    // Compress the message payload, returning the compressed payload (valid
+    // until the next call) or null if it should be sent as is.
+    const system::data_chunk* compress(session& state, const uint8_t* data,
+        size_t size);
+
+    // Decompress the message payload into out, false if the payload is
+    // invalid or would exceed the limit (the state is then discarded).
+    bool decompress(system::data_chunk& out, session& state,
+        const uint8_t* data, size_t size, size_t limit);
+
+    // Return the held streams of a closing connection to the pool.
+    void release(session& state);
+
+    // The number of streams in the pool.
+    size_t pooled() const;
+
+private:
+    stream_ptr acquire(bool deflater, size_t window_bits);
+    void recycle(stream_ptr& value);
+
+    int32_t level_;
+    size_t window_bits_;
+    bool context_takeover_;
+    size_t threshold_;
+    std::vector<stream_ptr> pool_;
+    system::data_chunk buffer_;
+};
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
+
+#endif
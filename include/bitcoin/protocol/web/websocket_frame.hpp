@@ -19,6 +19,7 @@
 #ifndef LIBBITCOIN_PROTOCOL_WEB_WEBSOCKET_FRAME_HPP
 #define LIBBITCOIN_PROTOCOL_WEB_WEBSOCKET_FRAME_HPP
 
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <bitcoin/system.hpp>
@@ -33,11 +34,27 @@ namespace http {
 class BCP_API websocket_frame
 {
 public:
-    static system::data_chunk to_header(size_t length, websocket_op code);
+    // A server frame header (unmasked) is at most two bytes and an eight
+    // byte extended length.
+    static constexpr size_t maximum_header_length = 10;
+    typedef std::array<uint8_t, maximum_header_length> header_buffer;
+
+    // Encode a server frame header into the buffer, returning its length.
+    static size_t to_header(header_buffer& out, size_t length,
+        websocket_op code, bool compressed=false);
+
+    static system::data_chunk to_header(size_t length, websocket_op code,
+        bool compressed=false);
 
     websocket_frame(const uint8_t* data, size_t size);
 
+    // The header is complete and valid (masked, with a valid length).
     operator bool() const;
+
+    // The header is entirely within the data, if not the header length is
+    // that required (or zero if not yet known).
+    bool complete() const;
+
     bool final() const;
     bool fragment() const;
     event event_type() const;
@@ -53,6 +70,7 @@ private:
     static const size_t mask_ = 4;
 
     bool valid_;
+    bool complete_;
     uint8_t flags_;
     size_t header_;
     size_t data_;
@@ -0,0 +1,80 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_PROTOCOL_WEB_WEBSOCKET_KEEPALIVE_HPP
+#define LIBBITCOIN_PROTOCOL_WEB_WEBSOCKET_KEEPALIVE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/system.hpp>
+#include <bitcoin/protocol/define.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+// Server ping state of a websocket connection. Each ping carries a sequence
+// number so that its pong can be matched, giving a round trip sample that is
+// smoothed as TCP smooths its round trip time (RFC 6298, alpha of 1/8).
+// Unanswered pings are counted so that dead peers can be closed. Manager
+// thread only.
+class BCP_API websocket_keepalive
+{
+public:
+    typedef system::asio::steady_clock clock;
+    typedef system::asio::microseconds microseconds;
+
+    static constexpr size_t payload_size = sizeof(uint64_t);
+
+    websocket_keepalive();
+
+    // Start the ping interval (at upgrade), clearing any state.
+    void start(clock::time_point now);
+
+    // True if the interval has passed since start or the last ping.
+    bool due(clock::time_point now, const clock::duration& interval) const;
+
+    // The payload of the next ping, an unanswered ping is counted missed.
+    system::data_chunk ping(clock::time_point now);
+
+    // True if the pong answers the outstanding ping, which is then sampled.
+    // Other pongs (unsolicited pongs are permitted) are ignored.
+    bool pong(const uint8_t* data, size_t size, clock::time_point now);
+
+    // Consecutive pings unanswered when the next was due.
+    size_t missed() const;
+    bool outstanding() const;
+
+    // The smoothed and the last round trip, zero until sampled.
+    microseconds round_trip() const;
+    microseconds last_round_trip() const;
+
+private:
+    uint64_t sequence_;
+    bool outstanding_;
+    size_t missed_;
+    clock::time_point sent_;
+    microseconds smoothed_;
+    microseconds sample_;
+};
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
+
+#endif
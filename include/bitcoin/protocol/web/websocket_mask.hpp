@@ -0,0 +1,62 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_PROTOCOL_WEB_WEBSOCKET_MASK_HPP
+#define LIBBITCOIN_PROTOCOL_WEB_WEBSOCKET_MASK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <bitcoin/protocol/define.hpp>
+#include <bitcoin/protocol/web/vector_kernel.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+// Websocket payload (un)masking, an XOR of the payload with the repeating
+// four byte client mask (RFC 6455 section 5.3). The payload is processed a
+// vector at a time (SSE2, AVX2 or NEON) once aligned, with the kernel chosen
+// by runtime CPU detection and a word at a time scalar fallback.
+class BCP_API websocket_mask
+{
+public:
+    static constexpr size_t mask_size = 4;
+
+    typedef vector_kernel kernel;
+
+    // The fastest kernel supported by this build and processor.
+    static kernel best();
+    static bool supported(kernel type);
+    static std::string to_string(kernel type);
+
+    // XOR the payload in place with the mask, where offset is the position
+    // of the first byte within the payload (for a payload applied in parts).
+    static void apply(uint8_t* data, size_t size, const uint8_t* mask,
+        size_t offset=0);
+
+    // As above, with the given kernel, which must be supported.
+    static void apply(kernel type, uint8_t* data, size_t size,
+        const uint8_t* mask, size_t offset=0);
+};
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
+
+#endif
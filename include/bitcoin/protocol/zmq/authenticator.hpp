@@ -47,7 +47,8 @@ public:
     static const system::config::endpoint endpoint;
 
     /// There may be only one authenticator per process.
-    authenticator(system::thread_priority priority=system::thread_priority::normal);
+    authenticator(system::thread_priority priority=system::thread_priority::normal,
+        const cpu_list& io_affinity={});
 
     /// Stop the router.
     virtual ~authenticator();
@@ -23,6 +23,7 @@
 #include <cstdint>
 #include <memory>
 #include <bitcoin/system.hpp>
+#include <bitcoin/protocol/affinity.hpp>
 #include <bitcoin/protocol/define.hpp>
 
 namespace libbitcoin {
@@ -37,8 +38,8 @@ public:
     /// A shared context pointer.
     typedef std::shared_ptr<context> ptr;
 
-    /// Construct a context.
-    context(bool started=true);
+    /// Construct a context, optionally pinning its I/O threads.
+    context(bool started=true, const cpu_list& affinity={});
 
     /// Blocks until all child sockets are closed.
     /// Stops all child socket activity by closing the zeromq context.
@@ -61,6 +62,7 @@ private:
 
     // This is thread safe
     std::atomic<void*> self_;
+    const cpu_list affinity_;
 
     // This guards against a start/stop race.
     mutable system::shared_mutex mutex_;
@@ -23,6 +23,7 @@
 #include <memory>
 #include <future>
 #include <bitcoin/system.hpp>
+#include <bitcoin/protocol/affinity.hpp>
 #include <bitcoin/protocol/define.hpp>
 #include <bitcoin/protocol/zmq/socket.hpp>
 
@@ -39,7 +40,8 @@ public:
     typedef std::shared_ptr<worker> ptr;
 
     /// Construct a worker.
-    worker(system::thread_priority priority=system::thread_priority::normal);
+    worker(system::thread_priority priority=system::thread_priority::normal,
+        const cpu_list& affinity={});
 
     /// Stop the worker.
     virtual ~worker();
@@ -67,6 +69,7 @@ private:
     std::promise<bool> finished_;
     std::shared_ptr<system::asio::thread> thread_;
     const system::thread_priority priority_;
+    const cpu_list affinity_;
     mutable system::shared_mutex mutex_;
 };
 
@@ -10,6 +10,8 @@
 # Script options:
 # --with-mbedtls          Compile with MbedTLS Support
 #                            Provides a websockets implementation for query.
+# --with-zlib             Compile with zlib Support
+#                            Provides HTTP response compression.
 # --build-boost            Builds Boost libraries.
 # --build-zmq              Builds ZeroMQ libraries.
 # --build-mbedtls          Builds MbedTLS libraries.
@@ -186,6 +188,8 @@ display_help()
     display_message "Script options:"
     display_message "  --with-mbedtls          Compile with MbedTLS Support"
     display_message "                             Provides a websockets implementation for query."
+    display_message "  --with-zlib             Compile with zlib Support"
+    display_message "                             Provides HTTP response compression."
     display_message "  --build-boost            Builds Boost libraries."
     display_message "  --build-zmq              Build ZeroMQ libraries."
     display_message "  --build-mbedtls          Builds MbedTLS libraries."
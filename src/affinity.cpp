@@ -0,0 +1,75 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/protocol/affinity.hpp>
+
+#include <cstdint>
+#include <bitcoin/system.hpp>
+
+#ifdef _MSC_VER
+    #include <windows.h>
+#elif defined(__linux__)
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+namespace libbitcoin {
+namespace protocol {
+
+using namespace bc::system;
+
+bool set_affinity(const cpu_list& cpus)
+{
+    if (cpus.empty())
+        return true;
+
+#if defined(_MSC_VER)
+    static constexpr uint32_t mask_bits = sizeof(DWORD_PTR) * 8;
+
+    DWORD_PTR mask = 0;
+    for (const auto cpu: cpus)
+    {
+        if (cpu >= mask_bits)
+            return false;
+
+        mask |= (DWORD_PTR(1) << cpu);
+    }
+
+    return ::SetThreadAffinityMask(::GetCurrentThread(), mask) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const auto cpu: cpus)
+    {
+        if (cpu >= CPU_SETSIZE)
+            return false;
+
+        CPU_SET(cpu, &set);
+    }
+
+    // Memory subsequently first-touched by this thread is placed on the
+    // NUMA node of these processors under the default kernel policy.
+    return ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0;
+#else
+    // Thread affinity is not supported on this platform (e.g. macOS).
+    return false;
+#endif
+}
+
+} // namespace protocol
+} // namespace libbitcoin
@@ -35,7 +35,23 @@ settings::settings()
     inactivity_seconds(0),
     reconnect_seconds(1),
     send_milliseconds(0),
+    worker_affinity({}),
     web_priority(false),
+    web_affinity({}),
+    web_loop_budget_milliseconds(0),
+    web_connection_limit(0),
+    web_pending_query_limit(0),
+    web_outbound_byte_limit(0),
+    web_reject_overload(false),
+    web_asset_cache_bytes(16777216),
+    web_asset_file_bytes(1048576),
+    web_compression_level(6),
+    web_compression_threshold(1024),
+    web_websocket_message_bytes(65536),
+    web_websocket_window_bits(15),
+    web_websocket_context_takeover(false),
+    web_websocket_ping_seconds(30),
+    web_websocket_missed_pongs(2),
     web_origins({}),
     web_root(""),
     web_ca_certificate(""),
@@ -53,7 +69,23 @@ settings::settings(uint32_t send_high_water, uint32_t receive_high_water)
     inactivity_seconds(0),
     reconnect_seconds(1),
     send_milliseconds(0),
+    worker_affinity({}),
     web_priority(false),
+    web_affinity({}),
+    web_loop_budget_milliseconds(0),
+    web_connection_limit(0),
+    web_pending_query_limit(0),
+    web_outbound_byte_limit(0),
+    web_reject_overload(false),
+    web_asset_cache_bytes(16777216),
+    web_asset_file_bytes(1048576),
+    web_compression_level(6),
+    web_compression_threshold(1024),
+    web_websocket_message_bytes(65536),
+    web_websocket_window_bits(15),
+    web_websocket_context_takeover(false),
+    web_websocket_ping_seconds(30),
+    web_websocket_missed_pongs(2),
     web_origins({}),
     web_root(""),
     web_ca_certificate(""),
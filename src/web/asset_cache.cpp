@@ -0,0 +1,536 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/protocol/web/asset_cache.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+#include <bitcoin/system.hpp>
+#include <bitcoin/protocol/define.hpp>
+#include <bitcoin/protocol/web/utilities.hpp>
+
+#ifdef __linux__
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+using namespace bc::system;
+using boost::filesystem::path;
+
+static constexpr int invalid_notifier = -1;
+
+// Siblings in order of preference, each is served only if it is smaller.
+// Without a .gz sibling a compressible file is gzipped as it is loaded.
+struct sibling
+{
+    asset_cache::encoding coding;
+    const char* extension;
+    const char* name;
+};
+
+static const std::array<sibling, 2> siblings
+{
+    {
+        { asset_cache::encoding::brotli, ".br", "br" },
+        { asset_cache::encoding::gzip, ".gz", "gzip" }
+    }
+};
+
+// 64 bit FNV-1a, sufficient to distinguish versions of a file.
+static uint64_t fingerprint(const data_chunk& data)
+{
+    uint64_t hash = 0xcbf29ce484222325;
+
+    for (const auto byte: data)
+    {
+        hash ^= byte;
+        hash *= 0x100000001b3;
+    }
+
+    return hash;
+}
+
+static std::string to_hex(uint64_t value)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string out(16, '0');
+
+    for (auto position = out.rbegin(); position != out.rend(); ++position)
+    {
+        *position = digits[value & 0x0f];
+        value >>= 4;
+    }
+
+    return out;
+}
+
+static bool read_file(data_chunk& out, const path& file, size_t limit)
+{
+    boost::system::error_code ec;
+    if (!boost::filesystem::is_regular_file(file, ec) || ec)
+        return false;
+
+    const auto size = boost::filesystem::file_size(file, ec);
+    if (ec || (limit != 0 && size > limit))
+        return false;
+
+    std::ifstream stream(file.string(), std::ios::in | std::ios::binary);
+    if (!stream)
+        return false;
+
+    out.resize(static_cast<size_t>(size));
+    stream.read(reinterpret_cast<char*>(out.data()), out.size());
+    return static_cast<size_t>(stream.gcount()) == out.size();
+}
+
+static std::time_t modified(const path& file)
+{
+    boost::system::error_code ec;
+    const auto time = boost::filesystem::last_write_time(file, ec);
+    return ec ? std::time_t{ -1 } : time;
+}
+
+// Text formats, others (images, archives) are generally compressed already.
+static bool is_compressible(const std::string& mime_type)
+{
+    return boost::starts_with(mime_type, "text/") ||
+        boost::contains(mime_type, "json") ||
+        boost::contains(mime_type, "javascript") ||
+        boost::contains(mime_type, "xml");
+}
+
+size_t asset_cache::asset::size() const
+{
+    size_t total = 0;
+
+    for (const auto& variant: variants)
+        total += variant.body.size() + variant.fields.size() +
+            variant.not_modified_fields.size();
+
+    return total;
+}
+
+const asset_cache::variant& asset_cache::asset::select(
+    const std::string& accept_encoding) const
+{
+    if (!accept_encoding.empty())
+    {
+        for (const auto& variant: variants)
+        {
+            for (const auto& sibling: siblings)
+                if (variant.coding == sibling.coding &&
+                    accepts_encoding(accept_encoding, sibling.name))
+                    return variant;
+        }
+    }
+
+    return variants.back();
+}
+
+asset_cache::asset_cache(size_t maximum_bytes, size_t maximum_file_bytes)
+  : maximum_bytes_(maximum_bytes),
+    maximum_file_bytes_(maximum_file_bytes),
+    size_(0),
+    version_(0),
+    compressor_(nullptr),
+    notifier_(invalid_notifier)
+{
+#ifdef __linux__
+    notifier_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (notifier_ == invalid_notifier)
+        LOG_WARNING(LOG_PROTOCOL_HTTP)
+            << "Asset cache falling back to modification time checks.";
+#endif
+}
+
+asset_cache::~asset_cache()
+{
+#ifdef __linux__
+    if (notifier_ != invalid_notifier)
+        ::close(notifier_);
+#endif
+}
+
+void asset_cache::set_limits(size_t maximum_bytes, size_t maximum_file_bytes)
+{
+    maximum_bytes_ = maximum_bytes;
+    maximum_file_bytes_ = maximum_file_bytes;
+    trim();
+}
+
+void asset_cache::set_compressor(http::compressor* compressor)
+{
+    compressor_ = compressor;
+}
+
+bool asset_cache::enabled() const
+{
+    return maximum_bytes_ != 0;
+}
+
+size_t asset_cache::size() const
+{
+    return size_;
+}
+
+size_t asset_cache::count() const
+{
+    return entries_.size();
+}
+
+asset_cache::ptr asset_cache::find(const std::string& uri)
+{
+    refresh();
+
+    const auto it = entries_.find(uri);
+    if (it == entries_.end())
+        return nullptr;
+
+    // Without notifications each hit costs a stat of the file.
+    if (notifier_ == invalid_notifier &&
+        modified(it->second.value->path) != it->second.value->modified)
+    {
+        erase(it);
+        return nullptr;
+    }
+
+    recency_.splice(recency_.begin(), recency_, it->second.position);
+    return it->second.value;
+}
+
+asset_cache::ptr asset_cache::load(const std::string& uri, const path& file)
+{
+    if (!enabled())
+        return nullptr;
+
+    // Watch before reading so that no change can be missed.
+    if (notifier_ != invalid_notifier && !watch(file.parent_path()))
+        return nullptr;
+
+    refresh();
+    const auto version = version_;
+    const auto value = read(file, compressor_);
+    return insert(uri, value, version) ? value : nullptr;
+}
+
+uint64_t asset_cache::version() const
+{
+    return version_;
+}
+
+asset_cache::ptr asset_cache::read(const path& file,
+    http::compressor* compressor) const
+{
+    if (!enabled())
+        return nullptr;
+
+    const auto limit = maximum_file_bytes_ == 0 ? maximum_bytes_ :
+        std::min(maximum_bytes_, maximum_file_bytes_);
+
+    const auto time = modified(file);
+    data_chunk body;
+    if (time == std::time_t{ -1 } || !read_file(body, file, limit))
+        return nullptr;
+
+    const auto value = std::make_shared<asset>();
+    value->path = file;
+    value->modified = time;
+
+    const auto type = mime_type(file);
+    const auto last_modified = "Last-Modified: " + to_http_date(time) + "\r\n";
+    const auto identity_size = body.size();
+
+    for (const auto& sibling: siblings)
+    {
+        variant encoded;
+        auto sibling_file = file;
+        sibling_file += sibling.extension;
+
+        if (read_file(encoded.body, sibling_file, limit) &&
+            encoded.body.size() < identity_size)
+        {
+            encoded.coding = sibling.coding;
+            value->variants.push_back(std::move(encoded));
+        }
+    }
+
+    const auto gzipped = std::any_of(value->variants.begin(),
+        value->variants.end(), [](const variant& variant)
+        {
+            return variant.coding == encoding::gzip;
+        });
+
+    if (!gzipped && compressor != nullptr && is_compressible(type))
+    {
+        std::string encoded;
+        const std::string text(body.begin(), body.end());
+
+        if (compressor->compress(encoded, text, content_coding::gzip))
+        {
+            variant generated;
+            generated.coding = encoding::gzip;
+            generated.body.assign(encoded.begin(), encoded.end());
+            value->variants.push_back(std::move(generated));
+        }
+    }
+
+    variant identity;
+    identity.coding = encoding::identity;
+    identity.body = std::move(body);
+    value->variants.push_back(std::move(identity));
+
+    const auto vary = value->variants.size() > 1;
+
+    for (auto& variant: value->variants)
+    {
+        const auto tag = to_hex(fingerprint(variant.body));
+        std::string coding;
+
+        for (const auto& sibling: siblings)
+            if (sibling.coding == variant.coding)
+                coding = sibling.name;
+
+        variant.etag = "\"" + tag + (coding.empty() ? "" : "-" + coding) +
+            "\"";
+
+        auto& validators = variant.not_modified_fields;
+        validators = "ETag: " + variant.etag + "\r\n" + last_modified;
+
+        if (vary)
+            validators += "Vary: Accept-Encoding\r\n";
+
+        variant.fields = "Accept-Ranges: bytes\r\n" + validators;
+        variant.fields += "Content-Type: " + type + "\r\n";
+
+        if (!coding.empty())
+            variant.fields += "Content-Encoding: " + coding + "\r\n";
+
+        variant.fields += "Content-Length: " +
+            std::to_string(variant.body.size()) + "\r\n";
+    }
+
+    return value;
+}
+
+bool asset_cache::insert(const std::string& uri, ptr value, uint64_t version)
+{
+    invalidate(uri);
+
+    if (!value || value->size() > maximum_bytes_)
+        return false;
+
+    // A notification since the read may concern this file, and a directory
+    // not yet watched may have changed unseen, so the next read is cached.
+    refresh();
+    if (version != version_)
+        return false;
+
+    if (notifier_ != invalid_notifier && !watched(value->path.parent_path()))
+    {
+        watch(value->path.parent_path());
+        return false;
+    }
+
+    size_ += value->size();
+    recency_.push_front(uri);
+    entries_.emplace(uri, entry{ value, recency_.begin() });
+    trim();
+
+    LOG_VERBOSE(LOG_PROTOCOL_HTTP)
+        << "Cached " << value->path << " (" << value->variants.size()
+        << " variants, " << value->size() << " bytes)";
+
+    return true;
+}
+
+void asset_cache::invalidate(const std::string& uri)
+{
+    const auto it = entries_.find(uri);
+    if (it != entries_.end())
+        erase(it);
+}
+
+void asset_cache::clear()
+{
+    entries_.clear();
+    recency_.clear();
+    size_ = 0;
+}
+
+void asset_cache::refresh()
+{
+#ifdef __linux__
+    if (notifier_ == invalid_notifier)
+        return;
+
+    // Large enough for many events, each at least sizeof(inotify_event).
+    alignas(inotify_event) std::array<char, 4096> events;
+
+    while (true)
+    {
+        const auto read = ::read(notifier_, events.data(), events.size());
+        if (read <= 0)
+            return;
+
+        for (auto position = events.data();
+            position < events.data() + read;)
+        {
+            const auto event = reinterpret_cast<const inotify_event*>(
+                position);
+            position += sizeof(inotify_event) + event->len;
+            ++version_;
+
+            if ((event->mask & IN_Q_OVERFLOW) != 0)
+            {
+                LOG_DEBUG(LOG_PROTOCOL_HTTP)
+                    << "Asset cache notifications lost, clearing cache.";
+                clear();
+                continue;
+            }
+
+            const auto watched = watches_.find(event->wd);
+            if (watched == watches_.end())
+                continue;
+
+            if ((event->mask & IN_IGNORED) != 0)
+            {
+                watches_.erase(watched);
+                continue;
+            }
+
+            // A change to any file in the directory, including siblings,
+            // invalidates the assets derived from it.
+            const std::string name(event->len == 0 ? "" : event->name);
+
+            for (auto it = entries_.begin(); it != entries_.end();)
+            {
+                const auto& file = it->second.value->path;
+                const auto stem = file.filename().string();
+
+                if (file.parent_path() == watched->second &&
+                    (name.empty() || boost::starts_with(name, stem)))
+                    erase(it++);
+                else
+                    ++it;
+            }
+        }
+    }
+#endif
+}
+
+bool asset_cache::matches(const std::string& if_none_match,
+    const std::string& etag)
+{
+    if (if_none_match.empty())
+        return false;
+
+    std::vector<std::string> tags;
+    boost::split(tags, if_none_match, boost::is_any_of(","));
+
+    for (auto& tag: tags)
+    {
+        boost::trim(tag);
+
+        // Weak comparison applies to If-None-Match (RFC 7232 3.2).
+        if (boost::starts_with(tag, "W/"))
+            tag.erase(0, 2);
+
+        if (tag == "*" || tag == etag)
+            return true;
+    }
+
+    return false;
+}
+
+std::string asset_cache::to_http_date(std::time_t time)
+{
+    std::tm utc;
+#ifdef _MSC_VER
+    gmtime_s(&utc, &time);
+#else
+    gmtime_r(&time, &utc);
+#endif
+    std::array<char, 32> text;
+    const auto size = std::strftime(text.data(), text.size(),
+        "%a, %d %b %Y %H:%M:%S GMT", &utc);
+    return { text.data(), size };
+}
+
+// private
+// ----------------------------------------------------------------------------
+
+void asset_cache::erase(entry_map::iterator it)
+{
+    size_ -= it->second.value->size();
+    recency_.erase(it->second.position);
+    entries_.erase(it);
+}
+
+void asset_cache::trim()
+{
+    while (size_ > maximum_bytes_ && !recency_.empty())
+        invalidate(recency_.back());
+}
+
+bool asset_cache::watched(const path& directory) const
+{
+    return std::any_of(watches_.begin(), watches_.end(),
+        [&directory](const std::pair<const int, path>& watch)
+        {
+            return watch.second == directory;
+        });
+}
+
+bool asset_cache::watch(const path& directory)
+{
+#ifdef __linux__
+    static constexpr auto changes = IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE |
+        IN_DELETE | IN_DELETE_SELF | IN_MODIFY | IN_MOVED_FROM | IN_MOVED_TO |
+        IN_MOVE_SELF;
+
+    // Watching a directory again returns its existing watch descriptor.
+    const auto descriptor = ::inotify_add_watch(notifier_,
+        directory.string().c_str(), changes);
+
+    if (descriptor < 0)
+    {
+        LOG_WARNING(LOG_PROTOCOL_HTTP)
+            << "Unable to watch " << directory << " for changes.";
+        return false;
+    }
+
+    watches_[descriptor] = directory;
+#endif
+    return true;
+}
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
@@ -0,0 +1,74 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/protocol/web/binary_query.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <bitcoin/system.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+using namespace bc::system;
+
+const std::string binary_query::protocol = "libbitcoin.query";
+
+constexpr size_t binary_query::id_size;
+constexpr size_t binary_query::maximum_command;
+
+bool binary_query::decode(binary_query& out, const uint8_t* data, size_t size)
+{
+    if (size == 0)
+        return false;
+
+    const size_t command_size = data[0];
+    const auto header_size = 1 + command_size + id_size;
+    if (command_size == 0 || size < header_size)
+        return false;
+
+    const auto command = data + 1;
+    const auto id = command + command_size;
+    out.command.assign(command, id);
+    out.id = from_little_endian_unsafe<uint32_t>(id);
+    out.payload.assign(data + header_size, data + size);
+    return true;
+}
+
+data_chunk binary_query::encode(const std::string& command, uint32_t id,
+    const data_chunk& payload)
+{
+    if (command.empty() || command.size() > maximum_command)
+        return {};
+
+    const auto id_bytes = to_little_endian(id);
+
+    data_chunk out;
+    out.reserve(1 + command.size() + id_size + payload.size());
+    out.push_back(static_cast<uint8_t>(command.size()));
+    out.insert(out.end(), command.begin(), command.end());
+    out.insert(out.end(), id_bytes.begin(), id_bytes.end());
+    out.insert(out.end(), payload.begin(), payload.end());
+    return out;
+}
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
@@ -0,0 +1,69 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/protocol/web/buffer_pool.hpp>
+
+#include <cstddef>
+#include <utility>
+#include <bitcoin/system.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+using namespace bc::system;
+
+constexpr size_t buffer_pool::default_buffers;
+
+buffer_pool::buffer_pool(size_t buffers)
+  : buffers_(buffers)
+{
+    pool_.reserve(buffers_);
+}
+
+data_chunk buffer_pool::acquire()
+{
+    if (pool_.empty())
+        return {};
+
+    data_chunk buffer;
+    buffer.swap(pool_.back());
+    pool_.pop_back();
+    return buffer;
+}
+
+void buffer_pool::release(data_chunk& buffer)
+{
+    data_chunk released;
+    released.swap(buffer);
+
+    if (pool_.size() == buffers_ || released.capacity() == 0)
+        return;
+
+    released.clear();
+    pool_.push_back(std::move(released));
+}
+
+size_t buffer_pool::size() const
+{
+    return pool_.size();
+}
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
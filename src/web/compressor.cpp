@@ -0,0 +1,194 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/protocol/web/compressor.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <bitcoin/system.hpp>
+#include <bitcoin/protocol/web/utilities.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+using namespace bc::system;
+
+#ifdef WITH_ZLIB
+// Window bits of the zlib (deflate) format, gzip adds 16 (RFC 1952).
+static constexpr int window_bits = 15;
+static constexpr int gzip_window_bits = window_bits + 16;
+static constexpr int memory_level = 8;
+
+static bool reset(z_stream& stream, bool& ready, int level, int bits)
+{
+    if (ready)
+        return deflateReset(&stream) == Z_OK;
+
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    ready = deflateInit2(&stream, level, Z_DEFLATED, bits, memory_level,
+        Z_DEFAULT_STRATEGY) == Z_OK;
+    return ready;
+}
+#endif
+
+constexpr int32_t compressor::default_level;
+constexpr size_t compressor::default_threshold;
+
+compressor::compressor(int32_t level, size_t threshold)
+  : level_(std::max(0, std::min(level, 9))),
+    threshold_(threshold)
+#ifdef WITH_ZLIB
+    , gzip_ready_(false),
+    deflate_ready_(false),
+    gzip_{},
+    deflate_{}
+#endif
+{
+}
+
+compressor::~compressor()
+{
+    release();
+}
+
+bool compressor::available()
+{
+#ifdef WITH_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::string compressor::to_string(content_coding coding)
+{
+    switch (coding)
+    {
+        case content_coding::gzip:
+            return "gzip";
+        case content_coding::deflate:
+            return "deflate";
+        case content_coding::identity:
+        default:
+            return "identity";
+    }
+}
+
+void compressor::configure(int32_t level, size_t threshold)
+{
+    level = std::max(0, std::min(level, 9));
+
+    // State is initialized for a level, so it is rebuilt on next use.
+    if (level != level_)
+        release();
+
+    level_ = level;
+    threshold_ = threshold;
+}
+
+int32_t compressor::level() const
+{
+    return level_;
+}
+
+size_t compressor::threshold() const
+{
+    return threshold_;
+}
+
+content_coding compressor::negotiate(const std::string& accept_encoding) const
+{
+    if (!available() || level_ == 0 || accept_encoding.empty())
+        return content_coding::identity;
+
+    if (accepts_encoding(accept_encoding, "gzip"))
+        return content_coding::gzip;
+
+    if (accepts_encoding(accept_encoding, "deflate"))
+        return content_coding::deflate;
+
+    return content_coding::identity;
+}
+
+bool compressor::compress(std::string& out, const std::string& body,
+    content_coding coding)
+{
+#ifdef WITH_ZLIB
+    if (level_ == 0 || coding == content_coding::identity ||
+        body.size() < threshold_ ||
+        body.size() > std::numeric_limits<uInt>::max())
+        return false;
+
+    const auto gzip = coding == content_coding::gzip;
+    auto& stream = gzip ? gzip_ : deflate_;
+    auto& ready = gzip ? gzip_ready_ : deflate_ready_;
+
+    if (!reset(stream, ready, level_, gzip ? gzip_window_bits : window_bits))
+    {
+        LOG_ERROR(LOG_PROTOCOL_HTTP)
+            << "Failed to initialize " << to_string(coding) << " compressor.";
+        return false;
+    }
+
+    // The bound includes the wrapper, so one call completes the body.
+    const auto bound = deflateBound(&stream, static_cast<uLong>(body.size()));
+    if (bound > std::numeric_limits<uInt>::max())
+        return false;
+
+    out.resize(bound);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(body.data()));
+    stream.avail_in = static_cast<uInt>(body.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    stream.avail_out = static_cast<uInt>(out.size());
+
+    if (deflate(&stream, Z_FINISH) != Z_STREAM_END)
+        return false;
+
+    out.resize(static_cast<size_t>(stream.total_out));
+    return out.size() < body.size();
+#else
+    return false;
+#endif
+}
+
+// private
+// ----------------------------------------------------------------------------
+
+void compressor::release()
+{
+#ifdef WITH_ZLIB
+    if (gzip_ready_)
+        deflateEnd(&gzip_);
+
+    if (deflate_ready_)
+        deflateEnd(&deflate_);
+
+    gzip_ready_ = false;
+    deflate_ready_ = false;
+#endif
+}
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
@@ -18,6 +18,10 @@
  */
 #include <bitcoin/protocol/web/connection.hpp>
 
+#ifndef _MSC_VER
+    #include <sys/uio.h>
+#endif
+
  // TODO: include other headers.
 
 namespace libbitcoin {
@@ -28,6 +32,30 @@ using namespace bc::system;
 
 static constexpr size_t maximum_read_length = 1024;
 static constexpr size_t high_water_mark = 2 * 1024 * 1024;
+static constexpr size_t maximum_control_payload = 125;
+
+// The write buffer and frames gathered by one vectored write.
+static constexpr size_t maximum_segments = 64;
+
+// A larger response body is streamed in chunks of the given size.
+static constexpr size_t maximum_buffered_body = high_water_mark / 8;
+static constexpr size_t streamed_chunk_size = 64 * 1024;
+
+// Produce the body in pieces as the connection drains.
+static connection::producer pieces(std::string&& body)
+{
+    const auto content = std::make_shared<const std::string>(std::move(body));
+    const auto offset = std::make_shared<size_t>(0);
+
+    return [content, offset](std::string& piece)
+    {
+        const auto size = std::min(streamed_chunk_size,
+            content->size() - *offset);
+        piece.append(*content, *offset, size);
+        *offset += size;
+        return *offset < content->size();
+    };
+}
 
 connection::connection()
   : connection(0, {})
@@ -42,10 +70,28 @@ connection::connection(sock_t connection, const sockaddr_in& address)
     last_active_(system::asio::steady_clock::now()),
     ssl_context_{},
     websocket_(false),
+    websocket_protocol_{},
     json_rpc_(false),
+    event_stream_(false),
+    keep_alive_(true),
+    protocol_version_(1.1),
+    compressor_(nullptr),
+    codings_{},
+    deflate_(nullptr),
+    deflate_session_{},
+    next_slot_(0),
+    write_slot_(0),
+    active_slot_(0),
+    last_event_id_(0),
     file_transfer_{},
-    websocket_transfer_{},
-    bytes_read_(0)
+    websocket_decoder_{},
+    bytes_read_(0),
+    frames_{},
+    queued_(0),
+    dropped_(0),
+    outbound_{},
+    accounted_(0),
+    held_(0)
 {
     write_buffer_.reserve(high_water_mark);
 }
@@ -129,6 +175,16 @@ data_chunk& connection::write_buffer()
     return write_buffer_;
 }
 
+data_chunk& connection::input_buffer()
+{
+    return input_buffer_;
+}
+
+http_parser& connection::parser()
+{
+    return parser_;
+}
+
 int32_t connection::unbuffered_write(const data_chunk& buffer)
 {
     return unbuffered_write(buffer.data(), buffer.size());
@@ -140,7 +196,8 @@ int32_t connection::unbuffered_write(const std::string& buffer)
     return unbuffered_write(data, buffer.size());
 }
 
-int32_t connection::unbuffered_write(const uint8_t* data, size_t length)
+// A single write, which may be partial.
+int32_t connection::write_once(const uint8_t* data, size_t length)
 {
     const auto plaintext_write = [this](const uint8_t* data, size_t length)
     {
@@ -170,12 +227,17 @@ int32_t connection::unbuffered_write(const uint8_t* data, size_t length)
     auto writer = static_cast<write_method>(plaintext_write);
 #endif
 
+    return writer(data, length);
+}
+
+int32_t connection::unbuffered_write(const uint8_t* data, size_t length)
+{
     auto remaining = length;
     auto position = data;
 
     do
     {
-        const auto written = writer(position, remaining);
+        const auto written = write_once(position, remaining);
 
         if (written < 0)
         {
@@ -212,36 +274,665 @@ int32_t connection::write(const std::string& buffer)
     return write(data, buffer.size());
 }
 
-// If high water would be exceeded new messages are silently dropped.
-int32_t connection::write(const uint8_t* data, size_t length)
+// If high water would be exceeded nothing is buffered and the write fails,
+// as a lost reply would otherwise be answered by its successor.
+int32_t connection::write(const uint8_t* data, size_t length,
+    websocket_op code)
 {
     // BUGBUG: must set errno for return error handling.
     if (length > static_cast<size_t>(max_int32))
         return -1;
 
-    const auto header = websocket_ ? websocket_frame::to_header(length,
-        websocket_op::text) : data_chunk{};
-    const auto buffer_size = write_buffer_.size() + header.size() + length;
+    // The uncompressed size is checked, as a dropped message must not enter
+    // the compression context that the client shares.
+    websocket_frame::header_buffer header;
+    auto header_length = websocket_ ? websocket_frame::to_header(header,
+        length, code) : 0;
 
-    if (buffer_size > high_water_mark)
+    if (buffered() + header_length + length > high_water_mark)
     {
         LOG_VERBOSE(LOG_PROTOCOL_HTTP)
-            << "High water exceeded, " << length  << "byte message dropped.";
-        return static_cast<int32_t>(length);
+            << "High water exceeded, " << length  << " byte message failed.";
+        return -1;
+    }
+
+    // The message is compressed if negotiated and worthwhile.
+    const auto compressed = websocket_ && deflate_ != nullptr ?
+        deflate_->compress(deflate_session_, data, length) : nullptr;
+
+    if (compressed != nullptr)
+    {
+        data = compressed->data();
+        length = compressed->size();
+        header_length = websocket_frame::to_header(header, length, code,
+            true);
     }
 
+    // Behind queued frames the message is queued (as a copy) to keep order.
+    if (!frames_.empty())
+        return queue_frame(std::make_shared<const data_chunk>(data,
+            data + length), code, compressed != nullptr) ?
+                static_cast<int32_t>(length) : -1;
+
     // TODO: this is very inefficient, use circular buffer.
     // Buffer header and data for future writes (called from poll).
-    write_buffer_.insert(write_buffer_.end(), header.begin(), header.end());
+    write_buffer_.insert(write_buffer_.end(), header.begin(),
+        header.begin() + header_length);
     write_buffer_.insert(write_buffer_.end(), data, data + length);
+    account();
+    return static_cast<int32_t>(length);
+}
+
+bool connection::write_frame(const shared_payload& payload, websocket_op code,
+    bool compressed)
+{
+    if (!payload || !websocket_)
+        return false;
+
+    if (drop_frame(payload->size(), code))
+        return true;
+
+    return queue_frame(payload, code, compressed);
+}
+
+bool connection::write_frame(const uint8_t* data, size_t length,
+    websocket_op code)
+{
+    if (!websocket_)
+        return false;
+
+    if (drop_frame(length, code))
+        return true;
+
+    return write(data, length, code) >= 0;
+}
+
+size_t connection::dropped() const
+{
+    return dropped_;
+}
+
+// A slow consumer misses frames rather than failing the connection. The
+// uncompressed size is checked, so a dropped message never enters the
+// compression context, and the header is counted with the payload.
+bool connection::drop_frame(size_t length, websocket_op code)
+{
+    websocket_frame::header_buffer header;
+    const auto header_length = websocket_frame::to_header(header, length,
+        code);
+
+    if (buffered() + header_length + length <= high_water_mark)
+        return false;
+
+    ++dropped_;
+    LOG_DEBUG(LOG_PROTOCOL_HTTP)
+        << "High water exceeded, " << length << " byte frame dropped ("
+        << dropped_ << " dropped).";
+    return true;
+}
+
+bool connection::write_control(websocket_op code, const uint8_t* data,
+    size_t size)
+{
+    if (!websocket_ || size > maximum_control_payload)
+        return false;
+
+    if (!frames_.empty())
+        return queue_frame(std::make_shared<const data_chunk>(data,
+            data + size), code, false);
+
+    websocket_frame::header_buffer header;
+    const auto header_length = websocket_frame::to_header(header, size, code);
+    write_buffer_.insert(write_buffer_.end(), header.begin(),
+        header.begin() + header_length);
+    write_buffer_.insert(write_buffer_.end(), data, data + size);
+    account();
+    return true;
+}
+
+bool connection::queue_frame(const shared_payload& payload, websocket_op code,
+    bool compressed)
+{
+    queued_frame frame;
+    frame.header_length = websocket_frame::to_header(frame.header,
+        payload->size(), code, compressed);
+    frame.payload = payload;
+    frame.offset = 0;
+
+    queued_ += frame.header_length + payload->size();
+    frames_.push_back(std::move(frame));
+    account();
+    return true;
+}
+
+size_t connection::buffered() const
+{
+    return write_buffer_.size() + queued_;
+}
+
+void connection::set_outbound_counter(counter_ptr counter)
+{
+    if (outbound_)
+        *outbound_ -= accounted_;
+
+    outbound_ = counter;
+    accounted_ = 0;
+    account();
+}
+
+// Bring the owner's total up to date with this buffer, which also corrects
+// for changes made directly to the write buffer. Held responses are counted
+// though not yet buffered for writing.
+void connection::account()
+{
+    const auto current = buffered() + held_;
+    if (outbound_)
+        *outbound_ = *outbound_ - accounted_ + current;
+
+    accounted_ = current;
+}
+
+int32_t connection::flush(size_t limit)
+{
+    struct segment
+    {
+        const uint8_t* data;
+        size_t size;
+    };
+
+    segment segments[maximum_segments];
+    size_t count = 0;
+    size_t total = 0;
+
+    const auto gather = [&](const uint8_t* data, size_t size)
+    {
+        if (size == 0 || count == maximum_segments || total == limit)
+            return;
+
+        size = std::min(size, limit - total);
+        segments[count++] = { data, size };
+        total += size;
+    };
+
+    gather(write_buffer_.data(), write_buffer_.size());
+
+    for (const auto& frame: frames_)
+    {
+        if (count == maximum_segments || total == limit)
+            break;
+
+        // The offset is within the header or else the payload.
+        const auto payload_offset = frame.offset > frame.header_length ?
+            frame.offset - frame.header_length : 0;
+
+        if (frame.offset < frame.header_length)
+            gather(frame.header.data() + frame.offset,
+                frame.header_length - frame.offset);
+
+        gather(frame.payload->data() + payload_offset,
+            frame.payload->size() - payload_offset);
+    }
+
+    if (count == 0)
+        return 0;
+
+#ifndef _MSC_VER
+    // Plaintext is written with one call, a header and its (shared) payload
+    // are not copied together.
+    if (!ssl_enabled())
+    {
+        iovec vectors[maximum_segments];
+        for (size_t index = 0; index < count; ++index)
+        {
+            vectors[index].iov_base = const_cast<uint8_t*>(
+                segments[index].data);
+            vectors[index].iov_len = segments[index].size;
+        }
+
+        const auto written = ::writev(socket_, vectors,
+            static_cast<int>(count));
+
+        if (written < 0)
+        {
+            const auto error = last_error();
+            if (would_block(error))
+                return 0;
+
+            LOG_WARNING(LOG_PROTOCOL_HTTP)
+                << "Vectored write failed. requested " << total << ": "
+                << error_string();
+            return -1;
+        }
+
+        consume(static_cast<size_t>(written));
+        return static_cast<int32_t>(written);
+    }
+#endif
+
+    // Otherwise segments are written in turn until one is not completed.
+    size_t written = 0;
+    for (size_t index = 0; index < count; ++index)
+    {
+        const auto result = write_once(segments[index].data,
+            segments[index].size);
+
+        if (result < 0)
+        {
+            const auto error = last_error();
+            if (would_block(error))
+                break;
+
+            LOG_WARNING(LOG_PROTOCOL_HTTP)
+                << "Buffered write failed. requested " << segments[index].size
+                << ": " << error_string();
+            return -1;
+        }
+
+        written += static_cast<size_t>(result);
+        if (static_cast<size_t>(result) != segments[index].size)
+            break;
+    }
+
+    consume(written);
+    return static_cast<int32_t>(written);
+}
+
+// Written bytes are removed from the buffer and then the queued frames.
+void connection::consume(size_t written)
+{
+    const auto buffered = std::min(written, write_buffer_.size());
+
+    // TODO: this is very inefficient, use circular buffer.
+    write_buffer_.erase(write_buffer_.begin(), write_buffer_.begin() +
+        buffered);
+    written -= buffered;
+
+    while (!frames_.empty())
+    {
+        auto& frame = frames_.front();
+        const auto remaining = frame.header_length + frame.payload->size() -
+            frame.offset;
+
+        if (written < remaining)
+        {
+            frame.offset += written;
+            queued_ -= written;
+            break;
+        }
+
+        queued_ -= remaining;
+        written -= remaining;
+        frames_.pop_front();
+    }
+
+    account();
+}
+
+uint32_t connection::reserve_slot()
+{
+    return next_slot_++;
+}
+
+uint32_t connection::active_slot() const
+{
+    return active_slot_;
+}
+
+void connection::set_active_slot(uint32_t slot)
+{
+    active_slot_ = slot;
+}
+
+size_t connection::pending_responses() const
+{
+    return next_slot_ - write_slot_;
+}
+
+// Slots wrap, so order is only ever compared relative to the write slot.
+bool connection::write_response(uint32_t slot, const std::string& response)
+{
+    // The coding of a slot answered here (already encoded) is not used.
+    codings_.erase(slot);
+    const auto distance = slot - write_slot_;
+
+    // A later response is held until all of its predecessors are written.
+    if (distance != 0 && distance < pending_responses())
+    {
+        auto& held = responses_[slot];
+        held_ = held_ - held.size() + response.size();
+        held = response;
+        account();
+        return true;
+    }
+
+    if (write(response) < 0)
+        return false;
+
+    // A repeat response to an already answered slot does not advance.
+    if (distance != 0)
+        return true;
+
+    ++write_slot_;
+    return advance();
+}
+
+bool connection::write_response(uint32_t slot, protocol_status status,
+    const std::string& body)
+{
+    const auto coding = this->coding(slot);
+    codings_.erase(slot);
+
+    std::string encoded;
+    if (http2_)
+    {
+        hpack::header_list fields;
+        const auto compressed = compressor_ != nullptr &&
+            compressor_->compress(encoded, body, coding);
+
+        if (compressed)
+        {
+            fields.emplace_back("content-encoding",
+                compressor::to_string(coding));
+            fields.emplace_back("vary", "accept-encoding");
+        }
+
+        http2_->respond(slot, status, fields, compressed ? encoded : body);
+        http2_->flush(write_buffer_, high_water_mark);
+        account();
+        return true;
+    }
+
+    const auto compressed = compressor_ != nullptr &&
+        compressor_->compress(encoded, body, coding);
+    const auto coding_fields = compressed ?
+        "Content-Encoding: " + compressor::to_string(coding) + "\r\n"
+        "Vary: Accept-Encoding\r\n" : std::string{};
+
+    // A large body is streamed, as buffered whole it could exceed high water.
+    // Unless chunked the pieces are sent unframed, delimited by the length.
+    const auto size = (compressed ? encoded : body).size();
+    if (size > maximum_buffered_body)
+    {
+        const auto header = http_reply::generate(status, coding_fields +
+            (chunked() ? std::string("Transfer-Encoding: chunked\r\n") :
+                "Content-Length: " + std::to_string(size) + "\r\n"),
+            keep_alive_);
+
+        return queue_stream(slot, header,
+            pieces(compressed ? std::move(encoded) : std::string(body)));
+    }
+
+    // A header is not left buffered without its body.
+    const auto start = write_buffer_.size();
+    const auto fail = [this, start]()
+    {
+        write_buffer_.resize(start);
+        account();
+        return false;
+    };
+
+    if (compressed)
+    {
+        const auto fields = coding_fields +
+            "Content-Length: " + std::to_string(encoded.size()) + "\r\n";
+
+        if (slot != write_slot_)
+            return write_response(slot, http_reply::generate(status, fields,
+                keep_alive_) + encoded);
+
+        if (write_header(status, fields, keep_alive_) < 0 ||
+            write(encoded) < 0)
+            return fail();
+    }
+    else
+    {
+        if (slot != write_slot_)
+        {
+            http_reply reply;
+            return write_response(slot, reply.generate(status, {},
+                body.size(), keep_alive_) + body);
+        }
+
+        if (write_header(status, {}, body.size(), keep_alive_) < 0 ||
+            write(body) < 0)
+            return fail();
+    }
+
+    ++write_slot_;
+    return advance();
+}
+
+void connection::set_compressor(http::compressor* compressor)
+{
+    compressor_ = compressor;
+}
+
+void connection::set_content_coding(uint32_t slot, content_coding coding)
+{
+    if (coding == content_coding::identity)
+        codings_.erase(slot);
+    else
+        codings_[slot] = coding;
+}
+
+content_coding connection::coding(uint32_t slot) const
+{
+    const auto coding = codings_.find(slot);
+    return coding == codings_.end() ? content_coding::identity :
+        coding->second;
+}
+
+void connection::set_websocket_deflate(http::websocket_deflate* deflate,
+    const websocket_deflate::parameters& agreed)
+{
+    deflate_ = agreed.enabled ? deflate : nullptr;
+    deflate_session_.agreed = agreed;
+}
+
+websocket_deflate::session& connection::deflate_session()
+{
+    return deflate_session_;
+}
+
+bool connection::write_stream(uint32_t slot, const std::string& header,
+    producer next)
+{
+    if (http2_ || !chunked())
+    {
+        std::string body;
+        while (next(body))
+            continue;
+
+        return write_response(slot, protocol_status::ok, body);
+    }
+
+    return queue_stream(slot, header, next);
+}
+
+bool connection::queue_stream(uint32_t slot, const std::string& header,
+    producer next)
+{
+    codings_.erase(slot);
+    const auto distance = slot - write_slot_;
+
+    if (distance != 0 && distance < pending_responses())
+    {
+        auto& held = streams_[slot];
+        held_ = held_ - held.first.size() + header.size();
+        held = { header, next };
+        account();
+        return true;
+    }
+
+    // A stream cannot answer an already answered slot.
+    if (distance != 0 || write(header) < 0)
+        return false;
+
+    stream_ = next;
+    return true;
+}
+
+bool connection::streaming() const
+{
+    return !!stream_ || (http2_ && http2_->writable());
+}
+
+bool connection::continue_stream(size_t high_water)
+{
+    if (http2_)
+    {
+        http2_->flush(write_buffer_, high_water);
+        account();
+        return true;
+    }
+
+    while (stream_ && write_buffer_.size() < high_water)
+    {
+        std::string piece;
+        const auto more = stream_(piece);
+
+        if (!piece.empty() && !write_piece(piece))
+            return false;
+
+        if (more)
+            continue;
+
+        // The last chunk completes the response and its slot.
+        stream_ = nullptr;
+        if (chunked() && write(std::string("0\r\n\r\n")) < 0)
+            return false;
+
+        ++write_slot_;
+        return advance();
+    }
+
+    return true;
+}
+
+// Each line of the data is a data field (text/event-stream).
+bool connection::write_event(uint64_t id, const std::string& data)
+{
+    if (id <= last_event_id_)
+        return true;
+
+    last_event_id_ = id;
+    std::string event = "id: " + std::to_string(id) + "\n";
+
+    for (size_t start = 0; start <= data.size();)
+    {
+        const auto end = std::min(data.find('\n', start), data.size());
+        event += "data: " + data.substr(start, end - start) + "\n";
+        start = end + 1;
+    }
+
+    return write_piece(event + "\n");
+}
+
+bool connection::write_piece(const std::string& piece)
+{
+    return chunked() ? write_chunk(piece) : write(piece) >= 0;
+}
+
+bool connection::write_chunk(const std::string& piece)
+{
+    static const char digits[] = "0123456789abcdef";
+
+    std::string size;
+    for (auto value = piece.size(); value != 0; value >>= 4)
+        size.insert(size.begin(), digits[value & 0x0f]);
+
+    return write(size + "\r\n" + piece + "\r\n") >= 0;
+}
+
+// Write held responses that are now in order, stopping at a stream.
+bool connection::advance()
+{
+    while (true)
+    {
+        const auto response = responses_.find(write_slot_);
+        if (response != responses_.end())
+        {
+            if (write(response->second) < 0)
+                return false;
+
+            held_ -= response->second.size();
+            responses_.erase(response);
+            account();
+            ++write_slot_;
+            continue;
+        }
+
+        const auto stream = streams_.find(write_slot_);
+        if (stream != streams_.end())
+        {
+            if (write(stream->second.first) < 0)
+                return false;
+
+            stream_ = stream->second.second;
+            held_ -= stream->second.first.size();
+            streams_.erase(stream);
+            account();
+        }
+
+        return true;
+    }
+}
+
+// If high water would be exceeded nothing is buffered and the write fails.
+int32_t connection::write_header(protocol_status status,
+    const std::string& mime_type, size_t content_length, bool keep_alive)
+{
+    const auto start = write_buffer_.size();
+    http_reply::write(write_buffer_, status, mime_type, content_length,
+        keep_alive);
+
+    const auto length = write_buffer_.size() - start;
+    if (write_buffer_.size() > high_water_mark)
+    {
+        write_buffer_.resize(start);
+        LOG_VERBOSE(LOG_PROTOCOL_HTTP)
+            << "High water exceeded, " << length << " byte header failed.";
+        return -1;
+    }
+
+    account();
+    return static_cast<int32_t>(length);
+}
+
+int32_t connection::write_header(protocol_status status,
+    const std::string& fields, bool keep_alive)
+{
+    const auto start = write_buffer_.size();
+    http_reply::write(write_buffer_, status, fields, keep_alive);
+
+    const auto length = write_buffer_.size() - start;
+    if (write_buffer_.size() > high_water_mark)
+    {
+        write_buffer_.resize(start);
+        LOG_VERBOSE(LOG_PROTOCOL_HTTP)
+            << "High water exceeded, " << length << " byte header failed.";
+        return -1;
+    }
+
+    account();
     return static_cast<int32_t>(length);
 }
 
 void connection::close()
 {
+    // Bytes left buffered are never written.
+    set_outbound_counter(nullptr);
+
     if (state_ == connection_state::closed)
         return;
 
+    // An outstanding file pool read closes the descriptor on completion.
+    if (file_transfer_.in_progress && !file_transfer_.pending)
+    {
+        CLOSE_FILE(file_transfer_.descriptor);
+        file_transfer_.in_progress = false;
+    }
+
 #ifdef WITH_MBEDTLS
     if (ssl_context_.enabled)
     {
@@ -287,6 +978,27 @@ void connection::set_websocket(bool websocket)
     websocket_ = websocket;
 }
 
+const std::string& connection::websocket_protocol() const
+{
+    return websocket_protocol_;
+}
+
+void connection::set_websocket_protocol(const std::string& protocol)
+{
+    websocket_protocol_ = protocol;
+}
+
+http2_session* connection::http2()
+{
+    return http2_.get();
+}
+
+http2_session* connection::start_http2(size_t maximum_body)
+{
+    http2_.reset(new http2_session(maximum_body));
+    return http2_.get();
+}
+
 const std::string& connection::uri() const
 {
     return uri_;
@@ -307,6 +1019,41 @@ void connection::set_json_rpc(bool json_rpc)
     json_rpc_ = json_rpc;
 }
 
+bool connection::event_stream() const
+{
+    return event_stream_;
+}
+
+void connection::set_event_stream(bool event_stream)
+{
+    event_stream_ = event_stream;
+}
+
+bool connection::keep_alive() const
+{
+    return keep_alive_;
+}
+
+void connection::set_keep_alive(bool keep_alive)
+{
+    keep_alive_ = keep_alive;
+}
+
+double connection::protocol_version() const
+{
+    return protocol_version_;
+}
+
+void connection::set_protocol_version(double protocol_version)
+{
+    protocol_version_ = protocol_version;
+}
+
+bool connection::chunked() const
+{
+    return protocol_version_ >= 1.1;
+}
+
 void* connection::user_data()
 {
     return user_data_;
@@ -322,9 +1069,19 @@ http::file_transfer& connection::file_transfer()
     return file_transfer_;
 }
 
-http::websocket_transfer& connection::websocket_transfer()
+http::websocket_decoder& connection::websocket_decoder()
+{
+    return websocket_decoder_;
+}
+
+http::websocket_assembler& connection::websocket_assembler()
+{
+    return websocket_assembler_;
+}
+
+http::websocket_keepalive& connection::keepalive()
 {
-    return websocket_transfer_;
+    return keepalive_;
 }
 
 bool connection::operator==(const connection& other)
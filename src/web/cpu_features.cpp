@@ -0,0 +1,108 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "cpu_features.hpp"
+
+#include <string>
+#include <bitcoin/protocol/web/vector_kernel.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+#ifdef CPU_FEATURES_X64
+static bool detect_avx2()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+
+    // The processor and operating system must both support AVX state.
+    static constexpr int osxsave = 1 << 27;
+    static constexpr int avx = 1 << 28;
+    __cpuid(info, 1);
+    if ((info[2] & osxsave) == 0 || (info[2] & avx) == 0 ||
+        (_xgetbv(0) & 0x6) != 0x6)
+        return false;
+
+    static constexpr int avx2 = 1 << 5;
+    __cpuidex(info, 7, 0);
+    return (info[1] & avx2) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif
+
+vector_kernel cpu_features::best()
+{
+    static const auto selected =
+        supported(vector_kernel::avx2) ? vector_kernel::avx2 :
+        supported(vector_kernel::sse2) ? vector_kernel::sse2 :
+        supported(vector_kernel::neon) ? vector_kernel::neon :
+            vector_kernel::scalar;
+
+    return selected;
+}
+
+bool cpu_features::supported(vector_kernel type)
+{
+    switch (type)
+    {
+        case vector_kernel::scalar:
+            return true;
+#ifdef CPU_FEATURES_X64
+        case vector_kernel::sse2:
+            return true;
+        case vector_kernel::avx2:
+        {
+            static const auto detected = detect_avx2();
+            return detected;
+        }
+#endif
+#ifdef CPU_FEATURES_ARM64
+        case vector_kernel::neon:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+std::string cpu_features::to_string(vector_kernel type)
+{
+    switch (type)
+    {
+        case vector_kernel::sse2:
+            return "sse2";
+        case vector_kernel::avx2:
+            return "avx2";
+        case vector_kernel::neon:
+            return "neon";
+        case vector_kernel::scalar:
+        default:
+            return "scalar";
+    }
+}
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
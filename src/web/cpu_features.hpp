@@ -0,0 +1,62 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef LIBBITCOIN_PROTOCOL_WEB_CPU_FEATURES_HPP
+#define LIBBITCOIN_PROTOCOL_WEB_CPU_FEATURES_HPP
+
+#include <string>
+#include <bitcoin/protocol/web/vector_kernel.hpp>
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define CPU_FEATURES_X64
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define CPU_FEATURES_ARM64
+    #include <arm_neon.h>
+#endif
+
+// AVX2 is compiled for a marked function alone, it is only run if detected.
+#if defined(CPU_FEATURES_X64) && !defined(_MSC_VER)
+    #define CPU_FEATURES_AVX2 __attribute__((target("avx2")))
+#else
+    #define CPU_FEATURES_AVX2
+#endif
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+// Runtime detection of the vector kernels supported by this build and
+// processor, shared by the vectorized websocket codecs.
+class cpu_features
+{
+public:
+    // The fastest kernel supported by this build and processor.
+    static vector_kernel best();
+    static bool supported(vector_kernel type);
+    static std::string to_string(vector_kernel type);
+};
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
+
+#endif
@@ -0,0 +1,128 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/protocol/web/file_pool.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <bitcoin/system.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+using namespace bc::system;
+
+constexpr size_t file_pool::default_threads;
+
+file_pool::file_pool(size_t threads)
+  : threads_(std::max(threads, size_t{ 1 })),
+    stopped_(false)
+{
+}
+
+file_pool::~file_pool()
+{
+    stop();
+}
+
+bool file_pool::post(job work)
+{
+    // Critical Section.
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (stopped_)
+            return false;
+
+        jobs_.push_back(std::move(work));
+
+        // Only the posting (manager) thread starts workers.
+        while (workers_.size() < threads_)
+            workers_.push_back(std::make_shared<asio::thread>(
+                &file_pool::run, this));
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    condition_.notify_one();
+    return true;
+}
+
+void file_pool::stop()
+{
+    std::vector<thread_ptr> workers;
+
+    // Critical Section.
+    ///////////////////////////////////////////////////////////////////////////
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+        jobs_.clear();
+        workers_.swap(workers);
+    }
+    ///////////////////////////////////////////////////////////////////////////
+
+    condition_.notify_all();
+
+    for (const auto& worker: workers)
+        worker->join();
+}
+
+size_t file_pool::pending() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return jobs_.size();
+}
+
+// private
+// ----------------------------------------------------------------------------
+
+void file_pool::run()
+{
+    while (true)
+    {
+        job work;
+
+        // Critical Section.
+        ///////////////////////////////////////////////////////////////////////
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]()
+            {
+                return stopped_ || !jobs_.empty();
+            });
+
+            if (stopped_)
+                return;
+
+            work = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        ///////////////////////////////////////////////////////////////////////
+
+        work();
+    }
+}
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
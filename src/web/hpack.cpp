@@ -0,0 +1,469 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/protocol/web/hpack.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <bitcoin/system.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+using namespace bc::system;
+
+constexpr size_t hpack::default_table_size;
+constexpr size_t hpack::default_list_size;
+
+// Entries are charged their octets plus 32 (RFC 7541 section 4.1).
+static constexpr size_t entry_overhead = 32;
+
+struct static_entry
+{
+    const char* name;
+    const char* value;
+};
+
+// RFC 7541 Appendix A, index 1 is the first entry.
+static const std::array<static_entry, 61> static_table
+{
+    {
+        { ":authority", "" },
+        { ":method", "GET" },
+        { ":method", "POST" },
+        { ":path", "/" },
+        { ":path", "/index.html" },
+        { ":scheme", "http" },
+        { ":scheme", "https" },
+        { ":status", "200" },
+        { ":status", "204" },
+        { ":status", "206" },
+        { ":status", "304" },
+        { ":status", "400" },
+        { ":status", "404" },
+        { ":status", "500" },
+        { "accept-charset", "" },
+        { "accept-encoding", "gzip, deflate" },
+        { "accept-language", "" },
+        { "accept-ranges", "" },
+        { "accept", "" },
+        { "access-control-allow-origin", "" },
+        { "age", "" },
+        { "allow", "" },
+        { "authorization", "" },
+        { "cache-control", "" },
+        { "content-disposition", "" },
+        { "content-encoding", "" },
+        { "content-language", "" },
+        { "content-length", "" },
+        { "content-location", "" },
+        { "content-range", "" },
+        { "content-type", "" },
+        { "cookie", "" },
+        { "date", "" },
+        { "etag", "" },
+        { "expect", "" },
+        { "expires", "" },
+        { "from", "" },
+        { "host", "" },
+        { "if-match", "" },
+        { "if-modified-since", "" },
+        { "if-none-match", "" },
+        { "if-range", "" },
+        { "if-unmodified-since", "" },
+        { "last-modified", "" },
+        { "link", "" },
+        { "location", "" },
+        { "max-forwards", "" },
+        { "proxy-authenticate", "" },
+        { "proxy-authorization", "" },
+        { "range", "" },
+        { "referer", "" },
+        { "refresh", "" },
+        { "retry-after", "" },
+        { "server", "" },
+        { "set-cookie", "" },
+        { "strict-transport-security", "" },
+        { "transfer-encoding", "" },
+        { "user-agent", "" },
+        { "vary", "" },
+        { "via", "" },
+        { "www-authenticate", "" }
+    }
+};
+
+// Huffman code lengths by symbol (RFC 7541 Appendix B), symbol 256 is EOS.
+// The code is canonical, so the codes follow from the lengths alone.
+static const std::array<uint8_t, 257> code_lengths
+{
+    {
+        13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+        28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+        6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+        5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+        13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+        7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+        15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+        6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+        20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+        24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+        22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+        21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+        26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+        19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+        20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+        26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+        30
+    }
+};
+
+static constexpr size_t maximum_code_length = 30;
+static constexpr uint16_t end_of_string = 256;
+
+// Canonical decoding tables, the first code and symbol offset by length.
+struct huffman_table
+{
+    huffman_table()
+      : first{}, count{}, offset{}, symbols{}
+    {
+        for (const auto length: code_lengths)
+            ++count[length];
+
+        uint32_t code = 0;
+        uint32_t position = 0;
+        for (size_t length = 1; length <= maximum_code_length; ++length)
+        {
+            first[length] = code;
+            offset[length] = position;
+            position += count[length];
+            code = (code + count[length]) << 1;
+        }
+
+        // Symbols are ordered by code length, then by value.
+        std::array<uint32_t, maximum_code_length + 1> next(offset);
+        for (uint16_t symbol = 0; symbol < code_lengths.size(); ++symbol)
+            symbols[next[code_lengths[symbol]]++] = symbol;
+    }
+
+    std::array<uint32_t, maximum_code_length + 1> first;
+    std::array<uint32_t, maximum_code_length + 1> count;
+    std::array<uint32_t, maximum_code_length + 1> offset;
+    std::array<uint16_t, 257> symbols;
+};
+
+hpack::hpack(size_t maximum_table_size, size_t maximum_list_size)
+  : maximum_table_size_(maximum_table_size),
+    maximum_list_size_(maximum_list_size),
+    table_limit_(maximum_table_size),
+    table_size_(0)
+{
+}
+
+bool hpack::decode(header_list& out, const uint8_t* data, size_t size)
+{
+    auto it = data;
+    const auto end = data + size;
+
+    // Small references to large entries would otherwise expand the block
+    // without limit.
+    size_t list_size = 0;
+    const auto append = [&](header&& entry)
+    {
+        list_size += entry.first.size() + entry.second.size() + entry_overhead;
+        if (list_size > maximum_list_size_)
+            return false;
+
+        out.push_back(std::move(entry));
+        return true;
+    };
+
+    while (it != end)
+    {
+        const auto octet = *it;
+        size_t index;
+        header entry;
+
+        // Indexed header field (section 6.1).
+        if ((octet & 0x80) != 0)
+        {
+            if (!decode_integer(index, it, end, 7) || !find(entry, index) ||
+                !append(std::move(entry)))
+                return false;
+
+            continue;
+        }
+
+        // Dynamic table size update (section 6.3).
+        if ((octet & 0xe0) == 0x20)
+        {
+            if (!decode_integer(index, it, end, 5) ||
+                index > maximum_table_size_)
+                return false;
+
+            table_limit_ = index;
+            evict(table_limit_);
+            continue;
+        }
+
+        // Literal with incremental indexing (6.2.1), without indexing
+        // (6.2.2) or never indexed (6.2.3).
+        const auto indexing = (octet & 0xc0) == 0x40;
+        if (!decode_integer(index, it, end, indexing ? 6 : 4))
+            return false;
+
+        if (index == 0)
+        {
+            if (!decode_string(entry.first, it, end))
+                return false;
+        }
+        else if (!find(entry, index))
+        {
+            return false;
+        }
+
+        if (!decode_string(entry.second, it, end))
+            return false;
+
+        if (indexing)
+            insert(entry);
+
+        if (!append(std::move(entry)))
+            return false;
+    }
+
+    return true;
+}
+
+size_t hpack::table_size() const
+{
+    return table_size_;
+}
+
+void hpack::encode(data_chunk& out, const header_list& headers)
+{
+    for (const auto& header: headers)
+    {
+        size_t name_index = 0;
+        size_t full_index = 0;
+
+        for (size_t index = 0; index < static_table.size(); ++index)
+        {
+            const auto& entry = static_table[index];
+            if (header.first != entry.name)
+                continue;
+
+            if (name_index == 0)
+                name_index = index + 1;
+
+            if (header.second == entry.value)
+            {
+                full_index = index + 1;
+                break;
+            }
+        }
+
+        if (full_index != 0)
+        {
+            encode_integer(out, full_index, 7, 0x80);
+            continue;
+        }
+
+        // Literal without indexing, strings are not Huffman coded.
+        encode_integer(out, name_index, 4, 0x00);
+
+        if (name_index == 0)
+        {
+            encode_integer(out, header.first.size(), 7, 0x00);
+            out.insert(out.end(), header.first.begin(), header.first.end());
+        }
+
+        encode_integer(out, header.second.size(), 7, 0x00);
+        out.insert(out.end(), header.second.begin(), header.second.end());
+    }
+}
+
+void hpack::encode_integer(data_chunk& out, size_t value, uint8_t prefix_bits,
+    uint8_t flags)
+{
+    const size_t limit = (1u << prefix_bits) - 1u;
+
+    if (value < limit)
+    {
+        out.push_back(static_cast<uint8_t>(flags | value));
+        return;
+    }
+
+    out.push_back(static_cast<uint8_t>(flags | limit));
+    value -= limit;
+
+    for (; value >= 0x80; value >>= 7)
+        out.push_back(static_cast<uint8_t>(0x80 | (value & 0x7f)));
+
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+bool hpack::decode_integer(size_t& out, const uint8_t*& it,
+    const uint8_t* end, uint8_t prefix_bits)
+{
+    // Values beyond 2^28 are not needed by any conforming peer.
+    static constexpr size_t maximum_shift = 28;
+
+    if (it == end)
+        return false;
+
+    const size_t limit = (1u << prefix_bits) - 1u;
+    out = *it++ & limit;
+
+    if (out < limit)
+        return true;
+
+    for (size_t shift = 0; shift <= maximum_shift; shift += 7)
+    {
+        if (it == end)
+            return false;
+
+        const auto octet = *it++;
+        out += static_cast<size_t>(octet & 0x7f) << shift;
+
+        if ((octet & 0x80) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+bool hpack::decode_huffman(std::string& out, const uint8_t* data, size_t size)
+{
+    static const huffman_table table;
+
+    uint32_t code = 0;
+    size_t length = 0;
+
+    for (size_t index = 0; index < size; ++index)
+    {
+        for (auto bit = 7; bit >= 0; --bit)
+        {
+            code = (code << 1) | ((data[index] >> bit) & 1u);
+            ++length;
+
+            if (code - table.first[length] < table.count[length] &&
+                code >= table.first[length])
+            {
+                const auto symbol = table.symbols[table.offset[length] +
+                    code - table.first[length]];
+
+                // A decoded end of string symbol is an error (section 5.2).
+                if (symbol == end_of_string)
+                    return false;
+
+                out.push_back(static_cast<char>(symbol));
+                code = 0;
+                length = 0;
+            }
+            else if (length == maximum_code_length)
+            {
+                return false;
+            }
+        }
+    }
+
+    // Padding is fewer than eight bits of the end of string prefix (ones).
+    return length < 8 && code == (1u << length) - 1u;
+}
+
+// private
+// ----------------------------------------------------------------------------
+
+bool hpack::decode_string(std::string& out, const uint8_t*& it,
+    const uint8_t* end)
+{
+    if (it == end)
+        return false;
+
+    const auto huffman = (*it & 0x80) != 0;
+    size_t length;
+    if (!decode_integer(length, it, end, 7) ||
+        length > static_cast<size_t>(end - it))
+        return false;
+
+    const auto data = it;
+    it += length;
+
+    if (huffman)
+        return decode_huffman(out, data, length);
+
+    out.assign(reinterpret_cast<const char*>(data), length);
+    return true;
+}
+
+bool hpack::find(header& out, size_t index) const
+{
+    if (index == 0)
+        return false;
+
+    if (index <= static_table.size())
+    {
+        const auto& entry = static_table[index - 1];
+        out.first = entry.name;
+        out.second = entry.value;
+        return true;
+    }
+
+    index -= static_table.size() + 1;
+    if (index >= table_.size())
+        return false;
+
+    out = table_[index];
+    return true;
+}
+
+void hpack::insert(const header& entry)
+{
+    const auto size = entry.first.size() + entry.second.size() +
+        entry_overhead;
+
+    // An entry larger than the table empties it (section 4.4).
+    if (size > table_limit_)
+    {
+        evict(0);
+        return;
+    }
+
+    evict(table_limit_ - size);
+    table_.push_front(entry);
+    table_size_ += size;
+}
+
+void hpack::evict(size_t maximum)
+{
+    while (table_size_ > maximum && !table_.empty())
+    {
+        const auto& entry = table_.back();
+        table_size_ -= entry.first.size() + entry.second.size() +
+            entry_overhead;
+        table_.pop_back();
+    }
+}
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
@@ -0,0 +1,811 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/protocol/web/http2_session.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <bitcoin/system.hpp>
+#include <bitcoin/protocol/web/hpack.hpp>
+#include <bitcoin/protocol/web/http_request.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+using namespace bc::system;
+
+const std::string http2_session::preface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+constexpr size_t http2_session::frame_header_size;
+constexpr uint32_t http2_session::default_window_size;
+constexpr uint32_t http2_session::default_frame_size;
+constexpr uint32_t http2_session::default_concurrent_streams;
+
+// Frame flags (RFC 7540 section 6).
+static constexpr uint8_t flag_end_stream = 0x01;
+static constexpr uint8_t flag_ack = 0x01;
+static constexpr uint8_t flag_end_headers = 0x04;
+static constexpr uint8_t flag_padded = 0x08;
+static constexpr uint8_t flag_priority = 0x20;
+
+// Settings identifiers (RFC 7540 section 6.5.2).
+static constexpr uint16_t settings_enable_push = 0x2;
+static constexpr uint16_t settings_max_concurrent_streams = 0x3;
+static constexpr uint16_t settings_initial_window_size = 0x4;
+static constexpr uint16_t settings_max_frame_size = 0x5;
+static constexpr uint16_t settings_max_header_list_size = 0x6;
+
+static constexpr int64_t maximum_window_size = 0x7fffffff;
+static constexpr uint32_t maximum_frame_size = 0xffffff;
+
+// Bounds the header block accumulated over CONTINUATION frames.
+static constexpr size_t maximum_header_block = 65536;
+
+static uint32_t read_32(const uint8_t* data)
+{
+    return (static_cast<uint32_t>(data[0]) << 24) |
+        (static_cast<uint32_t>(data[1]) << 16) |
+        (static_cast<uint32_t>(data[2]) << 8) | data[3];
+}
+
+static void write_32(data_chunk& out, uint32_t value)
+{
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+static std::string to_lower(std::string value)
+{
+    std::transform(value.begin(), value.end(), value.begin(),
+        [](char character)
+        {
+            return static_cast<char>(std::tolower(
+                static_cast<unsigned char>(character)));
+        });
+
+    return value;
+}
+
+// Remove the padding (and priority) of DATA and HEADERS payloads.
+static bool strip_padding(const uint8_t*& payload, size_t& size,
+    uint8_t flags, bool priority)
+{
+    size_t padding = 0;
+    if ((flags & flag_padded) != 0)
+    {
+        if (size == 0)
+            return false;
+
+        padding = payload[0];
+        ++payload;
+        --size;
+    }
+
+    if (priority && (flags & flag_priority) != 0)
+    {
+        if (size < 5)
+            return false;
+
+        payload += 5;
+        size -= 5;
+    }
+
+    if (padding > size)
+        return false;
+
+    size -= padding;
+    return true;
+}
+
+bool http2_session::match_preface(const uint8_t* data, size_t size)
+{
+    const auto length = std::min(size, preface.size());
+    return std::equal(data, data + length, preface.begin());
+}
+
+http2_session::http2_session(size_t maximum_body, uint32_t concurrent_streams)
+  : maximum_body_(maximum_body),
+    concurrent_streams_(concurrent_streams),
+    preface_received_(false),
+    closing_(false),
+    last_stream_(0),
+    continuation_stream_(0),
+    continuation_end_stream_(false),
+    cancellations_(0),
+    peer_frame_size_(default_frame_size),
+    peer_window_size_(default_window_size),
+    send_window_(default_window_size)
+{
+}
+
+bool http2_session::receive(request_list& out, data_chunk& input,
+    data_chunk& output)
+{
+    if (!preface_received_)
+    {
+        if (input.size() < preface.size())
+            return true;
+
+        if (!match_preface(input.data(), input.size()))
+        {
+            fail(error::protocol_error);
+            output.insert(output.end(), replies_.begin(), replies_.end());
+            replies_.clear();
+            return false;
+        }
+
+        input.erase(input.begin(), input.begin() + preface.size());
+        preface_received_ = true;
+
+        // The server preface is its settings, other values are defaults.
+        data_chunk settings;
+        settings.push_back(0x00);
+        settings.push_back(settings_max_concurrent_streams);
+        write_32(settings, concurrent_streams_);
+        settings.push_back(0x00);
+        settings.push_back(settings_max_header_list_size);
+        write_32(settings, hpack::default_list_size);
+        write_frame(replies_, frame_type::settings, 0, 0, settings.data(),
+            settings.size());
+    }
+
+    auto result = true;
+    size_t offset = 0;
+
+    while (result && input.size() - offset >= frame_header_size)
+    {
+        const auto header = input.data() + offset;
+        const size_t length = (static_cast<size_t>(header[0]) << 16) |
+            (static_cast<size_t>(header[1]) << 8) | header[2];
+
+        // No larger frame size is advertised.
+        if (length > default_frame_size)
+        {
+            result = fail(error::frame_size_error);
+            break;
+        }
+
+        if (input.size() - offset < frame_header_size + length)
+            break;
+
+        const auto stream = read_32(header + 5) & 0x7fffffff;
+        result = handle_frame(out, header[3], header[4], stream,
+            header + frame_header_size, length);
+
+        offset += frame_header_size + length;
+    }
+
+    input.erase(input.begin(), input.begin() + offset);
+    output.insert(output.end(), replies_.begin(), replies_.end());
+    replies_.clear();
+    return result;
+}
+
+void http2_session::respond(uint32_t stream, protocol_status status,
+    const hpack::header_list& fields, const std::string& body)
+{
+    const auto it = streams_.find(stream);
+    if (it == streams_.end() || it->second.responded ||
+        it->second.cancelled)
+    {
+        LOG_VERBOSE(LOG_PROTOCOL_HTTP)
+            << "Dropping response to closed HTTP/2 stream " << stream;
+
+        if (it != streams_.end() && it->second.cancelled)
+            streams_.erase(it);
+
+        return;
+    }
+
+    // An answered request offsets an earlier cancellation.
+    if (cancellations_ != 0)
+        --cancellations_;
+
+    hpack::header_list headers
+    {
+        { ":status", std::to_string(static_cast<uint16_t>(status)) }
+    };
+
+    headers.insert(headers.end(), fields.begin(), fields.end());
+    headers.emplace_back("content-length", std::to_string(body.size()));
+
+    data_chunk block;
+    hpack::encode(block, headers);
+
+    // A header block larger than a frame continues in CONTINUATION frames.
+    auto type = frame_type::headers;
+    auto flags = body.empty() ? flag_end_stream : uint8_t(0);
+    for (size_t offset = 0; offset < block.size();)
+    {
+        const auto size = std::min<size_t>(block.size() - offset,
+            peer_frame_size_);
+
+        if (offset + size == block.size())
+            flags |= flag_end_headers;
+
+        write_frame(replies_, type, flags, stream, block.data() + offset,
+            size);
+
+        type = frame_type::continuation;
+        flags = 0;
+        offset += size;
+    }
+
+    if (body.empty())
+    {
+        streams_.erase(it);
+        return;
+    }
+
+    auto& state = it->second;
+    state.responded = true;
+    state.response = body;
+    state.sent = 0;
+}
+
+void http2_session::flush(data_chunk& output, size_t high_water)
+{
+    output.insert(output.end(), replies_.begin(), replies_.end());
+    replies_.clear();
+
+    // Streams are served a frame at a time in turn.
+    auto progress = true;
+    while (progress && send_window_ > 0 && output.size() < high_water)
+    {
+        progress = false;
+        for (auto it = streams_.begin(); it != streams_.end() &&
+            send_window_ > 0 && output.size() < high_water;)
+        {
+            auto& state = it->second;
+            if (!state.responded || state.send_window <= 0)
+            {
+                ++it;
+                continue;
+            }
+
+            const auto remaining = state.response.size() - state.sent;
+            const auto size = static_cast<size_t>(std::min<int64_t>(
+                std::min<int64_t>(remaining, peer_frame_size_),
+                std::min(send_window_, state.send_window)));
+
+            const auto last = (size == remaining);
+            const auto data = reinterpret_cast<const uint8_t*>(
+                state.response.data()) + state.sent;
+
+            write_frame(output, frame_type::data,
+                last ? flag_end_stream : 0, it->first, data, size);
+
+            state.sent += size;
+            state.send_window -= size;
+            send_window_ -= size;
+            progress = true;
+
+            if (last)
+                it = streams_.erase(it);
+            else
+                ++it;
+        }
+    }
+}
+
+bool http2_session::writable() const
+{
+    if (!replies_.empty())
+        return true;
+
+    if (send_window_ <= 0)
+        return false;
+
+    for (const auto& stream: streams_)
+        if (stream.second.responded && stream.second.send_window > 0)
+            return true;
+
+    return false;
+}
+
+bool http2_session::closing() const
+{
+    return closing_;
+}
+
+size_t http2_session::streams() const
+{
+    return streams_.size();
+}
+
+void http2_session::write_frame(data_chunk& out, frame_type type,
+    uint8_t flags, uint32_t stream, const uint8_t* payload, size_t size)
+{
+    BITCOIN_ASSERT(size <= maximum_frame_size);
+    out.push_back(static_cast<uint8_t>(size >> 16));
+    out.push_back(static_cast<uint8_t>(size >> 8));
+    out.push_back(static_cast<uint8_t>(size));
+    out.push_back(static_cast<uint8_t>(type));
+    out.push_back(flags);
+    write_32(out, stream & 0x7fffffff);
+    out.insert(out.end(), payload, payload + size);
+}
+
+// private
+// ----------------------------------------------------------------------------
+
+bool http2_session::handle_frame(request_list& out, uint8_t type,
+    uint8_t flags, uint32_t stream, const uint8_t* payload, size_t size)
+{
+    // A header block must not be interleaved with any other frame.
+    if (continuation_stream_ != 0 &&
+        (type != static_cast<uint8_t>(frame_type::continuation) ||
+        stream != continuation_stream_))
+        return fail(error::protocol_error);
+
+    switch (static_cast<frame_type>(type))
+    {
+        case frame_type::data:
+            return handle_data(out, flags, stream, payload, size);
+
+        case frame_type::headers:
+            return handle_headers(out, flags, stream, payload, size);
+
+        case frame_type::continuation:
+            return handle_continuation(out, flags, stream, payload, size);
+
+        case frame_type::settings:
+            return handle_settings(flags, stream, payload, size);
+
+        case frame_type::window_update:
+            return handle_window_update(stream, payload, size);
+
+        case frame_type::priority:
+        {
+            if (stream == 0)
+                return fail(error::protocol_error);
+
+            if (size != 5)
+                reset(stream, error::frame_size_error);
+
+            return true;
+        }
+
+        case frame_type::rst_stream:
+        {
+            if (size != 4)
+                return fail(error::frame_size_error);
+
+            if (stream == 0 || stream > last_stream_)
+                return fail(error::protocol_error);
+
+            // Cancelling requests faster than they are answered (rapid
+            // reset) would otherwise start unbounded work.
+            const auto it = streams_.find(stream);
+            if (it != streams_.end() && it->second.remote_closed &&
+                !it->second.responded && !it->second.cancelled &&
+                ++cancellations_ > concurrent_streams_)
+                return fail(error::enhance_your_calm);
+
+            close(stream);
+            return true;
+        }
+
+        case frame_type::ping:
+        {
+            if (stream != 0)
+                return fail(error::protocol_error);
+
+            if (size != 8)
+                return fail(error::frame_size_error);
+
+            if ((flags & flag_ack) == 0)
+                write_frame(replies_, frame_type::ping, flag_ack, 0, payload,
+                    size);
+
+            return true;
+        }
+
+        case frame_type::goaway:
+        {
+            if (stream != 0)
+                return fail(error::protocol_error);
+
+            // Streams already open are still answered.
+            closing_ = true;
+            return true;
+        }
+
+        // Clients cannot push.
+        case frame_type::push_promise:
+            return fail(error::protocol_error);
+
+        // Unknown frame types are ignored.
+        default:
+            return true;
+    }
+}
+
+bool http2_session::handle_data(request_list& out, uint8_t flags,
+    uint32_t stream, const uint8_t* payload, size_t size)
+{
+    if (stream == 0)
+        return fail(error::protocol_error);
+
+    // The whole frame, including padding, counts against the window. The
+    // receive windows are replenished immediately since bodies are bounded.
+    const auto length = static_cast<uint32_t>(size);
+    if (length != 0)
+    {
+        data_chunk increment;
+        write_32(increment, length);
+        write_frame(replies_, frame_type::window_update, 0, 0,
+            increment.data(), increment.size());
+    }
+
+    if (!strip_padding(payload, size, flags, false))
+        return fail(error::protocol_error);
+
+    const auto it = streams_.find(stream);
+    if (it == streams_.end())
+    {
+        // Frames may still arrive on a stream that has been reset.
+        return stream <= last_stream_ || fail(error::protocol_error);
+    }
+
+    auto& state = it->second;
+    if (state.cancelled)
+        return true;
+
+    if (state.remote_closed)
+    {
+        reset(stream, error::stream_closed);
+        return true;
+    }
+
+    // Check for configuration violation (DoS protection).
+    if (state.body.size() + size > maximum_body_)
+    {
+        LOG_VERBOSE(LOG_PROTOCOL_HTTP)
+            << "Resetting HTTP/2 stream " << stream
+            << " due to excessive content length.";
+        reset(stream, error::enhance_your_calm);
+        return true;
+    }
+
+    state.body.insert(state.body.end(), payload, payload + size);
+
+    if ((flags & flag_end_stream) != 0)
+    {
+        complete(out, it);
+        return true;
+    }
+
+    if (length != 0)
+    {
+        data_chunk increment;
+        write_32(increment, length);
+        write_frame(replies_, frame_type::window_update, 0, stream,
+            increment.data(), increment.size());
+    }
+
+    return true;
+}
+
+bool http2_session::handle_headers(request_list& out, uint8_t flags,
+    uint32_t stream, const uint8_t* payload, size_t size)
+{
+    // Client initiated streams are odd.
+    if (stream == 0 || (stream % 2) == 0)
+        return fail(error::protocol_error);
+
+    if (!strip_padding(payload, size, flags, true))
+        return fail(error::protocol_error);
+
+    const auto end_stream = (flags & flag_end_stream) != 0;
+    const auto it = streams_.find(stream);
+
+    if (it != streams_.end())
+    {
+        // Only trailers may follow the request headers.
+        if (it->second.remote_closed || !end_stream)
+            return fail(error::protocol_error);
+    }
+    else if (stream <= last_stream_)
+    {
+        return fail(error::stream_closed);
+    }
+    else
+    {
+        last_stream_ = stream;
+    }
+
+    header_block_.assign(payload, payload + size);
+
+    if ((flags & flag_end_headers) != 0)
+        return end_headers(out, stream, end_stream);
+
+    continuation_stream_ = stream;
+    continuation_end_stream_ = end_stream;
+    return true;
+}
+
+bool http2_session::handle_continuation(request_list& out, uint8_t flags,
+    uint32_t stream, const uint8_t* payload, size_t size)
+{
+    if (continuation_stream_ == 0)
+        return fail(error::protocol_error);
+
+    if (header_block_.size() + size > maximum_header_block)
+        return fail(error::enhance_your_calm);
+
+    header_block_.insert(header_block_.end(), payload, payload + size);
+
+    if ((flags & flag_end_headers) == 0)
+        return true;
+
+    return end_headers(out, stream, continuation_end_stream_);
+}
+
+bool http2_session::handle_settings(uint8_t flags, uint32_t stream,
+    const uint8_t* payload, size_t size)
+{
+    if (stream != 0)
+        return fail(error::protocol_error);
+
+    if ((flags & flag_ack) != 0)
+        return size == 0 || fail(error::frame_size_error);
+
+    if ((size % 6) != 0)
+        return fail(error::frame_size_error);
+
+    for (auto it = payload; it != payload + size; it += 6)
+    {
+        const auto identifier = static_cast<uint16_t>((it[0] << 8) | it[1]);
+        const auto value = read_32(it + 2);
+
+        switch (identifier)
+        {
+            case settings_enable_push:
+            {
+                if (value > 1)
+                    return fail(error::protocol_error);
+
+                break;
+            }
+
+            // Changes apply to the send window of every open stream.
+            case settings_initial_window_size:
+            {
+                if (value > maximum_window_size)
+                    return fail(error::flow_control_error);
+
+                const auto delta = static_cast<int64_t>(value) -
+                    peer_window_size_;
+
+                for (auto& open: streams_)
+                {
+                    open.second.send_window += delta;
+                    if (open.second.send_window > maximum_window_size)
+                        return fail(error::flow_control_error);
+                }
+
+                peer_window_size_ = value;
+                break;
+            }
+
+            case settings_max_frame_size:
+            {
+                if (value < default_frame_size || value > maximum_frame_size)
+                    return fail(error::protocol_error);
+
+                peer_frame_size_ = value;
+                break;
+            }
+
+            // Other settings do not constrain this server.
+            default:
+                break;
+        }
+    }
+
+    write_frame(replies_, frame_type::settings, flag_ack, 0, nullptr, 0);
+    return true;
+}
+
+bool http2_session::handle_window_update(uint32_t stream,
+    const uint8_t* payload, size_t size)
+{
+    if (size != 4)
+        return fail(error::frame_size_error);
+
+    const auto increment = read_32(payload) & 0x7fffffff;
+
+    if (stream == 0)
+    {
+        if (increment == 0)
+            return fail(error::protocol_error);
+
+        send_window_ += increment;
+        return send_window_ <= maximum_window_size ||
+            fail(error::flow_control_error);
+    }
+
+    if (increment == 0)
+    {
+        reset(stream, error::protocol_error);
+        return true;
+    }
+
+    const auto it = streams_.find(stream);
+    if (it == streams_.end())
+        return true;
+
+    it->second.send_window += increment;
+    if (it->second.send_window > maximum_window_size)
+        reset(stream, error::flow_control_error);
+
+    return true;
+}
+
+bool http2_session::end_headers(request_list& out, uint32_t stream,
+    bool end_stream)
+{
+    // Every block is decoded in order to maintain the dynamic table.
+    hpack::header_list headers;
+    if (!decoder_.decode(headers, header_block_.data(), header_block_.size()))
+        return fail(error::compression_error);
+
+    header_block_.clear();
+    continuation_stream_ = 0;
+
+    auto it = streams_.find(stream);
+    if (it == streams_.end())
+    {
+        if (closing_)
+            return true;
+
+        if (streams_.size() >= concurrent_streams_)
+        {
+            reset(stream, error::refused_stream);
+            return true;
+        }
+
+        it = streams_.emplace(stream, stream_state{ peer_window_size_, false,
+            false, {}, std::move(headers), {}, 0, false }).first;
+    }
+
+    // Trailers are accepted but not used.
+    if (end_stream)
+        complete(out, it);
+
+    return true;
+}
+
+// Requests are presented as their HTTP/1.1 equivalent, with lower case
+// method and header values.
+void http2_session::complete(request_list& out, stream_map::iterator it)
+{
+    auto& state = it->second;
+    state.remote_closed = true;
+
+    http_request request;
+    request.protocol = "http";
+    request.protocol_version = 2.0;
+    request.message_length = state.body.size();
+    request.content_length = state.body.size();
+
+    std::string query;
+    for (const auto& header: state.headers)
+    {
+        if (header.first == ":method")
+        {
+            request.method = to_lower(header.second);
+        }
+        else if (header.first == ":path")
+        {
+            const auto separator = header.second.find('?');
+            request.uri = header.second.substr(0, separator);
+            if (separator != std::string::npos)
+                query = header.second.substr(separator + 1);
+        }
+        else if (header.first == ":authority")
+        {
+            request.headers["host"] = to_lower(header.second);
+        }
+        else if (!header.first.empty() && header.first[0] != ':')
+        {
+            request.headers[to_lower(header.first)] = to_lower(header.second);
+        }
+    }
+
+    while (!query.empty())
+    {
+        const auto next = query.find('&');
+        const auto pair = query.substr(0, next);
+        query = (next == std::string::npos) ? std::string{} :
+            query.substr(next + 1);
+
+        const auto equals = pair.find('=');
+        if (equals == std::string::npos || equals == 0 ||
+            pair.find('=', equals + 1) != std::string::npos)
+            continue;
+
+        request.parameters[to_lower(pair.substr(0, equals))] =
+            to_lower(pair.substr(equals + 1));
+    }
+
+    if (request.method == "post" && !state.body.empty())
+    {
+        const std::string json_request(state.body.begin(), state.body.end());
+        request.json_rpc = property_tree(request.json_tree, json_request);
+    }
+
+    state.headers.clear();
+    state.body.clear();
+    state.body.shrink_to_fit();
+    out.push_back({ it->first, std::move(request) });
+}
+
+void http2_session::reset(uint32_t stream, error code)
+{
+    data_chunk payload;
+    write_32(payload, static_cast<uint32_t>(code));
+    write_frame(replies_, frame_type::rst_stream, 0, stream, payload.data(),
+        payload.size());
+
+    close(stream);
+}
+
+// A dispatched request remains counted against the concurrency limit until
+// its response is dropped, as the work it started continues.
+void http2_session::close(uint32_t stream)
+{
+    const auto it = streams_.find(stream);
+    if (it == streams_.end())
+        return;
+
+    auto& state = it->second;
+    if (state.remote_closed && !state.responded)
+    {
+        state.cancelled = true;
+        state.body.clear();
+        return;
+    }
+
+    streams_.erase(it);
+}
+
+bool http2_session::fail(error code)
+{
+    LOG_VERBOSE(LOG_PROTOCOL_HTTP)
+        << "HTTP/2 connection error " << static_cast<uint32_t>(code);
+
+    data_chunk payload;
+    write_32(payload, last_stream_);
+    write_32(payload, static_cast<uint32_t>(code));
+    write_frame(replies_, frame_type::goaway, 0, 0, payload.data(),
+        payload.size());
+
+    closing_ = true;
+    return false;
+}
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
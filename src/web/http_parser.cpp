@@ -0,0 +1,459 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/protocol/web/http_parser.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <boost/algorithm/string.hpp>
+#include <bitcoin/system.hpp>
+#include <bitcoin/protocol/web/http.hpp>
+#include <bitcoin/protocol/web/utilities.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+using namespace bc::system;
+
+static constexpr char space = ' ';
+static constexpr char tab = '\t';
+static constexpr char colon = ':';
+static constexpr char carriage_return = '\r';
+static constexpr char line_feed = '\n';
+
+// RFC 7230 section 3.2.6 token characters.
+static bool is_token(char character)
+{
+    static const std::string delimiters = "\"(),/:;<=>?@[\\]{}";
+    const auto value = static_cast<uint8_t>(character);
+    return value > 0x20 && value < 0x7f &&
+        delimiters.find(character) == std::string::npos;
+}
+
+static bool is_whitespace(char character)
+{
+    return character == space || character == tab;
+}
+
+static char to_lower(char character)
+{
+    return (character >= 'A' && character <= 'Z') ?
+        static_cast<char>(character - 'A' + 'a') : character;
+}
+
+static bool equals_insensitive(const http_parser::string_view& left,
+    const http_parser::string_view& right)
+{
+    if (left.size() != right.size())
+        return false;
+
+    for (size_t index = 0; index < left.size(); ++index)
+        if (to_lower(left[index]) != to_lower(right[index]))
+            return false;
+
+    return true;
+}
+
+static std::string to_lower_string(const http_parser::string_view& value)
+{
+    std::string out(value.size(), 0);
+    std::transform(value.begin(), value.end(), out.begin(), to_lower);
+    return out;
+}
+
+http_parser::http_parser()
+{
+    reset();
+}
+
+void http_parser::reset()
+{
+    data_ = nullptr;
+    size_ = 0;
+    position_ = 0;
+    state_ = state::request_line;
+    method_ = { 0, 0 };
+    target_ = { 0, 0 };
+    path_ = { 0, 0 };
+    query_ = { 0, 0 };
+    protocol_ = { 0, 0 };
+    minor_version_ = 0;
+    header_count_ = 0;
+    header_length_ = 0;
+    content_length_ = 0;
+}
+
+http_parser::result http_parser::parse(const uint8_t* data, size_t size)
+{
+    data_ = reinterpret_cast<const char*>(data);
+    size_ = size;
+
+    if (state_ == state::error)
+        return result::error;
+
+    // Only complete lines are consumed, so a line split across reads is
+    // rescanned from its start, which is bounded by maximum_header_length.
+    while (state_ == state::request_line || state_ == state::headers)
+    {
+        const auto remaining = size_ - position_;
+        const auto start = data_ + position_;
+        const auto found = static_cast<const char*>(
+            std::memchr(start, line_feed, remaining));
+
+        if (found == nullptr)
+            return size_ > maximum_header_length ? fail() : result::incomplete;
+
+        const auto begin = position_;
+        const auto newline = static_cast<size_t>(found - data_);
+        auto end = newline;
+        if (end > begin && data_[end - 1] == carriage_return)
+            --end;
+
+        if (newline >= maximum_header_length)
+            return fail();
+
+        position_ = newline + 1;
+
+        if (state_ == state::request_line)
+        {
+            // RFC 7230 section 3.5, ignore empty lines preceding a request.
+            if (begin == end)
+                continue;
+
+            if (!parse_request_line(begin, end))
+                return fail();
+
+            state_ = state::headers;
+            continue;
+        }
+
+        if (begin == end)
+        {
+            header_length_ = position_;
+            if (!parse_content_length())
+                return fail();
+
+            state_ = state::body;
+            break;
+        }
+
+        if (!parse_header_line(begin, end))
+            return fail();
+    }
+
+    if (state_ == state::body)
+    {
+        if (size_ - header_length_ < content_length_)
+            return result::incomplete;
+
+        state_ = state::complete;
+    }
+
+    return result::complete;
+}
+
+http_parser::result http_parser::fail()
+{
+    state_ = state::error;
+    return result::error;
+}
+
+// request-line = method SP request-target SP HTTP-version
+bool http_parser::parse_request_line(size_t begin, size_t end)
+{
+    auto position = begin;
+    while (position < end && is_token(data_[position]))
+        ++position;
+
+    if (position == begin || position == end || data_[position] != space)
+        return false;
+
+    method_ = { begin, position - begin };
+
+    const auto target = ++position;
+    while (position < end && data_[position] != space)
+        ++position;
+
+    if (position == target || position == end)
+        return false;
+
+    target_ = { target, position - target };
+
+    const auto separator = static_cast<const char*>(std::memchr(
+        data_ + target, '?', target_.length));
+
+    if (separator == nullptr)
+    {
+        path_ = target_;
+        query_ = { position, 0 };
+    }
+    else
+    {
+        const auto offset = static_cast<size_t>(separator - data_);
+        path_ = { target, offset - target };
+        query_ = { offset + 1, position - offset - 1 };
+    }
+
+    const auto protocol = ++position;
+    protocol_ = { protocol, end - protocol };
+
+    // Only HTTP/1.x is accepted.
+    static const string_view prefix{ "HTTP/1." };
+    const auto version = view(protocol_);
+    if (version.size() != prefix.size() + 1 ||
+        !equals_insensitive(version.substr(0, prefix.size()), prefix))
+        return false;
+
+    const auto minor = version.back();
+    if (minor < '0' || minor > '9')
+        return false;
+
+    minor_version_ = static_cast<uint8_t>(minor - '0');
+    return true;
+}
+
+// header-field = field-name ":" OWS field-value OWS
+bool http_parser::parse_header_line(size_t begin, size_t end)
+{
+    // Obsolete line folding is rejected (RFC 7230 section 3.2.4).
+    if (header_count_ == maximum_headers || is_whitespace(data_[begin]))
+        return false;
+
+    auto position = begin;
+    while (position < end && is_token(data_[position]))
+        ++position;
+
+    if (position == begin || position == end || data_[position] != colon)
+        return false;
+
+    const span name{ begin, position - begin };
+
+    ++position;
+    while (position < end && is_whitespace(data_[position]))
+        ++position;
+
+    auto last = end;
+    while (last > position && is_whitespace(data_[last - 1]))
+        --last;
+
+    headers_[header_count_++] = { name, { position, last - position } };
+    return true;
+}
+
+bool http_parser::parse_content_length()
+{
+    // Chunked request bodies are not supported.
+    if (!header("transfer-encoding").empty())
+        return false;
+
+    const auto value = header("content-length");
+    if (value.empty())
+    {
+        content_length_ = 0;
+        return true;
+    }
+
+    // Repeated fields must agree, or the message length is ambiguous.
+    for (size_t index = 0; index < header_count_; ++index)
+        if (equals_insensitive(view(headers_[index].name), "content-length") &&
+            view(headers_[index].value) != value)
+            return false;
+
+    static constexpr auto limit = std::numeric_limits<size_t>::max() / 10;
+
+    size_t length = 0;
+    for (const auto character: value)
+    {
+        if (character < '0' || character > '9' || length > limit)
+            return false;
+
+        length = length * 10 + static_cast<size_t>(character - '0');
+    }
+
+    if (length > std::numeric_limits<size_t>::max() - header_length_)
+        return false;
+
+    content_length_ = length;
+    return true;
+}
+
+http_parser::string_view http_parser::view(const span& value) const
+{
+    return data_ == nullptr ? string_view{} :
+        string_view{ data_ + value.offset, value.length };
+}
+
+bool http_parser::headers_complete() const
+{
+    return state_ == state::body || state_ == state::complete;
+}
+
+bool http_parser::complete() const
+{
+    return state_ == state::complete;
+}
+
+http_parser::string_view http_parser::method() const
+{
+    return view(method_);
+}
+
+http_parser::string_view http_parser::target() const
+{
+    return view(target_);
+}
+
+http_parser::string_view http_parser::path() const
+{
+    return view(path_);
+}
+
+http_parser::string_view http_parser::query() const
+{
+    return view(query_);
+}
+
+http_parser::string_view http_parser::protocol() const
+{
+    return view(protocol_);
+}
+
+uint8_t http_parser::minor_version() const
+{
+    return minor_version_;
+}
+
+size_t http_parser::header_count() const
+{
+    return header_count_;
+}
+
+http_parser::string_view http_parser::header_name(size_t index) const
+{
+    BITCOIN_ASSERT(index < header_count_);
+    return view(headers_[index].name);
+}
+
+http_parser::string_view http_parser::header_value(size_t index) const
+{
+    BITCOIN_ASSERT(index < header_count_);
+    return view(headers_[index].value);
+}
+
+http_parser::string_view http_parser::header(const string_view& name) const
+{
+    for (size_t index = 0; index < header_count_; ++index)
+        if (equals_insensitive(view(headers_[index].name), name))
+            return view(headers_[index].value);
+
+    return {};
+}
+
+size_t http_parser::header_length() const
+{
+    return header_length_;
+}
+
+size_t http_parser::content_length() const
+{
+    return content_length_;
+}
+
+size_t http_parser::message_length() const
+{
+    return header_length_ + content_length_;
+}
+
+http_parser::string_view http_parser::body() const
+{
+    if (state_ != state::complete)
+        return {};
+
+    return view({ header_length_, content_length_ });
+}
+
+bool http_parser::to_request(http_request& out) const
+{
+    if (state_ != state::complete)
+        return false;
+
+    out.method = to_lower_string(method());
+    out.uri = path().to_string();
+    out.protocol = to_lower_string(protocol());
+    out.protocol_version = 1.0 + minor_version_ / 10.0;
+    out.message_length = message_length();
+    out.content_length = content_length_;
+
+    // Values are normalized to lower case, except for the websocket key.
+    for (size_t index = 0; index < header_count_; ++index)
+    {
+        auto name = to_lower_string(header_name(index));
+        const auto value = header_value(index);
+        out.headers[name] = (name == "sec-websocket-key") ?
+            value.to_string() : to_lower_string(value);
+    }
+
+    auto parameters = query();
+    while (!parameters.empty())
+    {
+        const auto next = parameters.find('&');
+        const auto pair = parameters.substr(0, next);
+        parameters = (next == string_view::npos) ? string_view{} :
+            parameters.substr(next + 1);
+
+        const auto equals = pair.find('=');
+        if (equals == string_view::npos || equals == 0 ||
+            pair.find('=', equals + 1) != string_view::npos)
+            continue;
+
+        out.parameters[to_lower_string(pair.substr(0, equals))] =
+            to_lower_string(pair.substr(equals + 1));
+    }
+
+    const auto& headers = out.headers;
+    const auto connection = headers.find("connection");
+    out.upgrade_request = ((connection != headers.end()) &&
+        (connection->second.find("upgrade") != std::string::npos) &&
+        (headers.find("sec-websocket-key") != headers.end()));
+
+    // Determine if this request is a JSON-RPC request, or at least
+    // one that we support (i.e. non-standard; may not contain the
+    // required accept header nor the optional content-type header),
+    // via POST-only, etc.  Instead we try to safely parse the data as
+    // JSON.
+    if (out.method == "post" && out.content_length > 0)
+    {
+        const auto json_request = body().to_string();
+
+        LOG_VERBOSE(LOG_PROTOCOL_HTTP)
+            << "POST content: " << json_request;
+
+        out.json_rpc = property_tree(out.json_tree, json_request);
+    }
+
+    return true;
+}
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
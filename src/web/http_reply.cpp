@@ -22,10 +22,9 @@
 #include <cstddef>
 #include <cstdint>
 #include <ctime>
-#include <functional>
-#include <string>
 #include <sstream>
-#include <unordered_map>
+#include <string>
+#include <bitcoin/system.hpp>
 #include <bitcoin/protocol/define.hpp>
 #include <bitcoin/protocol/web/http.hpp>
 #include <bitcoin/protocol/web/protocol_status.hpp>
@@ -34,77 +33,215 @@ namespace libbitcoin {
 namespace protocol {
 namespace http {
 
-struct protocol_status_hasher
+using namespace bc::system;
+
+// Reserved for generated headers, sufficient for all but long mime types.
+static constexpr size_t maximum_header_size = 256;
+
+static constexpr size_t length(const char* text)
 {
-    size_t operator()(const protocol_status& status) const
+    return *text == '\0' ? 0 : 1 + length(text + 1);
+}
+
+struct status_line
+{
+    constexpr status_line(protocol_status status, const char* text)
+      : status(status), text(text), size(length(text))
     {
-        return std::hash<uint16_t>{}(static_cast<uint16_t>(status));
     }
+
+    const protocol_status status;
+    const char* const text;
+    const size_t size;
 };
 
-static const std::unordered_map<protocol_status, std::string,
-    protocol_status_hasher> status_strings
+static constexpr status_line status_lines[]
 {
     { protocol_status::switching, "HTTP/1.1 101 Switching Protocols\r\n" },
-    { protocol_status::ok, "HTTP/1.0 200 OK\r\n" },
-    { protocol_status::created, "HTTP/1.0 201 Created\r\n" },
-    { protocol_status::accepted, "HTTP/1.0 202 Accepted\r\n" },
-    { protocol_status::no_content, "HTTP/1.0 204 No Content\r\n" },
-    { protocol_status::multiple_choices, "HTTP/1.0 300 Multiple Choices\r\n" },
-    { protocol_status::moved_permanently, "HTTP/1.0 301 Moved Permanently\r\n" },
-    { protocol_status::moved_temporarily, "HTTP/1.0 302 Moved Temporarily\r\n" },
-    { protocol_status::not_modified, "HTTP/1.0 304 Not Modified\r\n" },
-    { protocol_status::bad_request, "HTTP/1.0 400 Bad Request\r\n" },
-    { protocol_status::unauthorized, "HTTP/1.0 401 Unauthorized\r\n" },
-    { protocol_status::forbidden, "HTTP/1.0 403 Forbidden\r\n" },
-    { protocol_status::not_found, "HTTP/1.0 404 Not Found\r\n" },
-    { protocol_status::internal_server_error, "HTTP/1.0 500 Internal Server Error\r\n" },
-    { protocol_status::not_implemented, "HTTP/1.0 501 Not Implemented\r\n" },
-    { protocol_status::bad_gateway, "HTTP/1.0 502 Bad Gateway\r\n" },
-    { protocol_status::service_unavailable, "HTTP/1.0 503 Service Unavailable\r\n" }
+    { protocol_status::ok, "HTTP/1.1 200 OK\r\n" },
+    { protocol_status::created, "HTTP/1.1 201 Created\r\n" },
+    { protocol_status::accepted, "HTTP/1.1 202 Accepted\r\n" },
+    { protocol_status::no_content, "HTTP/1.1 204 No Content\r\n" },
+    { protocol_status::partial_content, "HTTP/1.1 206 Partial Content\r\n" },
+    { protocol_status::multiple_choices, "HTTP/1.1 300 Multiple Choices\r\n" },
+    { protocol_status::moved_permanently, "HTTP/1.1 301 Moved Permanently\r\n" },
+    { protocol_status::moved_temporarily, "HTTP/1.1 302 Moved Temporarily\r\n" },
+    { protocol_status::not_modified, "HTTP/1.1 304 Not Modified\r\n" },
+    { protocol_status::bad_request, "HTTP/1.1 400 Bad Request\r\n" },
+    { protocol_status::unauthorized, "HTTP/1.1 401 Unauthorized\r\n" },
+    { protocol_status::forbidden, "HTTP/1.1 403 Forbidden\r\n" },
+    { protocol_status::not_found, "HTTP/1.1 404 Not Found\r\n" },
+    { protocol_status::method_not_allowed, "HTTP/1.1 405 Method Not Allowed\r\n" },
+    { protocol_status::range_not_satisfiable, "HTTP/1.1 416 Range Not Satisfiable\r\n" },
+    { protocol_status::internal_server_error, "HTTP/1.1 500 Internal Server Error\r\n" },
+    { protocol_status::not_implemented, "HTTP/1.1 501 Not Implemented\r\n" },
+    { protocol_status::bad_gateway, "HTTP/1.1 502 Bad Gateway\r\n" },
+    { protocol_status::service_unavailable, "HTTP/1.1 503 Service Unavailable\r\n" }
 };
 
-std::string http_reply::to_string(protocol_status status)
+static const status_line* find_status(protocol_status status)
 {
-    const auto it = status_strings.find(status);
-    return it == status_strings.end() ? std::string{} : it->second;
+    for (const auto& line: status_lines)
+        if (line.status == status)
+            return &line;
+
+    return nullptr;
 }
 
-std::string http_reply::generate(protocol_status status, const std::string& mime_type,
-    size_t content_length, bool keep_alive)
+// The date line is formatted at most once per second by each thread, so each
+// manager (reactor) thread keeps its own copy without synchronization.
+struct date_line
 {
-    static const size_t max_date_time_length = 32;
-    std::array<char, max_date_time_length> time_buffer;
-    const auto current_time = std::time(nullptr);
+    std::time_t time;
+    size_t size;
+    std::array<char, 64> text;
+};
 
-    // BUGBUG: std::gmtime may not be thread safe.
-    // TODO: C4996: 'gmtime': This function or variable may be unsafe.
-    // Consider using gmtime_s instead.
-    const auto time = std::gmtime(&current_time);
+static const date_line& cached_date()
+{
+    static thread_local date_line cache{ -1, 0, {} };
 
-    std::strftime(time_buffer.data(), time_buffer.size(),
-        "%a, %d %b %Y %H:%M:%S GMT", time);
+    const auto now = std::time(nullptr);
+    if (now != cache.time)
+    {
+        std::tm utc;
+#ifdef _MSC_VER
+        gmtime_s(&utc, &now);
+#else
+        gmtime_r(&now, &utc);
+#endif
+        cache.size = std::strftime(cache.text.data(), cache.text.size(),
+            "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", &utc);
+        cache.time = now;
+    }
 
-    std::stringstream response;
-    response
-        << to_string(status)
-        << "Date: " << time_buffer.data() << "\r\n"
-        << "Accept-Ranges: none\r\n"
-        << "Connection: " << (keep_alive ? "keep-alive" : "close")
-        << "\r\n";
+    return cache;
+}
+
+template <typename Buffer>
+static void append(Buffer& out, const char* text, size_t size)
+{
+    out.insert(out.end(), text, text + size);
+}
+
+template <typename Buffer>
+static void append(Buffer& out, const char* text)
+{
+    append(out, text, std::char_traits<char>::length(text));
+}
+
+template <typename Buffer>
+static void append(Buffer& out, size_t value)
+{
+    std::array<char, 24> digits;
+    auto position = digits.end();
+
+    do
+    {
+        *--position = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    append(out, position, static_cast<size_t>(digits.end() - position));
+}
+
+template <typename Buffer>
+static void write_preamble(Buffer& out, protocol_status status,
+    bool keep_alive)
+{
+    const auto line = find_status(status);
+    if (line != nullptr)
+        append(out, line->text, line->size);
+
+    const auto& date = cached_date();
+    append(out, date.text.data(), date.size);
+    append(out, keep_alive ? "Connection: keep-alive\r\n" :
+        "Connection: close\r\n");
+}
+
+template <typename Buffer>
+static void write_header(Buffer& out, protocol_status status,
+    const std::string& mime_type, size_t content_length, bool keep_alive,
+    bool chunked)
+{
+    write_preamble(out, status, keep_alive);
+    append(out, "Accept-Ranges: none\r\n");
 
     if (!mime_type.empty())
-        response << "Content-Type: " << mime_type << "\r\n";
+    {
+        append(out, "Content-Type: ");
+        append(out, mime_type.data(), mime_type.size());
+        append(out, "\r\n");
+    }
+
+    if (chunked)
+    {
+        append(out, "Transfer-Encoding: chunked\r\n");
+    }
+    else if (content_length > 0 || keep_alive)
+    {
+        // A persistent connection requires the length to delimit the message.
+        append(out, "Content-Length: ");
+        append(out, content_length);
+        append(out, "\r\n");
+    }
 
-    if (content_length > 0)
-        response << "Content-Length: " << content_length << "\r\n";
+    append(out, "\r\n");
+}
 
-    response << "\r\n";
-    return response.str();
+std::string http_reply::to_string(protocol_status status)
+{
+    const auto line = find_status(status);
+    return line == nullptr ? std::string{} :
+        std::string{ line->text, line->size };
+}
+
+std::string http_reply::generate(protocol_status status,
+    const std::string& mime_type, size_t content_length, bool keep_alive)
+{
+    std::string response;
+    response.reserve(maximum_header_size);
+    write_header(response, status, mime_type, content_length, keep_alive,
+        false);
+    return response;
+}
+
+std::string http_reply::generate(protocol_status status,
+    const std::string& fields, bool keep_alive)
+{
+    std::string response;
+    response.reserve(maximum_header_size + fields.size());
+    write_preamble(response, status, keep_alive);
+    append(response, fields.data(), fields.size());
+    append(response, "\r\n");
+    return response;
+}
+
+std::string http_reply::generate_chunked(protocol_status status,
+    const std::string& mime_type, bool keep_alive)
+{
+    std::string response;
+    response.reserve(maximum_header_size);
+    write_header(response, status, mime_type, 0, keep_alive, true);
+    return response;
+}
+
+void http_reply::write(data_chunk& out, protocol_status status,
+    const std::string& mime_type, size_t content_length, bool keep_alive)
+{
+    write_header(out, status, mime_type, content_length, keep_alive, false);
+}
+
+void http_reply::write(data_chunk& out, protocol_status status,
+    const std::string& fields, bool keep_alive)
+{
+    write_preamble(out, status, keep_alive);
+    append(out, fields.data(), fields.size());
+    append(out, "\r\n");
 }
 
 std::string http_reply::generate_upgrade(const std::string& key_response,
-    const std::string& protocol)
+    const std::string& protocol, const std::string& extensions)
 {
     std::stringstream response;
     response
@@ -113,7 +250,10 @@ std::string http_reply::generate_upgrade(const std::string& key_response,
         << "Connection: Upgrade" << "\r\n";
 
     if (!protocol.empty())
-        response << protocol << "\r\n";
+        response << "Sec-WebSocket-Protocol: " << protocol << "\r\n";
+
+    if (!extensions.empty())
+        response << "Sec-WebSocket-Extensions: " << extensions << "\r\n";
 
     response << "Sec-WebSocket-Accept: " << key_response << "\r\n\r\n";
     return response.str();
@@ -0,0 +1,205 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/protocol/web/loop_monitor.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/system.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+using namespace bc::system;
+
+// histogram
+// ----------------------------------------------------------------------------
+
+loop_monitor::histogram::histogram()
+{
+    reset();
+}
+
+void loop_monitor::histogram::record(uint64_t value)
+{
+    size_t index = 0;
+    for (auto remainder = value; remainder != 0 && index < buckets - 1;
+        remainder >>= 1)
+        ++index;
+
+    counts_[index].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    total_.fetch_add(value, std::memory_order_relaxed);
+
+    // There is only one writer, so no compare-exchange loop is required.
+    if (value > maximum_.load(std::memory_order_relaxed))
+        maximum_.store(value, std::memory_order_relaxed);
+}
+
+void loop_monitor::histogram::reset()
+{
+    for (auto& count: counts_)
+        count.store(0, std::memory_order_relaxed);
+
+    count_.store(0, std::memory_order_relaxed);
+    total_.store(0, std::memory_order_relaxed);
+    maximum_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t loop_monitor::histogram::count() const
+{
+    return count_.load(std::memory_order_relaxed);
+}
+
+uint64_t loop_monitor::histogram::total() const
+{
+    return total_.load(std::memory_order_relaxed);
+}
+
+uint64_t loop_monitor::histogram::maximum() const
+{
+    return maximum_.load(std::memory_order_relaxed);
+}
+
+uint64_t loop_monitor::histogram::bucket(size_t index) const
+{
+    return index < buckets ? counts_[index].load(std::memory_order_relaxed) : 0;
+}
+
+uint64_t loop_monitor::histogram::percentile(double percent) const
+{
+    const auto samples = count();
+    if (samples == 0)
+        return 0;
+
+    const auto bounded = std::max(0.0, std::min(percent, 100.0));
+    const auto target = static_cast<uint64_t>(std::ceil(samples * bounded / 100));
+
+    uint64_t seen = 0;
+    for (size_t index = 0; index < buckets; ++index)
+    {
+        seen += bucket(index);
+        if (seen >= target && seen > 0)
+            return index == 0 ? 0 : std::min(maximum(),
+                (uint64_t{ 1 } << index) - 1);
+    }
+
+    return maximum();
+}
+
+// loop_monitor
+// ----------------------------------------------------------------------------
+
+loop_monitor::loop_monitor()
+  : budget_(0)
+{
+}
+
+void loop_monitor::set_budget(const milliseconds& budget)
+{
+    budget_.store(budget.count(), std::memory_order_relaxed);
+}
+
+loop_monitor::milliseconds loop_monitor::budget() const
+{
+    return milliseconds(budget_.load(std::memory_order_relaxed));
+}
+
+void loop_monitor::record_iteration(const microseconds& total,
+    const microseconds& polling, size_t events)
+{
+    const auto total_value = static_cast<uint64_t>(total.count());
+    const auto polling_value = static_cast<uint64_t>(polling.count());
+    const auto handling_value = total_value > polling_value ?
+        total_value - polling_value : 0;
+
+    iterations_.record(total_value);
+    polling_.record(polling_value);
+    handling_.record(handling_value);
+    events_.record(events);
+
+    // An idle wait in select is not a stall, only handling counts.
+    const auto limit = budget();
+    if (limit.count() > 0 && microseconds(handling_value) > limit)
+    {
+        LOG_WARNING(LOG_PROTOCOL_HTTP)
+            << "Event loop iteration took " << total.count() << "us ("
+            << polling_value << "us polling, " << handling_value
+            << "us handling " << events << " events), budget is "
+            << limit.count() << "ms";
+    }
+}
+
+void loop_monitor::record_queue_latency(const microseconds& latency)
+{
+    queue_latency_.record(static_cast<uint64_t>(std::max(int64_t{ 0 },
+        static_cast<int64_t>(latency.count()))));
+}
+
+void loop_monitor::record_round_trip(const microseconds& round_trip)
+{
+    round_trips_.record(static_cast<uint64_t>(std::max(int64_t{ 0 },
+        static_cast<int64_t>(round_trip.count()))));
+}
+
+void loop_monitor::reset()
+{
+    iterations_.reset();
+    polling_.reset();
+    handling_.reset();
+    queue_latency_.reset();
+    round_trips_.reset();
+    events_.reset();
+}
+
+const loop_monitor::histogram& loop_monitor::iterations() const
+{
+    return iterations_;
+}
+
+const loop_monitor::histogram& loop_monitor::polling() const
+{
+    return polling_;
+}
+
+const loop_monitor::histogram& loop_monitor::handling() const
+{
+    return handling_;
+}
+
+const loop_monitor::histogram& loop_monitor::queue_latency() const
+{
+    return queue_latency_;
+}
+
+const loop_monitor::histogram& loop_monitor::round_trips() const
+{
+    return round_trips_;
+}
+
+const loop_monitor::histogram& loop_monitor::events() const
+{
+    return events_;
+}
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
@@ -19,7 +19,13 @@
 #include <bitcoin/protocol/web/manager.hpp>
 
 #include <cstddef>
+#include <map>
 #include <bitcoin/system.hpp>
+#include <boost/algorithm/string.hpp>
+
+#ifdef __linux__
+    #include <sys/sendfile.h>
+#endif
 
  // TODO: missing includes.
 
@@ -51,20 +57,83 @@ static constexpr size_t timeout_milliseconds = 10;
 static constexpr size_t maximum_backlog = 8;
 static constexpr size_t maximum_connections = FD_SETSIZE;
 
+// HTTP/1 input is bounded by one maximal request, as the connection is not
+// read while a request is held behind earlier responses.
+static constexpr size_t maximum_buffered_input =
+    http_parser::maximum_header_length + maximum_incoming_message_size;
+
+// RSV1 marks a websocket message compressed by permessage-deflate.
+static constexpr uint8_t compressed_flag = 0x40;
+
+// The websocket close status for a text message that is not UTF-8.
+static constexpr uint16_t invalid_payload_status = 1007;
+
+// Websocket keepalive state is checked at this interval.
+static const asio::seconds keepalive_sweep_interval(1);
+
+// Sent to connections shed at accept time, before any request is read.
+static const std::string service_unavailable =
+    "HTTP/1.1 503 Service Unavailable\r\n"
+    "Connection: close\r\n"
+    "Content-Length: 0\r\n"
+    "Retry-After: 1\r\n"
+    "\r\n";
+
+// Local class, completes file pool work on the manager thread.
+class file_task
+  : public manager::task
+{
+public:
+    file_task(connection_ptr connection, std::function<bool()> handler)
+      : connection_(connection), handler_(handler)
+    {
+    }
+
+    bool run()
+    {
+        return handler_();
+    }
+
+    connection_ptr connection()
+    {
+        return connection_;
+    }
+
+private:
+    connection_ptr connection_;
+    std::function<bool()> handler_;
+};
+
+constexpr size_t manager::default_websocket_limit;
+
 manager::manager(bool ssl, event_handler handler, path document_root,
     const origin_list origins)
   : ssl_(ssl), running_(false), listening_(false), initialized_(false),
     port_(0), user_data_(nullptr), key_{}, certificate_{}, ca_certificate_{},
-    handler_(handler), document_root_(document_root), origins_(origins),
-    page_data_{}
+    handler_(handler), document_root_(document_root),
+    limits_{ 0, 0, 0, false }, pending_queries_(nullptr), events_(0),
+    outbound_bytes_(std::make_shared<size_t>(0)), dropped_frames_(0),
+    polling_(0),
+    websocket_limit_(default_websocket_limit),
+    ping_interval_(0), missed_pongs_(0),
+    keepalive_sweep_(loop_monitor::clock::now()),
+    origins_(origins), page_data_{}
 {
 #ifndef WITH_MBEDTLS
     BITCOIN_ASSERT_MSG(!ssl, "Secure HTTP requires MBEDTLS library.");
 #endif
+
+    assets_.set_compressor(&compressor_);
 }
 
 manager::~manager()
 {
+    files_.stop();
+
+    // Connections held elsewhere (such as by queued tasks) no longer count.
+    for (const auto connection: connections_)
+        connection->set_outbound_counter(nullptr);
+
 #ifdef _MSC_VER
     if (initialized_)
         ::WSACleanup();
@@ -213,6 +282,13 @@ bool manager::accept_connection()
     }
 #endif
 
+    // Over limit, answer without allocating connection state.
+    if (limits_.reject && !admit())
+    {
+        shed(socket);
+        return true;
+    }
+
     auto connection = std::make_shared<http::connection>(socket, remote_address);
 
     if (!connection)
@@ -263,6 +339,7 @@ bool manager::accept_connection()
     // Set all per-connection variables.
     connection->set_state(connection_state::connected);
     connection->set_user_data(user_data_);
+    connection->set_compressor(&compressor_);
     connection->set_socket_non_blocking();
 
     add_connection(connection);
@@ -275,6 +352,7 @@ bool manager::accept_connection()
 
 void manager::add_connection(connection_ptr connection)
 {
+    connection->set_outbound_counter(outbound_bytes_);
     connections_.push_back(connection);
 
     LOG_VERBOSE(LOG_PROTOCOL_HTTP)
@@ -293,6 +371,7 @@ void manager::remove_connection(connection_ptr connection)
             << "Removing Connection [" << connection << ", "
             << connections_.size() - 1 << " remaining]";
 
+        connection->set_outbound_counter(nullptr);
         connections_.erase(it);
     }
     else
@@ -308,6 +387,60 @@ size_t manager::connection_count() const
     return connections_.size();
 }
 
+size_t manager::outbound_bytes() const
+{
+    return *outbound_bytes_;
+}
+
+size_t manager::dropped_frames() const
+{
+    return dropped_frames_;
+}
+
+void manager::set_admission_limits(const admission_limits& limits,
+    pending_counter pending_queries)
+{
+    limits_ = limits;
+    pending_queries_ = pending_queries;
+}
+
+bool manager::admit() const
+{
+    // The listener occupies one of the connection slots.
+    if (limits_.connections != 0 &&
+        connections_.size() > limits_.connections)
+        return false;
+
+    if (limits_.pending_queries != 0 && pending_queries_ &&
+        pending_queries_() >= limits_.pending_queries)
+        return false;
+
+    return limits_.outbound_bytes == 0 ||
+        *outbound_bytes_ < limits_.outbound_bytes;
+}
+
+// Best effort, the reply is small enough for an empty send buffer and the
+// socket is closed regardless of the result. A TLS client would not be able
+// to read a plaintext reply, so it is just closed.
+void manager::shed(sock_t socket)
+{
+    if (!ssl_)
+    {
+#ifdef MSG_NOSIGNAL
+        int flags = MSG_NOSIGNAL;
+#else
+        int flags = 0;
+#endif
+        send(socket, service_unavailable.data(),
+            static_cast<int>(service_unavailable.size()), flags);
+    }
+
+    CLOSE_SOCKET(socket);
+
+    LOG_DEBUG(LOG_PROTOCOL_HTTP)
+        << "Shed connection over admission limit on port " << port_;
+}
+
 bool manager::ssl() const
 {
     return ssl_;
@@ -340,11 +473,29 @@ void manager::run_once()
     if (stopped())
         return;
 
+    const auto start = loop_monitor::clock::now();
+    events_ = 0;
+    polling_ = loop_monitor::microseconds(0);
+
     // Run any user queued tasks that must be run inside this thread.
     run_tasks();
 
     // Monitor and process sockets.
     poll(timeout_milliseconds);
+
+    // Ping websocket connections that are due and close those that are not
+    // answering (there is no timer facility, this is checked periodically).
+    const auto now = loop_monitor::clock::now();
+    if (ping_interval_.count() > 0 &&
+        now - keepalive_sweep_ >= keepalive_sweep_interval)
+    {
+        keepalive_sweep_ = now;
+        ping_websockets(now);
+    }
+
+    const auto elapsed = std::chrono::duration_cast<
+        loop_monitor::microseconds>(loop_monitor::clock::now() - start);
+    monitor_.record_iteration(elapsed, polling_, events_);
 }
 
 void manager::stop()
@@ -362,13 +513,13 @@ void manager::execute(task_ptr task)
     // Critical Section.
     ///////////////////////////////////////////////////////////////////////////
     unique_lock lock(task_mutex_);
-    tasks_.push_back(task);
+    tasks_.push_back({ task, loop_monitor::clock::now() });
     ///////////////////////////////////////////////////////////////////////////
 }
 
 void manager::run_tasks()
 {
-    task_list tasks;
+    queued_task_list tasks;
 
     // Critical Section.
     ///////////////////////////////////////////////////////////////////////////
@@ -377,9 +528,120 @@ void manager::run_tasks()
     task_mutex_.unlock();
     ///////////////////////////////////////////////////////////////////////////
 
-    for (const auto task: tasks)
-        if (!task->run())
-            handle_connection(task->connection(), event::error);
+    const auto now = loop_monitor::clock::now();
+    events_ += tasks.size();
+
+    for (const auto& queued: tasks)
+    {
+        monitor_.record_queue_latency(std::chrono::duration_cast<
+            loop_monitor::microseconds>(now - queued.queued));
+
+        if (!queued.task->run())
+            handle_connection(queued.task->connection(), event::error);
+    }
+}
+
+void manager::broadcast(const connection_list& connections,
+    const std::string& message)
+{
+    // The payload is shared by the queued frames of all connections.
+    const auto data = reinterpret_cast<const uint8_t*>(message.data());
+    const auto plain = std::make_shared<const data_chunk>(data,
+        data + message.size());
+
+    // Compressed payloads are shared by connections of the same server
+    // window, a null payload is not compressed (or not worth compressing).
+    std::map<uint8_t, shared_payload> compressed;
+    size_t dropped = 0;
+
+    for (const auto& connection: connections)
+    {
+        if (!connection || connection->closed() || !connection->websocket())
+            continue;
+
+        const auto& agreed = connection->deflate_session().agreed;
+        const auto prior = connection->dropped();
+        auto written = true;
+
+        // With context takeover each message depends on the connection.
+        if (agreed.enabled && !agreed.server_no_context_takeover)
+        {
+            written = connection->write_frame(data, message.size());
+        }
+        else if (agreed.enabled)
+        {
+            const auto bits = agreed.server_window_bits;
+            auto it = compressed.find(bits);
+            if (it == compressed.end())
+                it = compressed.emplace(bits,
+                    compressed_payload(agreed, message)).first;
+
+            written = it->second ?
+                connection->write_frame(it->second, websocket_op::text, true) :
+                connection->write_frame(plain);
+        }
+        else
+        {
+            written = connection->write_frame(plain);
+        }
+
+        dropped += connection->dropped() - prior;
+
+        if (!written)
+            handle_connection(connection, event::error);
+    }
+
+    // Slow consumers miss the message, rather than being disconnected.
+    if (dropped != 0)
+    {
+        dropped_frames_ += dropped;
+        LOG_WARNING(LOG_PROTOCOL_HTTP)
+            << "Broadcast dropped for " << dropped << " of "
+            << connections.size() << " connections at high water.";
+    }
+}
+
+loop_monitor& manager::monitor()
+{
+    return monitor_;
+}
+
+asset_cache& manager::assets()
+{
+    return assets_;
+}
+
+route_table& manager::routes()
+{
+    return routes_;
+}
+
+void manager::set_websocket_limit(size_t bytes)
+{
+    websocket_limit_ = bytes;
+}
+
+void manager::set_websocket_keepalive(const asio::seconds& interval,
+    size_t missed_pongs)
+{
+    ping_interval_ = interval;
+    missed_pongs_ = missed_pongs;
+}
+
+void manager::set_websocket_protocols(const protocol_list& protocols)
+{
+    websocket_protocols_ = protocols;
+}
+
+void manager::set_compression(int32_t level, size_t threshold)
+{
+    compressor_.configure(level, threshold);
+}
+
+void manager::set_websocket_compression(int32_t level, size_t window_bits,
+    bool context_takeover)
+{
+    deflate_.configure(level, window_bits, context_takeover);
 }
 
 // Portable select based implementation.
@@ -424,6 +686,17 @@ void manager::poll(size_t timeout_milliseconds)
     }
 }
 
+// A complete request (or any input during a file transfer) waits for earlier
+// responses, and the connection is not read until it has been handled.
+static bool holding_input(connection_ptr connection)
+{
+    const auto& transfer = connection->file_transfer();
+    return !connection->websocket() && connection->http2() == nullptr &&
+        !connection->event_stream() && !connection->input_buffer().empty() &&
+        (connection->parser().complete() || transfer.in_progress ||
+            transfer.pending);
+}
+
 void manager::select(size_t timeout_milliseconds, connection_list& connections)
 {
     // TODO: use std::array or std::vector.
@@ -500,11 +773,19 @@ void manager::select(size_t timeout_milliseconds, connection_list& connections)
 #endif
         }
 
-        if (connection->file_transfer().in_progress ||
-            !connection->write_buffer().empty())
+        // A transfer waiting on the file pool is not yet writable.
+        const auto& transfer = connection->file_transfer();
+        if ((transfer.in_progress && !transfer.pending) ||
+            connection->streaming() || connection->buffered() != 0)
             FD_SET(descriptor, &write_set);
 
-        FD_SET(descriptor, &read_set);
+        // While paused new connections wait in the listen backlog.
+        const auto paused = connection->state() ==
+            connection_state::listening && !limits_.reject && !admit();
+
+        if (!paused && !holding_input(connection))
+            FD_SET(descriptor, &read_set);
+
         FD_SET(descriptor, &error_set);
 
         socket_list[last_index++] = connection;
@@ -526,12 +807,19 @@ void manager::select(size_t timeout_milliseconds, connection_list& connections)
     }
 
     const auto fd_count = static_cast<int32_t>(max_descriptor + 1);
+    const auto poll_start = loop_monitor::clock::now();
     const auto num_events = ::select(fd_count, &read_set, &write_set,
         &error_set, &poll_interval);
 
+    polling_ += std::chrono::duration_cast<loop_monitor::microseconds>(
+        loop_monitor::clock::now() - poll_start);
+
     if (num_events == 0)
         return;
 
+    if (num_events > 0)
+        events_ += static_cast<size_t>(num_events);
+
     if (num_events < 0)
     {
         LOG_ERROR(LOG_PROTOCOL_HTTP)
@@ -555,31 +843,47 @@ void manager::select(size_t timeout_milliseconds, connection_list& connections)
 
         if (FD_ISSET(descriptor, &write_set))
         {
-            if (connection->file_transfer().in_progress &&
-                !transfer_file_data(connection))
+            // Streamed bodies are pulled only as the connection drains.
+            if (connection->streaming() &&
+                !connection->continue_stream(transfer_buffer_length))
             {
                 pending_removal.push_back(connection);
                 continue;
             }
 
-            auto& write_buffer = connection->write_buffer();
-            if (!write_buffer.empty())
+            // Buffered bytes and queued websocket frames are written
+            // together.
+            if (connection->buffered() != 0 &&
+                connection->flush(transfer_buffer_length) < 0)
             {
-                const auto segment_length = std::min(write_buffer.size(),
-                    transfer_buffer_length);
+                pending_removal.push_back(connection);
+                continue;
+            }
 
-                const auto written = connection->unbuffered_write(
-                    write_buffer.data(), segment_length);
+            // File data is sent once the buffered header has drained.
+            if (connection->file_transfer().in_progress &&
+                !transfer_file_data(connection))
+            {
+                pending_removal.push_back(connection);
+                continue;
+            }
 
-                if (written < 0)
-                {
-                    pending_removal.push_back(connection);
-                    continue;
-                }
+            // Resume any requests held behind the completed responses.
+            if (!handle_requests(connection))
+            {
+                pending_removal.push_back(connection);
+                continue;
+            }
 
-                // TODO: this is very inefficient, use circular buffer.
-                write_buffer.erase(write_buffer.begin(),
-                    write_buffer.begin() + written);
+            // A non-persistent connection is closed once it is idle.
+            if (!connection->websocket() && !connection->keep_alive() &&
+                connection->buffered() == 0 &&
+                connection->pending_responses() == 0 &&
+                !connection->file_transfer().in_progress &&
+                !connection->file_transfer().pending)
+            {
+                pending_removal.push_back(connection);
+                continue;
             }
         }
 
@@ -640,69 +944,31 @@ bool manager::handle_connection(connection_ptr connection, event current_event)
             if (read_result <= 0)
                 break;
 
+            // An event stream holds the connection, later input is discarded
+            // (the read only detects the client closing).
+            if (connection->event_stream())
+                return true;
+
             const auto read_length = static_cast<size_t>(read_result);
             auto& buffer = connection->read_buffer();
-            if (connection->websocket())
-            {
-                auto& transfer = connection->websocket_transfer();
-                if (transfer.in_progress)
-                {
-                    transfer.data.insert(transfer.data.end(), buffer.data(),
-                        buffer.data() + read_length);
-
-                    transfer.offset += read_length;
-                    BITCOIN_ASSERT(transfer.offset == transfer.data.size());
-
-                    // Check for configuration violation (DoS protection).
-                    if (transfer.offset > maximum_incoming_message_size)
-                    {
-                        LOG_ERROR(LOG_PROTOCOL_HTTP)
-                            << "Terminating connection due to excessive frame length.";
-                        return false;
-                    }
-
-                    if (transfer.offset != transfer.length)
-                        return true;
-                }
+            // Input may span any number of reads, so accumulate it.
+            auto& input = connection->input_buffer();
+            input.insert(input.end(), buffer.data(), buffer.data() +
+                read_length);
 
+            if (connection->websocket())
                 return handle_websocket(connection);
-            }
 
-            const std::string request{ buffer.begin(), buffer.begin() + read_length };
-
-            http_request out;
-            if (parse_http(out, request))
-            {
-
-                // Check if we need to convert HTTP connection to websocket.
-                if (out.upgrade_request)
-                    return upgrade_connection(connection, out);
-
-                // Check if we need to mark HTTP connection as expecting a
-                // JSON-RPC reply.  If so, we need to call the user handler
-                // to notify user that a new json_rpc connection was accepted
-                // so that they can track it.
-                connection->set_json_rpc(out.json_rpc);
-                const auto request = reinterpret_cast<void*>(&out);
-
-                if (out.json_rpc)
-                {
-                    return handler_(connection, event::accepted, nullptr) &&
-                        handler_(connection, event::json_rpc, request);
-                }
-
-                // Call user's event handler with the parsed http request.
-                return handler_(connection, event::read, request) &&
-                    send_response(connection, out);
-            }
-            else
+            // HTTP/1 input beyond one maximal request is not buffered.
+            if (connection->http2() == nullptr &&
+                input.size() > maximum_buffered_input)
             {
-                LOG_VERBOSE(LOG_PROTOCOL_HTTP)
-                    << "Failed to parse HTTP request from " << request;
+                LOG_ERROR(LOG_PROTOCOL_HTTP)
+                    << "Terminating connection due to excessive input.";
                 return handle_connection(connection, event::error);
             }
 
-            break;
+            return handle_requests(connection);
         }
 
         case event::write:
@@ -721,6 +987,9 @@ bool manager::handle_connection(connection_ptr connection, event current_event)
             LOG_VERBOSE(LOG_PROTOCOL_HTTP)
                 << "Connection closing: " << connection;
             handler_(connection, event::closing, nullptr);
+            connection->websocket_decoder().reset();
+            connection->websocket_assembler().reset(websocket_buffers_);
+            deflate_.release(connection->deflate_session());
             remove_connection(connection);
             connection->close();
             return false;
@@ -765,186 +1034,640 @@ int32_t manager::ssl_receive(void* data, uint8_t* buffer, size_t length)
 }
 #endif
 
-bool manager::transfer_file_data(connection_ptr connection)
+// HTTP/1.1 persists by default, HTTP/1.0 only if requested.
+static bool is_keep_alive(const http_request& request)
 {
-    std::array<uint8_t, transfer_buffer_length> buffer;
-    auto& file_transfer = connection->file_transfer();
+    const auto connection = request.header("connection");
+    return request.protocol_version < 1.1 ? connection == "keep-alive" :
+        connection != "close";
+}
 
-    if (!file_transfer.in_progress)
-        return false;
+// Server-Sent Events are requested by a GET accepting text/event-stream.
+static bool is_event_stream(const http_request& request)
+{
+    return request.method == "get" &&
+        request.header("accept").find("text/event-stream") !=
+            std::string::npos;
+}
 
-    auto amount_to_read = std::min(transfer_buffer_length,
-        file_transfer.length - file_transfer.offset);
+// Handle each complete request buffered on the connection, in order. Only
+// JSON-RPC responses are sequenced, so any other request waits in the input
+// buffer until outstanding responses, buffered writes, file pool work and file
+// transfers have completed.
+bool manager::handle_requests(connection_ptr connection)
+{
+    auto& input = connection->input_buffer();
+    auto& parser = connection->parser();
+
+    // HTTP/2 is recognized by the client connection preface (cleartext with
+    // prior knowledge, or negotiated by ALPN).
+    if (connection->http2() == nullptr && !connection->websocket() &&
+        !input.empty() && http2_session::match_preface(input.data(),
+            input.size()))
+    {
+        if (input.size() < http2_session::preface.size())
+            return true;
 
-    const auto read = std::fread(buffer.data(), sizeof(uint8_t),
-        amount_to_read, file_transfer.descriptor);
+        connection->start_http2(maximum_incoming_message_size);
+    }
 
-    auto success = (read == amount_to_read ||
-        (read < amount_to_read && feof(file_transfer.descriptor)));
+    if (connection->http2() != nullptr)
+        return handle_http2(connection);
 
-    if (!success)
+    while (!input.empty() && !connection->closed() &&
+        !connection->websocket() && !connection->event_stream() &&
+        !connection->file_transfer().in_progress &&
+        !connection->file_transfer().pending)
     {
-        if (file_transfer.in_progress)
+        const auto result = parser.parse(input.data(), input.size());
+
+        // Check for configuration violation (DoS protection).
+        if (parser.headers_complete() &&
+            parser.content_length() > maximum_incoming_message_size)
         {
-            fclose(file_transfer.descriptor);
-            file_transfer.in_progress = false;
-            file_transfer.offset = 0;
-            file_transfer.length = 0;
+            LOG_ERROR(LOG_PROTOCOL_HTTP)
+                << "Terminating connection due to excessive content length.";
+            return handle_connection(connection, event::error);
         }
 
-        return false;
-    }
+        if (result == http_parser::result::incomplete)
+            return true;
 
-    const auto written = connection->write(buffer.data(), read);
-    success = (written >= 0 && static_cast<size_t>(written) == read);
+        http_request out;
+        if (result == http_parser::result::error || !parser.to_request(out))
+        {
+            LOG_VERBOSE(LOG_PROTOCOL_HTTP)
+                << "Failed to parse HTTP request from " << connection;
+            return handle_connection(connection, event::error);
+        }
 
-    if (!success)
-    {
-        LOG_ERROR(LOG_PROTOCOL_HTTP)
-            << "Write failed: requested " << read << " and wrote " << written;
-        return false;
-    }
+        // Buffered responses are drained first, bounding memory use.
+        if (!out.json_rpc && (connection->pending_responses() != 0 ||
+            connection->buffered() != 0))
+            return true;
 
-    file_transfer.offset += written;
+        input.erase(input.begin(), input.begin() + parser.message_length());
+        parser.reset();
+        connection->set_keep_alive(is_keep_alive(out));
+        connection->set_protocol_version(out.protocol_version);
 
-    if (file_transfer.offset == file_transfer.length)
-    {
-        if (file_transfer.in_progress)
+        // Check if we need to convert HTTP connection to websocket.
+        // Frames sent ahead of the upgrade response follow in the input.
+        if (out.upgrade_request)
+            return upgrade_connection(connection, out) &&
+                (input.empty() || handle_websocket(connection));
+
+        // An event stream holds the connection, later input is discarded.
+        if (is_event_stream(out))
         {
-            fclose(file_transfer.descriptor);
-            file_transfer.in_progress = false;
-            file_transfer.offset = 0;
-            file_transfer.length = 0;
+            input.clear();
+            return start_event_stream(connection, out);
         }
-    }
-
-    return success;
-}
-
-bool manager::send_http_file(connection_ptr connection, const path& path,
-    bool keep_alive)
-{
-    auto& file_transfer = connection->file_transfer();
 
-    if (!file_transfer.in_progress)
-    {
-        // BUGBUG: UTF8 string passed to Windows ANSI parameter.
-        // TODO: use wide character API and Unicode conversion.
-        const auto file = path.generic_string().c_str();
+        const auto request = reinterpret_cast<void*>(&out);
 
-        // TODO: C4996: 'fopen': This function or variable may be unsafe.
-        // Consider using fopen_s instead.
-        file_transfer.descriptor = fopen(file, "r");
-        if (file_transfer.descriptor == nullptr)
-            return false;
+        route_table::parameter_map parameters;
+        std::string allowed;
+        const auto route = routes_.find(parameters, allowed, out.method,
+            out.uri);
 
-        file_transfer.in_progress = true;
-        file_transfer.offset = 0;
-        file_transfer.length = boost::filesystem::file_size(path);
+        if (route != nullptr || !allowed.empty())
+        {
+            // A routed request is answered in its slot, as is JSON-RPC.
+            connection->set_active_slot(connection->reserve_slot());
+            if (!send_route(connection, out, route, parameters, allowed))
+                return false;
+        }
+        else if (out.json_rpc)
+        {
+            // The user handler is notified that a new json_rpc connection
+            // was accepted only for its first request, so that they can
+            // track it. Replies are then written in request order.
+            const auto accepted = connection->json_rpc();
+            connection->set_json_rpc(true);
+            connection->set_active_slot(connection->reserve_slot());
+            connection->set_content_coding(connection->active_slot(),
+                compressor_.negotiate(out.header("accept-encoding")));
+
+            if (!accepted && !handler_(connection, event::accepted, nullptr))
+                return false;
 
-        http_reply reply;
-        const auto response = reply.generate(protocol_status::ok,
-            mime_type(path), file_transfer.length, keep_alive);
+            if (!handler_(connection, event::json_rpc, request))
+                return false;
+        }
+        else
+        {
+            // Call user's event handler with the parsed http request.
+            if (!handler_(connection, event::read, request) ||
+                !send_response(connection, out))
+                return false;
+        }
 
-        if (!connection->write(response))
-            return false;
+        // Requests following a close are not answered.
+        if (!connection->keep_alive())
+        {
+            input.clear();
+            break;
+        }
     }
 
-    // On future iterations, this is called directly from poll while
-    // the file transfer is in progress.
-    return transfer_file_data(connection);
+    return true;
 }
 
-bool manager::handle_websocket(connection_ptr connection)
+// Each completed HTTP/2 stream is answered on that stream as its response
+// completes, so streams are not held behind one another. Only JSON-RPC is
+// served over HTTP/2.
+bool manager::handle_http2(connection_ptr connection)
 {
-    const auto read_length = static_cast<size_t>(connection->read_length());
-    auto& buffer = connection->read_buffer();
-    auto& transfer = connection->websocket_transfer();
-    auto data = transfer.in_progress ? transfer.data.data() : buffer.data();
-
-    websocket_frame frame(data, read_length);
+    const auto session = connection->http2();
+    http2_session::request_list requests;
 
-    // Websocket fragments are not supported.
-    if (!frame || frame.fragment())
+    if (!session->receive(requests, connection->input_buffer(),
+        connection->write_buffer()))
     {
-        LOG_ERROR(LOG_PROTOCOL_HTTP)
-            << "Invalid websocket frame.";
-        return false;
+        // The buffered GOAWAY is sent before the connection is closed.
+        LOG_VERBOSE(LOG_PROTOCOL_HTTP)
+            << "HTTP/2 connection error on " << connection;
+        connection->set_keep_alive(false);
+        connection->input_buffer().clear();
     }
 
-    const auto flags = frame.flags();
-    const auto final = frame.final();
-    const auto op_code = frame.op_code();
-    const auto event_type = frame.event_type();
-    const auto mask_length = frame.mask_length();
-    const auto data_length = frame.data_length();
-    const auto header_length = frame.header_length();
+    for (auto& item: requests)
+    {
+        auto& out = item.request;
+        connection->set_active_slot(item.stream);
 
-    LOG_VERBOSE(LOG_PROTOCOL_HTTP)
-        << "Websocket data_frame flags: 0x" << std::hex
-        << static_cast<uint32_t>(flags) << std::dec << ", final_fragment: "
-        << (final ? "true" : "false") << ", read length: " << read_length;
+        route_table::parameter_map parameters;
+        std::string allowed;
+        const auto route = routes_.find(parameters, allowed, out.method,
+            out.uri);
 
-    // If full frame payload isn't buffered, initiate state to track transfer.
-    if (data_length > read_length && !transfer.in_progress)
-    {
-        // Check if this transfer exceeds the maximum incoming frame length.
-        if (data_length > maximum_incoming_message_size)
+        if (route != nullptr || !allowed.empty())
         {
-            LOG_ERROR(LOG_PROTOCOL_HTTP)
-                << "Terminating connection due to excessive frame length.";
-            return false;
+            if (!send_route(connection, out, route, parameters, allowed))
+                return false;
+
+            continue;
         }
 
-        transfer.in_progress = true;
-        transfer.header_length = header_length;
-        transfer.length = data_length + header_length;
+        if (!out.json_rpc)
+        {
+            if (!connection->write_response(item.stream,
+                protocol_status::not_implemented, {}))
+                return false;
 
-        data_chunk data;
-        transfer.data.swap(data);
-        transfer.data.reserve(transfer.length);
-        transfer.data.insert(transfer.data.end(), buffer.data(),
-            buffer.data() + header_length);
+            continue;
+        }
 
-        const auto non_mask_length = transfer.header_length - mask_length;
-        const auto mask_start = data.data() + non_mask_length;
-        transfer.mask = { mask_start, mask_start + mask_length };
-        transfer.offset = transfer.data.size();
+        const auto accepted = connection->json_rpc();
+        connection->set_json_rpc(true);
+        connection->set_content_coding(item.stream, compressor_.negotiate(
+            out.header("accept-encoding")));
 
-        LOG_DEBUG(LOG_PROTOCOL_HTTP)
-            << "Initiated frame transfer for a length of " << data_length;
-        return true;
-    }
-    else
-    {
-        LOG_VERBOSE(LOG_PROTOCOL_HTTP)
-            << "Data length: " << data_length << ", Header length: "
-            << header_length << ", Mask length: " << mask_length;
+        if (!accepted && !handler_(connection, event::accepted, nullptr))
+            return false;
+
+        if (!handler_(connection, event::json_rpc,
+            reinterpret_cast<void*>(&out)))
+            return false;
     }
 
-    const auto frame_length = header_length + data_length;
-    if (frame_length < header_length || frame_length < data_length)
-        return false;
+    return true;
+}
 
-    if (event_type == event::websocket_control_frame)
+static void end_file_transfer(file_transfer& transfer)
+{
+    if (transfer.in_progress)
     {
-        // XOR mask the payload using the client provided mask.
-        const auto mask_start = data + header_length - mask_length;
-
-        for (size_t index = 0; index < data_length; ++index)
-            data[index + header_length] ^= mask_start[index % 4];
+        CLOSE_FILE(transfer.descriptor);
+        transfer.in_progress = false;
+        transfer.offset = 0;
+        transfer.end = 0;
+        transfer.parts.clear();
+        transfer.trailer.clear();
+    }
+}
 
-        websocket_message message
+static bool seek_file(int descriptor, size_t offset)
+{
+#ifdef _MSC_VER
+    return _lseeki64(descriptor, offset, SEEK_SET) >= 0;
+#else
+    return ::lseek(descriptor, static_cast<off_t>(offset), SEEK_SET) >= 0;
+#endif
+}
+
+// Buffer the preamble of the next part (if any) and position the transfer at
+// its range, otherwise buffer the trailer and complete the transfer.
+static bool next_file_part(connection_ptr connection)
+{
+    auto& transfer = connection->file_transfer();
+
+    if (transfer.parts.empty())
+    {
+        const auto written = connection->write(transfer.trailer) >= 0;
+        end_file_transfer(transfer);
+        return written;
+    }
+
+    const auto part = std::move(transfer.parts.front());
+    transfer.parts.pop_front();
+    transfer.offset = part.range.offset;
+    transfer.end = part.range.offset + part.range.length;
+    return connection->write(part.preamble) >= 0 &&
+        seek_file(transfer.descriptor, transfer.offset);
+}
+
+// Called as the connection becomes writable. File data follows anything
+// already buffered (such as the response header), and no more than one
+// segment is sent or buffered per call, so memory use is bounded.
+bool manager::transfer_file_data(connection_ptr connection)
+{
+    auto& file_transfer = connection->file_transfer();
+
+    if (!file_transfer.in_progress)
+        return false;
+
+    if (file_transfer.pending || connection->buffered() != 0)
+        return true;
+
+    const auto amount = std::min(transfer_buffer_length,
+        file_transfer.end - file_transfer.offset);
+
+    if (amount == 0)
+    {
+        if (!next_file_part(connection))
+        {
+            end_file_transfer(file_transfer);
+            return false;
+        }
+
+        return true;
+    }
+
+#ifdef __linux__
+    // Plaintext is sent from the page cache without a user space copy.
+    if (!connection->ssl_enabled())
+    {
+        auto offset = static_cast<off_t>(file_transfer.offset);
+        const auto sent = ::sendfile(connection->socket(),
+            file_transfer.descriptor, &offset, amount);
+
+        if (sent < 0)
+        {
+            if (would_block(last_error()))
+                return true;
+
+            LOG_ERROR(LOG_PROTOCOL_HTTP)
+                << "Sendfile failed: " << error_string();
+            end_file_transfer(file_transfer);
+            return false;
+        }
+
+        // A truncated file would otherwise never complete.
+        if (sent == 0)
+        {
+            end_file_transfer(file_transfer);
+            return false;
+        }
+
+        file_transfer.offset += static_cast<size_t>(sent);
+        return true;
+    }
+#endif
+
+    // Encrypted (or non-Linux) transfers are read into the write buffer.
+    return read_file_data(connection, amount);
+}
+
+// The next segment is read on the file pool, the transfer resumes once the
+// completion has buffered it.
+bool manager::read_file_data(connection_ptr connection, size_t amount)
+{
+    auto& file_transfer = connection->file_transfer();
+    const auto descriptor = file_transfer.descriptor;
+    file_transfer.pending = true;
+
+    const auto posted = files_.post([this, connection, descriptor, amount]()
+    {
+        data_chunk data(amount);
+
+#ifdef _MSC_VER
+        const auto read = _read(descriptor, data.data(),
+            static_cast<unsigned>(amount));
+#else
+        const auto read = ::read(descriptor, data.data(), amount);
+#endif
+
+        if (read <= 0)
+        {
+            LOG_ERROR(LOG_PROTOCOL_HTTP)
+                << "File read failed: " << error_string();
+            data.clear();
+        }
+        else
+        {
+            data.resize(static_cast<size_t>(read));
+        }
+
+        execute(std::make_shared<file_task>(connection,
+            [this, connection, data]()
+            {
+                return complete_read(connection, data);
+            }));
+    });
+
+    if (!posted)
+        file_transfer.pending = false;
+
+    return posted;
+}
+
+bool manager::complete_read(connection_ptr connection, const data_chunk& data)
+{
+    auto& file_transfer = connection->file_transfer();
+    file_transfer.pending = false;
+
+    // The descriptor was left open for this read.
+    if (connection->closed())
+    {
+        end_file_transfer(file_transfer);
+        return true;
+    }
+
+    if (data.empty())
+    {
+        end_file_transfer(file_transfer);
+        return false;
+    }
+
+    if (connection->write(data) < 0)
+    {
+        end_file_transfer(file_transfer);
+        return false;
+    }
+
+    file_transfer.offset += data.size();
+    return true;
+}
+
+static std::string content_range(const byte_range& range, size_t size)
+{
+    return "Content-Range: bytes " + std::to_string(range.offset) + "-" +
+        std::to_string(range.offset + range.length - 1) + "/" +
+        std::to_string(size) + "\r\n";
+}
+
+// Unique per response, so that it cannot be predicted to appear in a part.
+static std::string multipart_boundary()
+{
+    static std::atomic<uint64_t> counter{ 0 };
+    data_chunk nonce(8);
+    pseudo_random_fill(nonce);
+    return "bc" + encode_base16(nonce) + std::to_string(++counter);
+}
+
+// Ranges apply only to GET and are ignored if the (date) validator in
+// If-Range does not match the current file.
+// Header values are lowercased by the parsers, so validators are compared
+// case-insensitively. An entity tag must be strong and current to match.
+static bool matches_if_range(const std::string& if_range,
+    const std::string& last_modified, const std::string& etag)
+{
+    if (if_range.empty())
+        return true;
+
+    if (if_range.front() != '"')
+        return boost::iequals(if_range, last_modified);
+
+    return !etag.empty() && boost::iequals(if_range, etag);
+}
+
+static bool use_ranges(byte_range_list& out, const http_request& request,
+    size_t size, const std::string& last_modified, const std::string& etag)
+{
+    const auto range = request.header("range");
+    if (range.empty() || request.method != "get")
+        return false;
+
+    if (!matches_if_range(request.header("if-range"), last_modified, etag))
+        return false;
+
+    return parse_ranges(out, range, size);
+}
+
+bool manager::send_http_file(connection_ptr connection,
+    const file_result& file, const http_request& request)
+{
+    auto& file_transfer = connection->file_transfer();
+    BITCOIN_ASSERT(!file_transfer.in_progress);
+    file_transfer.descriptor = file.descriptor;
+
+    const auto keep_alive = is_keep_alive(request);
+    const auto size = file.size;
+    const auto last_modified = asset_cache::to_http_date(file.modified);
+    const auto& type = file.mime_type;
+
+    // The identity etag of a cached copy of this same file revision.
+    std::string etag;
+    const auto cached = assets_.find(request.uri);
+    if (cached && cached->modified == file.modified)
+        etag = cached->variants.back().etag;
+
+    file_transfer.in_progress = true;
+    file_transfer.offset = 0;
+    file_transfer.end = size;
+
+    std::string fields = "Accept-Ranges: bytes\r\nLast-Modified: " +
+        last_modified + "\r\n";
+
+    byte_range_list ranges;
+    if (!use_ranges(ranges, request, size, last_modified, etag))
+    {
+        fields += "Content-Type: " + type + "\r\nContent-Length: " +
+            std::to_string(size) + "\r\n";
+
+        if (connection->write_header(protocol_status::ok, fields,
+            keep_alive) < 0)
+        {
+            end_file_transfer(file_transfer);
+            return false;
+        }
+    }
+    else if (ranges.empty())
+    {
+        end_file_transfer(file_transfer);
+        fields += "Content-Range: bytes */" + std::to_string(size) +
+            "\r\nContent-Length: 0\r\n";
+
+        return connection->write_header(
+            protocol_status::range_not_satisfiable, fields,
+            keep_alive) >= 0;
+    }
+    else if (ranges.size() == 1)
+    {
+        const auto& range = ranges.front();
+        file_transfer.offset = range.offset;
+        file_transfer.end = range.offset + range.length;
+
+        fields += "Content-Type: " + type + "\r\n" +
+            content_range(range, size) + "Content-Length: " +
+            std::to_string(range.length) + "\r\n";
+
+        if (!seek_file(file_transfer.descriptor, range.offset) ||
+            connection->write_header(protocol_status::partial_content,
+                fields, keep_alive) < 0)
+        {
+            end_file_transfer(file_transfer);
+            return false;
+        }
+    }
+    else
+    {
+        // Parts are sent in request order, each preceded by a preamble.
+        const auto boundary = multipart_boundary();
+        file_transfer.end = 0;
+        file_transfer.trailer = "\r\n--" + boundary + "--\r\n";
+        auto length = file_transfer.trailer.size();
+
+        for (const auto& range: ranges)
+        {
+            file_transfer.parts.push_back(
+            {
+                "\r\n--" + boundary + "\r\nContent-Type: " + type +
+                    "\r\n" + content_range(range, size) + "\r\n",
+                range
+            });
+
+            length += file_transfer.parts.back().preamble.size() +
+                range.length;
+        }
+
+        fields += "Content-Type: multipart/byteranges; boundary=" +
+            boundary + "\r\nContent-Length: " + std::to_string(length) +
+            "\r\n";
+
+        if (connection->write_header(protocol_status::partial_content,
+            fields, keep_alive) < 0)
+        {
+            end_file_transfer(file_transfer);
+            return false;
+        }
+    }
+
+    // HEAD is answered as GET without the body.
+    if (request.method == "head")
+    {
+        end_file_transfer(file_transfer);
+        return true;
+    }
+
+    // On future iterations, this is called directly from poll while
+    // the file transfer is in progress.
+    return transfer_file_data(connection);
+}
+
+// Input accumulates across reads and any number of frames are handled from
+// it, in place.
+bool manager::handle_websocket(connection_ptr connection)
+{
+    const auto handler = [this, connection](const websocket_frame& frame,
+        uint8_t* payload)
+    {
+        return handle_websocket_frame(connection, frame, payload);
+    };
+
+    auto& input = connection->input_buffer();
+    const auto result = connection->websocket_decoder().decode(input,
+        websocket_limit_, handler);
+
+    switch (result)
+    {
+        case websocket_decoder::result::incomplete:
+            return true;
+
+        case websocket_decoder::result::invalid:
+        {
+            LOG_ERROR(LOG_PROTOCOL_HTTP)
+                << "Invalid websocket frame.";
+            return false;
+        }
+
+        case websocket_decoder::result::oversized:
+        {
+            LOG_ERROR(LOG_PROTOCOL_HTTP)
+                << "Terminating connection due to excessive frame length.";
+            return false;
+        }
+
+        case websocket_decoder::result::invalid_text:
+        {
+            LOG_ERROR(LOG_PROTOCOL_HTTP)
+                << "Invalid UTF-8 in websocket text message.";
+            close_websocket(connection, invalid_payload_status);
+            return false;
+        }
+
+        // Returning false here causes the connection to be removed.
+        case websocket_decoder::result::stopped:
+        default:
+            return false;
+    }
+}
+
+bool manager::handle_websocket_frame(connection_ptr connection,
+    const websocket_frame& frame, const uint8_t* payload)
+{
+    const auto flags = frame.flags();
+    const auto op_code = frame.op_code();
+    const auto event_type = frame.event_type();
+    const auto data_length = frame.data_length();
+
+    // Only RSV1 is defined, by compression, on the first frame of a data
+    // message (RFC 7692 section 6.1).
+    const auto reserved = flags & 0x70;
+    if (reserved != 0 && (reserved != compressed_flag ||
+        !connection->deflate_session().agreed.enabled ||
+        event_type == event::websocket_control_frame ||
+        op_code == websocket_op::continuation))
+    {
+        LOG_ERROR(LOG_PROTOCOL_HTTP)
+            << "Invalid websocket reserved bits.";
+        return false;
+    }
+
+    LOG_VERBOSE(LOG_PROTOCOL_HTTP)
+        << "Websocket data_frame flags: 0x" << std::hex
+        << static_cast<uint32_t>(flags) << std::dec << ", final_fragment: "
+        << (frame.final() ? "true" : "false") << ", data length: "
+        << data_length;
+
+    if (event_type == event::websocket_control_frame)
+    {
+        websocket_message message
         {
             connection->uri(),
-            data + header_length,
+            payload,
             data_length,
             flags,
             op_code
         };
 
-        // Possible TODO: If the opcode is a ping, send response here.
-        if (message.code != websocket_op::close)
+        // A ping is answered with its payload, a pong may answer our ping.
+        if (message.code == websocket_op::ping)
+        {
+            if (!connection->write_control(websocket_op::pong, payload,
+                data_length))
+                return false;
+        }
+        else if (message.code == websocket_op::pong)
+        {
+            auto& keepalive = connection->keepalive();
+            if (keepalive.pong(payload, data_length,
+                loop_monitor::clock::now()))
+                monitor_.record_round_trip(keepalive.last_round_trip());
+        }
+        else if (message.code != websocket_op::close)
         {
             LOG_DEBUG(LOG_PROTOCOL_HTTP)
                 << "Unhandled websocket op: " << op_to_string(message.code);
@@ -960,74 +1683,210 @@ bool manager::handle_websocket(connection_ptr connection)
         return status;
     }
 
-    if (final && transfer.in_progress && transfer.offset == transfer.length)
+    return handle_websocket_data(connection, flags, payload, data_length);
+}
+
+// The close frame is written before the connection is removed, if the
+// socket takes it without blocking.
+void manager::close_websocket(connection_ptr connection, uint16_t status)
+{
+    const uint8_t payload[]
     {
-        const auto mask_start = transfer.mask.data();
-        const auto payload_length = transfer.length - transfer.header_length;
+        static_cast<uint8_t>(status >> 8),
+        static_cast<uint8_t>(status)
+    };
 
-        for (size_t index = 0; index < payload_length; ++index)
-            data[index + transfer.header_length] ^= mask_start[index % 4];
+    if (connection->write_control(websocket_op::close, payload,
+        sizeof(payload)))
+        connection->flush(transfer_buffer_length);
+}
 
-        websocket_message message
-        {
-            connection->uri(),
-            data + transfer.header_length,
-            transfer.data.size() - transfer.header_length,
-            flags,
-            op_code
-        };
+void manager::ping_websockets(loop_monitor::clock::time_point now)
+{
+    connection_list unresponsive;
 
-        // Call user handler on last fragment with the entire message.
-        const auto status = handler_(connection, event_type, &message);
+    for (const auto& connection: connections_)
+    {
+        if (connection->closed() || !connection->websocket())
+            continue;
 
-        transfer.in_progress = false;
-        transfer.offset = 0;
-        transfer.length = 0;
-        transfer.header_length = 0;
-        transfer.mask.clear();
-        transfer.data.clear();
+        auto& keepalive = connection->keepalive();
+        if (!keepalive.due(now, ping_interval_))
+            continue;
 
-        return status;
+        const auto payload = keepalive.ping(now);
+        if ((missed_pongs_ != 0 && keepalive.missed() >= missed_pongs_) ||
+            !connection->write_control(websocket_op::ping, payload.data(),
+                payload.size()))
+            unresponsive.push_back(connection);
     }
-    else if (op_code == websocket_op::close)
+
+    // Closing removes the connection, so is deferred until after iteration.
+    for (const auto& connection: unresponsive)
     {
         LOG_DEBUG(LOG_PROTOCOL_HTTP)
-            << "Closing websocket due to close op.";
-        return false;
+            << "Closing unresponsive websocket connection: " << connection;
+        handle_connection(connection, event::closing);
     }
-    else
+}
+
+// Data frames are delivered to the user handler as whole messages, the
+// fragments of a message are assembled first.
+bool manager::handle_websocket_data(connection_ptr connection, uint8_t flags,
+    const uint8_t* data, size_t size)
+{
+    auto& assembler = connection->websocket_assembler();
+    const auto result = assembler.append(websocket_buffers_, flags, data, size,
+        websocket_limit_);
+
+    switch (result)
     {
-         // Check if we need to read again.
-        if (data_length > read_length)
+        case websocket_assembler::result::single:
+        {
+            // Call user handler for non-fragmented frames.
+            return handle_websocket_message(connection, flags,
+                static_cast<websocket_op>(flags & 0x0f), data, size);
+        }
+
+        case websocket_assembler::result::complete:
+        {
+            // Call user handler on last fragment with the entire message.
+            const auto& buffer = assembler.message();
+            const auto status = handle_websocket_message(connection,
+                assembler.flags(), assembler.code(), buffer.data(),
+                buffer.size());
+
+            assembler.reset(websocket_buffers_);
+            return status;
+        }
+
+        case websocket_assembler::result::incomplete:
             return true;
 
-        // Apply websocket mask (if required) before user handling.
-        if ((mask_length > 0) && (read_length > data_length))
+        case websocket_assembler::result::invalid:
         {
-            const auto mask_start = data + header_length - mask_length;
-            for (size_t index = 0; index < data_length; ++index)
-                data[index + header_length] ^= mask_start[index % 4];
+            LOG_ERROR(LOG_PROTOCOL_HTTP)
+                << "Invalid websocket fragment sequence.";
+            return false;
         }
 
-        websocket_message message
+        case websocket_assembler::result::oversized:
+        default:
         {
-            connection->uri(),
-            data + header_length,
-            data_length,
-            flags,
-            op_code
-        };
+            LOG_ERROR(LOG_PROTOCOL_HTTP)
+                << "Terminating connection due to excessive message length.";
+            return false;
+        }
+    }
+}
 
-        // Call user handler for non-fragmented frames.
-        return handler_(connection, event_type, &message);
+// A compressed message is inflated (within the message limit) before it is
+// delivered, and is then delivered as if it had not been compressed.
+bool manager::handle_websocket_message(connection_ptr connection,
+    uint8_t flags, websocket_op code, const uint8_t* data, size_t size)
+{
+    if ((flags & compressed_flag) == 0)
+    {
+        websocket_message message{ connection->uri(), data, size, flags,
+            code };
+        return handler_(connection, event::websocket_frame, &message);
     }
 
-    return false;
+    auto buffer = websocket_buffers_.acquire();
+    if (!deflate_.decompress(buffer, connection->deflate_session(), data, size,
+        websocket_limit_))
+    {
+        LOG_ERROR(LOG_PROTOCOL_HTTP)
+            << "Terminating connection due to invalid or excessive "
+            << "compressed message.";
+        websocket_buffers_.release(buffer);
+        return false;
+    }
+
+    // Uncompressed text is validated as it is unmasked.
+    if (code == websocket_op::text &&
+        !utf8_validator::validate(buffer.data(), buffer.size()))
+    {
+        LOG_ERROR(LOG_PROTOCOL_HTTP)
+            << "Invalid UTF-8 in compressed websocket text message.";
+        close_websocket(connection, invalid_payload_status);
+        websocket_buffers_.release(buffer);
+        return false;
+    }
+
+    websocket_message message
+    {
+        connection->uri(),
+        buffer.data(),
+        buffer.size(),
+        static_cast<uint8_t>(flags & ~compressed_flag),
+        code
+    };
+
+    const auto status = handler_(connection, event::websocket_frame,
+        &message);
+
+    websocket_buffers_.release(buffer);
+    return status;
+}
+
+shared_payload manager::compressed_payload(
+    const websocket_deflate::parameters& agreed, const std::string& message)
+{
+    // Without context takeover a stream is only held for this message.
+    websocket_deflate::session state{ agreed };
+    const auto data = reinterpret_cast<const uint8_t*>(message.data());
+    const auto payload = deflate_.compress(state, data, message.size());
+    if (payload == nullptr)
+        return {};
+
+    return std::make_shared<const data_chunk>(*payload);
 }
 
 bool manager::send_response(connection_ptr connection,
     const http_request& request)
 {
+    // A cached asset is served without touching the file system. Ranges
+    // are served from the file (identity encoding).
+    const auto ranged = !request.header("range").empty();
+    const auto cached = ranged ? nullptr : assets_.find(request.uri);
+    if (cached)
+        return send_asset(connection, request, *cached);
+
+    // Otherwise the file is resolved on the file pool, and requests that
+    // follow on the connection wait for the response.
+    const auto cacheable = !ranged && assets_.enabled();
+    const auto version = assets_.version();
+    auto& file_transfer = connection->file_transfer();
+    file_transfer.pending = true;
+
+    const auto posted = files_.post(
+        [this, connection, request, cacheable, version]()
+        {
+            resolve_file(connection, request, cacheable, version);
+        });
+
+    if (!posted)
+        file_transfer.pending = false;
+
+    return posted;
+}
+
+// File pool threads gzip assets with their own compressor state.
+static compressor& pool_compressor(const compressor& settings)
+{
+    thread_local compressor instance;
+    instance.configure(settings.level(), settings.threshold());
+    return instance;
+}
+
+// Called on a file pool thread, the result is completed on the manager
+// thread. Error codes are used since exceptions cannot cross threads.
+void manager::resolve_file(connection_ptr connection,
+    const http_request& request, bool cacheable, uint64_t version)
+{
+    boost::system::error_code ec;
+    file_result file{ false, nullptr, -1, 0, 0, {} };
     auto path = document_root_;
 
     if (!document_root_.empty())
@@ -1044,15 +1903,12 @@ bool manager::send_response(connection_ptr connection,
             for (const auto& index: index_files)
             {
                 const auto test_path = path / index;
-                if (boost::filesystem::exists(test_path))
+                if (boost::filesystem::exists(test_path, ec))
                 {
                     path = test_path;
                     break;
                 }
             }
-
-            if (path == document_root_)
-                return false;
         }
         else
         {
@@ -1061,58 +1917,205 @@ bool manager::send_response(connection_ptr connection,
         }
     }
 
-    if (!boost::filesystem::exists(path))
+    // The document root itself is not served.
+    file.found = path != document_root_ &&
+        boost::filesystem::exists(path, ec);
+
+    // Assets are limited to what can be buffered at once, others are sent
+    // from the file as the connection drains.
+    if (file.found && cacheable)
+        file.asset = assets_.read(path, &pool_compressor(compressor_));
+
+    if (file.found && !file.asset)
     {
-        LOG_VERBOSE(LOG_PROTOCOL_HTTP)
-            << "Requested Path: " << path << " does not exist";
+        // BUGBUG: UTF8 string passed to Windows ANSI parameter.
+        // TODO: use wide character API and Unicode conversion.
+        const auto name = path.generic_string();
+
+#ifdef _MSC_VER
+        file.descriptor = _open(name.c_str(), _O_RDONLY | _O_BINARY);
+#else
+        file.descriptor = ::open(name.c_str(), O_RDONLY);
+#endif
+        file.size = static_cast<size_t>(boost::filesystem::file_size(path,
+            ec));
 
-        std::stringstream response;
-        const auto time = time_string();
+        if (!ec)
+            file.modified = boost::filesystem::last_write_time(path, ec);
 
-        if (page_data_.empty())
+        if (ec && file.descriptor >= 0)
         {
-            response
-                << "HTTP/1.1 404 Not Found\r\n"
-                << "Date: " << time << "\r\n"
-                << "Content-Type: text/html\r\n"
-                << "Content-Length: 90\r\n\r\n"
-                << "<html><head><title>Page not found</title></head>"
-                << "<body>The page was not found.</body></html>\r\n\r\n";
+            CLOSE_FILE(file.descriptor);
+            file.descriptor = -1;
         }
-        else
+
+#ifdef POSIX_FADV_SEQUENTIAL
+        // Widen readahead so that sendfile rarely waits on the disk.
+        if (file.descriptor >= 0)
+            ::posix_fadvise(file.descriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+        file.mime_type = mime_type(path);
+    }
+
+    execute(std::make_shared<file_task>(connection,
+        [this, connection, request, file, version]()
         {
-            response
-                << "HTTP/1.0 200 OK\r\n"
-                << "Date: " << time << "\r\n"
-                << "Content-Type: text/html\r\n"
-                << "Content-Length: " << page_data_.size() << "\r\n\r\n"
-                << page_data_ << "\r\n\r\n";
-        }
+            return complete_file(connection, request, file, version);
+        }));
+}
+
+bool manager::complete_file(connection_ptr connection,
+    const http_request& request, const file_result& file, uint64_t version)
+{
+    connection->file_transfer().pending = false;
+
+    if (connection->closed())
+    {
+        if (file.descriptor >= 0)
+            CLOSE_FILE(file.descriptor);
 
-        connection->write(response.str());
         return true;
     }
 
-    const auto keep_alive =
-        ((request.protocol.find("HTTP/1.0") == std::string::npos) ||
-        (request.header(std::string("Connection")) == "keep-alive"));
+    if (file.asset)
+    {
+        assets_.insert(request.uri, file.asset, version);
+        return send_asset(connection, request, *file.asset);
+    }
 
-    return send_http_file(connection, path, keep_alive);
+    if (file.found)
+        return file.descriptor >= 0 &&
+            send_http_file(connection, file, request);
+
+    LOG_VERBOSE(LOG_PROTOCOL_HTTP)
+        << "Requested Path: " << request.uri << " does not exist";
+
+    static const std::string not_found_page =
+        "<html><head><title>Page not found</title></head>"
+        "<body>The page was not found.</body></html>";
+
+    static const std::string html = "text/html";
+    const auto keep_alive = is_keep_alive(request);
+
+    if (page_data_.empty())
+        return connection->write_header(protocol_status::not_found, html,
+            not_found_page.size(), keep_alive) >= 0 &&
+            connection->write(not_found_page) >= 0;
+
+    return connection->write_header(protocol_status::ok, html,
+        page_data_.size(), keep_alive) >= 0 &&
+        connection->write(page_data_) >= 0;
+}
+
+bool manager::send_asset(connection_ptr connection,
+    const http_request& request, const asset_cache::asset& asset)
+{
+    const auto keep_alive = is_keep_alive(request);
+    const auto& variant = asset.select(request.header("accept-encoding"));
+
+    if (asset_cache::matches(request.header("if-none-match"), variant.etag))
+        return connection->write_header(protocol_status::not_modified,
+            variant.not_modified_fields, keep_alive) >= 0;
+
+    if (connection->write_header(protocol_status::ok, variant.fields,
+        keep_alive) < 0)
+        return false;
+
+    // HEAD is answered as GET without the body.
+    if (request.method == "head")
+        return true;
+
+    return connection->write(variant.body) >= 0;
 }
 
 bool manager::send_generated_reply(connection_ptr connection,
     protocol_status status)
 {
-    http_reply reply;
-    return connection->write(reply.generate(status, {}, size_t{ 0 }, false))
-        != 0;
+    return connection->write_header(status, {}, size_t{ 0 }, false) >= 0;
+}
+
+// The route answers the active slot, unless only the method is not routed.
+bool manager::send_route(connection_ptr connection,
+    const http_request& request, const route_table::handler* route,
+    const route_table::parameter_map& parameters, const std::string& allowed)
+{
+    const auto slot = connection->active_slot();
+    connection->set_content_coding(slot, compressor_.negotiate(
+        request.header("accept-encoding")));
+
+    if (route != nullptr)
+        return (*route)(connection, request, parameters);
+
+    LOG_VERBOSE(LOG_PROTOCOL_HTTP)
+        << "Method " << request.method << " not routed at " << request.uri;
+
+    if (connection->http2() != nullptr)
+        return connection->write_response(slot,
+            protocol_status::method_not_allowed, {});
+
+    const auto fields =
+        "Allow: " + allowed + "\r\n"
+        "Content-Length: 0\r\n";
+
+    return connection->write_response(slot, http_reply::generate(
+        protocol_status::method_not_allowed, fields,
+        connection->keep_alive()));
+}
+
+// The user handler is notified of the event stream as an accepted
+// connection (so that broadcasts reach it) and then with its request (so that
+// missed events may be replayed).
+bool manager::start_event_stream(connection_ptr connection,
+    http_request& request)
+{
+    static const std::string fields =
+        "Content-Type: text/event-stream\r\n"
+        "Cache-Control: no-cache\r\n";
+
+    // An HTTP/1.0 stream is not chunked, it is instead delimited by close.
+    const auto chunked = connection->chunked();
+    connection->set_event_stream(true);
+    connection->set_keep_alive(true);
+
+    if (connection->write_header(protocol_status::ok, chunked ?
+        fields + "Transfer-Encoding: chunked\r\n" : fields, chunked) < 0)
+        return false;
+
+    return handler_(connection, event::accepted, nullptr) &&
+        handler_(connection, event::event_stream,
+            reinterpret_cast<void*>(&request));
+}
+
+// The first subprotocol offered (a comma separated list of tokens) that is
+// supported, or empty if none (the server must not agree to any other).
+static std::string select_protocol(const manager::protocol_list& supported,
+    const std::string& offered)
+{
+    std::string token;
+    std::istringstream stream(offered);
+
+    while (std::getline(stream, token, ','))
+    {
+        const auto begin = token.find_first_not_of(" \t");
+        const auto end = token.find_last_not_of(" \t");
+        if (begin == std::string::npos)
+            continue;
+
+        const auto protocol = token.substr(begin, end - begin + 1);
+        if (std::find(supported.begin(), supported.end(), protocol) !=
+            supported.end())
+            return protocol;
+    }
+
+    return {};
 }
 
 bool manager::upgrade_connection(connection_ptr connection,
     const http_request& request)
 {
     // Request MUST be GET and Protocol must be at least 1.1
-    if ((request.method != "get") || (request.protocol_version >= 1.1f))
+    if ((request.method != "get") || (request.protocol_version < 1.1))
     {
         LOG_ERROR(LOG_PROTOCOL_HTTP)
             << "Rejecting upgrade request for method " << request.method
@@ -1153,8 +2156,17 @@ bool manager::upgrade_connection(connection_ptr connection,
 
     http_reply reply;
     const auto key_response = websocket_key_response(key);
-    const auto protocol = request.header("sec-websocket-protocol");
-    const auto response = reply.generate_upgrade(key_response, protocol);
+    const auto protocol = select_protocol(websocket_protocols_,
+        request.header("sec-websocket-protocol"));
+
+    // Compression is agreed only if offered acceptably by the client.
+    websocket_deflate::parameters agreed{};
+    const auto extensions = deflate_.negotiate(agreed,
+        request.header("sec-websocket-extensions")) ?
+            websocket_deflate::to_string(agreed) : std::string{};
+
+    const auto response = reply.generate_upgrade(key_response, protocol,
+        extensions);
 
     // Unbuffered since not websocket yet and must complete before upgrade.
     const auto result = connection->unbuffered_write(response);
@@ -1169,6 +2181,9 @@ bool manager::upgrade_connection(connection_ptr connection,
     }
 
     connection->set_websocket(true);
+    connection->set_websocket_protocol(protocol);
+    connection->set_websocket_deflate(&deflate_, agreed);
+    connection->keepalive().start(loop_monitor::clock::now());
     connection->set_uri(request.uri);
 
     LOG_VERBOSE(LOG_PROTOCOL_HTTP)
@@ -1202,6 +2217,16 @@ bool manager::initialize_ssl(connection_ptr connection, bool listener)
         mbedtls_ssl_conf_min_version(&configuration,
             MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
         mbedtls_ssl_conf_rng(&configuration, https_random, nullptr);
+
+#ifdef MBEDTLS_SSL_ALPN
+        // HTTP/2 serves only JSON-RPC and routes, so it is offered (and then
+        // preferred, the client preface identifying it) only where no files
+        // are served. A browser would otherwise be refused every page.
+        static const char* rpc_protocols[] = { "h2", "http/1.1", nullptr };
+        static const char* file_protocols[] = { "http/1.1", nullptr };
+        mbedtls_ssl_conf_alpn_protocols(&configuration,
+            document_root_.empty() ? rpc_protocols : file_protocols);
+#endif
     }
 
     if (!certificate_.empty())
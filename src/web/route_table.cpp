@@ -0,0 +1,247 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/protocol/web/route_table.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <bitcoin/protocol/web/connection.hpp>
+#include <bitcoin/protocol/web/http.hpp>
+#include <bitcoin/protocol/web/http_request.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+// The root is never a child, so index zero also denotes no node.
+static constexpr uint32_t no_node = 0;
+
+static std::string to_case(std::string value, bool upper)
+{
+    std::transform(value.begin(), value.end(), value.begin(),
+        [upper](char character)
+        {
+            const auto byte = static_cast<unsigned char>(character);
+            return static_cast<char>(upper ? std::toupper(byte) :
+                std::tolower(byte));
+        });
+
+    return value;
+}
+
+route_table::route_table()
+  : nodes_(1, node{ {}, {}, {}, no_node, {} })
+{
+}
+
+bool route_table::add(const std::string& method, const std::string& pattern,
+    handler target)
+{
+    if (method.empty() || pattern.empty() || pattern.front() != '/' ||
+        !target)
+        return false;
+
+    uint32_t current = 0;
+    size_t offset = 0;
+
+    // Nodes added for a pattern that is then rejected route nothing.
+    while (offset < pattern.size())
+    {
+        if (pattern[offset] != ':')
+        {
+            const auto end = std::min(pattern.find(':', offset),
+                pattern.size());
+            current = insert(current, pattern.substr(offset, end - offset));
+            offset = end;
+            continue;
+        }
+
+        // A parameter is a whole segment.
+        const auto end = std::min(pattern.find('/', offset), pattern.size());
+        const auto name = pattern.substr(offset + 1, end - offset - 1);
+        if (name.empty() || pattern[offset - 1] != '/')
+            return false;
+
+        auto parameter = nodes_[current].parameter;
+        if (parameter == no_node)
+        {
+            parameter = static_cast<uint32_t>(nodes_.size());
+            nodes_[current].parameter = parameter;
+            nodes_.push_back(node{ {}, name, {}, no_node, {} });
+        }
+        else if (nodes_[parameter].name != name)
+        {
+            return false;
+        }
+
+        current = parameter;
+        offset = end;
+    }
+
+    auto& methods = nodes_[current].methods;
+    const auto name = to_case(method, false);
+    const auto routed = [&name](const method_list::value_type& entry)
+    {
+        return entry.first == name;
+    };
+
+    if (std::any_of(methods.begin(), methods.end(), routed))
+        return false;
+
+    methods.emplace_back(name, target);
+    return true;
+}
+
+// Add the static label below the parent, splitting an edge that shares only
+// part of it, and return the node at which the label ends.
+uint32_t route_table::insert(uint32_t parent, const std::string& label)
+{
+    auto current = parent;
+    size_t offset = 0;
+
+    while (offset < label.size())
+    {
+        // Children are distinguished by the first character of their labels.
+        auto& children = nodes_[current].children;
+        const auto first = label[offset];
+        const auto child = std::find_if(children.begin(), children.end(),
+            [this, first](uint32_t index)
+            {
+                return nodes_[index].label.front() == first;
+            });
+
+        if (child == children.end())
+        {
+            const auto index = static_cast<uint32_t>(nodes_.size());
+            children.push_back(index);
+            nodes_.push_back(node{ label.substr(offset), {}, {}, no_node, {} });
+            return index;
+        }
+
+        const auto index = *child;
+        const auto& existing = nodes_[index].label;
+        const auto remaining = label.size() - offset;
+
+        size_t common = 1;
+        while (common < existing.size() && common < remaining &&
+            existing[common] == label[offset + common])
+            ++common;
+
+        if (common < existing.size())
+        {
+            const auto split = static_cast<uint32_t>(nodes_.size());
+            node prefix{ existing.substr(0, common), {}, { index }, no_node,
+                {} };
+
+            *child = split;
+            nodes_[index].label.erase(0, common);
+            nodes_.push_back(std::move(prefix));
+            current = split;
+        }
+        else
+        {
+            current = index;
+        }
+
+        offset += common;
+    }
+
+    return current;
+}
+
+bool route_table::empty() const
+{
+    return nodes_.size() == 1;
+}
+
+const route_table::handler* route_table::find(parameter_map& parameters,
+    std::string& allowed, const std::string& method,
+    const std::string& path) const
+{
+    allowed.clear();
+    if (empty())
+        return nullptr;
+
+    parameter_map captured;
+    const auto index = match(0, path, 0, captured);
+    if (index == no_node)
+        return nullptr;
+
+    const auto name = to_case(method, false);
+    for (const auto& entry: nodes_[index].methods)
+    {
+        if (entry.first == name)
+        {
+            parameters.insert(captured.begin(), captured.end());
+            return &entry.second;
+        }
+    }
+
+    for (const auto& entry: nodes_[index].methods)
+        allowed += (allowed.empty() ? "" : ", ") + to_case(entry.first, true);
+
+    return nullptr;
+}
+
+// Static children are tried before the parameter, which is only captured
+// once the remainder of the path has matched.
+uint32_t route_table::match(uint32_t index, const std::string& path,
+    size_t offset, parameter_map& parameters) const
+{
+    const auto& current = nodes_[index];
+    if (offset == path.size())
+        return current.methods.empty() ? no_node : index;
+
+    for (const auto child: current.children)
+    {
+        const auto& label = nodes_[child].label;
+        if (label.front() != path[offset] ||
+            path.compare(offset, label.size(), label) != 0)
+            continue;
+
+        const auto result = match(child, path, offset + label.size(),
+            parameters);
+        if (result != no_node)
+            return result;
+
+        // Only one child can share the first character.
+        break;
+    }
+
+    if (current.parameter == no_node)
+        return no_node;
+
+    const auto end = std::min(path.find('/', offset), path.size());
+    if (end == offset)
+        return no_node;
+
+    const auto& parameter = nodes_[current.parameter];
+    const auto result = match(current.parameter, path, end, parameters);
+    if (result != no_node)
+        parameters[parameter.name] = path.substr(offset, end - offset);
+
+    return result;
+}
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
@@ -34,13 +34,25 @@ using namespace http;
 using http_event = http::event;
 using role = zmq::socket::role;
 
+// Frame a JSON-RPC reply and write it in request order.
+static bool write_rpc_response(connection_ptr connection, uint32_t slot,
+    protocol_status status, const std::string& data)
+{
+    LOG_VERBOSE(LOG_PROTOCOL_HTTP)
+        << "Writing JSON-RPC response: " << data;
+
+    return connection->write_response(slot, status, data);
+}
+
 // Local class.
 class task_sender
   : public manager::task
 {
 public:
-    task_sender(connection_ptr connection, const std::string& data)
-      : connection_(connection), data_(data)
+    task_sender(connection_ptr connection, const std::string& data,
+        uint32_t slot, uint64_t event_id=0)
+      : connection_(connection), data_(data), slot_(slot),
+        event_id_(event_id)
     {
     }
 
@@ -49,6 +61,13 @@ public:
         if (!connection_ || connection_->closed())
             return false;
 
+        if (connection_->event_stream())
+            return connection_->write_event(event_id_, data_);
+
+        if (connection_->json_rpc())
+            return write_rpc_response(connection_, slot_, protocol_status::ok,
+                data_);
+
         auto narrow = [](int32_t& out, size_t in)
         {
             out = static_cast<int32_t>(in);
@@ -60,25 +79,80 @@ public:
         if (!narrow(data_size, data_.size()))
             return false;
 
-        if (!connection_->json_rpc())
-        {
-            LOG_VERBOSE(LOG_PROTOCOL_HTTP)
-                << "Writing Websocket response: " << data_;
-            return connection_->write(data_) == data_size;
-        }
+        LOG_VERBOSE(LOG_PROTOCOL_HTTP)
+            << "Writing Websocket response: " << data_;
+        return connection_->write(data_) == data_size;
+    }
 
-        http_reply reply;
-        const auto response = reply.generate(protocol_status::ok, {},
-            data_.size(), false) + data_;
+    connection_ptr connection()
+    {
+        return connection_;
+    }
+
+private:
+    connection_ptr connection_;
+    const std::string data_;
+    const uint32_t slot_;
+    const uint64_t event_id_;
+};
 
+// Local class.
+class broadcast_task_sender
+  : public manager::task
+{
+public:
+    broadcast_task_sender(manager& manager, connection_list&& connections,
+        const std::string& data)
+      : manager_(manager), connections_(std::move(connections)), data_(data)
+    {
+    }
+
+    // Failed connections are closed by the manager.
+    bool run()
+    {
         LOG_VERBOSE(LOG_PROTOCOL_HTTP)
-            << "Writing JSON-RPC response: " << response;
+            << "Broadcasting Websocket message to " << connections_.size()
+            << " connections: " << data_;
 
-        int32_t response_size;
-        if (!narrow(response_size, response.size()))
+        manager_.broadcast(connections_, data_);
+        return true;
+    }
+
+    connection_ptr connection()
+    {
+        return {};
+    }
+
+private:
+    manager& manager_;
+    const connection_list connections_;
+    const std::string data_;
+};
+
+// Local class.
+class stream_task_sender
+  : public manager::task
+{
+public:
+    stream_task_sender(connection_ptr connection,
+        connection::producer producer, uint32_t slot)
+      : connection_(connection), producer_(producer), slot_(slot)
+    {
+    }
+
+    bool run()
+    {
+        if (!connection_ || connection_->closed())
             return false;
 
-        return connection_->write(response) == response_size;
+        LOG_VERBOSE(LOG_PROTOCOL_HTTP)
+            << "Streaming JSON-RPC response to " << connection_;
+
+        http_reply reply;
+        const auto header = reply.generate_chunked(protocol_status::ok, {},
+            connection_->keep_alive());
+
+        return connection_->write_stream(slot_, header, producer_);
     }
 
     connection_ptr connection()
@@ -88,7 +162,8 @@ public:
 
 private:
     connection_ptr connection_;
-    const std::string data_;
+    const connection::producer producer_;
+    const uint32_t slot_;
 };
 
 // Local class.
@@ -163,10 +238,26 @@ public:
         BITCOIN_ASSERT(work.connection == connection);
         BITCOIN_ASSERT(work.correlation_id == sequence_);
 
+        // A binary query is answered with the zmq response as is.
+        if (work.binary)
+        {
+            const auto response = binary_query::encode(work.command, id,
+                data_);
+            return connection->write(response.data(), response.size(),
+                websocket_op::binary) >= 0;
+        }
+
+        // Replies made while decoding are sequenced to this request.
+        connection->set_active_slot(work.slot);
+
         auto write_error = [&work](system::code ec, uint32_t id, bool rpc)
         {
-            const auto reply = rpc ? rpc::to_json(ec, id) : to_json(ec, id);
-            work.connection->write(reply);
+            if (rpc)
+                write_rpc_response(work.connection, work.slot,
+                    protocol_status::ok, rpc::to_json(ec, id));
+            else
+                work.connection->write(to_json(ec, id));
+
             return true;
         };
 
@@ -228,7 +319,7 @@ bool socket::handle_event(connection_ptr connection, http_event event,
             instance->add_connection(connection);
 
             const auto connection_type = connection->json_rpc() ? "JSON-RPC" :
-                "Websocket";
+                connection->event_stream() ? "Event stream" : "Websocket";
             LOG_DEBUG(LOG_PROTOCOL)
                 << connection_type << " client connection established ["
                 << connection << "] (" << instance->connection_count() << ")";
@@ -249,13 +340,11 @@ bool socket::handle_event(connection_ptr connection, http_event event,
             const auto id = request.json_tree.get<uint32_t>("id", 0);
             const auto method = request.json_tree.get<std::string>("method", "");
 
+            // The request is answered in its slot (or stream) regardless.
             if (request.json_tree.count("params") == 0)
-            {
-                http_reply reply;
-                connection->write(reply.generate(
-                    protocol_status::bad_request, {}, 0, false));
-                return false;
-            }
+                return write_rpc_response(connection,
+                    connection->active_slot(), protocol_status::bad_request,
+                    {});
 
             std::vector<std::string> parameter_list;
             const auto child = request.json_tree.get_child("params");
@@ -287,6 +376,28 @@ bool socket::handle_event(connection_ptr connection, http_event event,
             BITCOIN_ASSERT(data != nullptr);
             auto message = reinterpret_cast<const websocket_message*>(data);
 
+            // Binary messages are only defined by the binary subprotocol.
+            if (message->code == websocket_op::binary)
+            {
+                binary_query query;
+                if (connection->websocket_protocol() !=
+                    binary_query::protocol || !binary_query::decode(query,
+                        message->data, message->size))
+                {
+                    LOG_DEBUG(LOG_PROTOCOL)
+                        << "Invalid binary websocket query from ["
+                        << connection << "]";
+                    return false;
+                }
+
+                LOG_VERBOSE(LOG_PROTOCOL)
+                    << "binary command " << query.command << ", id "
+                    << query.id;
+
+                instance->notify_binary_query(connection, query);
+                break;
+            }
+
             ptree input_tree;
             if (!property_tree(input_tree,
                 { message->data, message->data + message->size }))
@@ -316,10 +427,36 @@ bool socket::handle_event(connection_ptr connection, http_event event,
                 << "method " << method << ", parameters " << parameters
                 << ", id " << id;
 
+            // Subscriptions are answered here, not by the query service.
+            if (instance->subscription(connection, method, id, parameters))
+                break;
+
             instance->notify_query_work(connection, method, id, parameters);
             break;
         }
 
+        case http_event::event_stream:
+        {
+            // A reconnecting event stream client names the last event it
+            // received, anything more recent that is retained is resent.
+            auto instance = static_cast<socket*>(connection->user_data());
+            BITCOIN_ASSERT(instance != nullptr);
+            BITCOIN_ASSERT(data != nullptr);
+            const auto& request = *reinterpret_cast<const http_request*>(data);
+            const auto last_event_id = request.header("last-event-id");
+
+            if (!last_event_id.empty())
+            {
+                // Use stream extraction to avoid exceptions on invalid input.
+                uint64_t last = 0;
+                std::istringstream stream(last_event_id);
+                if ((stream >> last) && stream.eof())
+                    instance->replay(connection, last);
+            }
+
+            break;
+        }
+
         case http_event::closing:
         {
             // This connection is going away after this handling.
@@ -327,7 +464,8 @@ bool socket::handle_event(connection_ptr connection, http_event event,
             BITCOIN_ASSERT(instance != nullptr);
             instance->remove_connection(connection);
 
-            const auto type = connection->json_rpc() ? "JSON-RPC" : "Websocket";
+            const auto type = connection->json_rpc() ? "JSON-RPC" :
+                connection->event_stream() ? "Event stream" : "Websocket";
             LOG_DEBUG(LOG_PROTOCOL)
                 << type << " client disconnected [" << connection << "] ("
                 << instance->connection_count() << ")";
@@ -347,13 +485,14 @@ bool socket::handle_event(connection_ptr connection, http_event event,
 
 socket::socket(zmq::context& context, const protocol::settings& settings,
     bool secure)
-  : worker(priority(settings.web_priority)),
+  : worker(priority(settings.web_priority), settings.worker_affinity),
     context_(context),
     secure_(secure),
     security_(secure ? "secure" : "public"),
     settings_(settings),
     sequence_(0),
-    manager_(nullptr)
+    manager_(nullptr),
+    event_id_(0)
 {
 }
 
@@ -453,6 +592,14 @@ void socket::handle_websockets()
 {
     bind_options options;
 
+    // Connection buffers are first touched on this thread, so pinning it also
+    // keeps them on the local NUMA node.
+    if (!set_affinity(settings_.web_affinity))
+    {
+        LOG_WARNING(LOG_PROTOCOL)
+            << "Failed to set websocket processor affinity.";
+    }
+
     auto format_origins = [](const config::endpoint::list& endpoints)
     {
         manager::origin_list origins;
@@ -475,6 +622,46 @@ void socket::handle_websockets()
         return;
     }
 
+    manager_->monitor().set_budget(asio::milliseconds(
+        settings_.web_loop_budget_milliseconds));
+
+    const manager::admission_limits limits
+    {
+        settings_.web_connection_limit,
+        settings_.web_pending_query_limit,
+        static_cast<size_t>(settings_.web_outbound_byte_limit),
+        settings_.web_reject_overload
+    };
+
+    manager_->set_admission_limits(limits, [this]()
+    {
+        return pending_query_count();
+    });
+
+    manager_->set_compression(compression_level(),
+        settings_.web_compression_threshold);
+    manager_->set_websocket_limit(settings_.web_websocket_message_bytes);
+    manager_->set_websocket_compression(compression_level(),
+        settings_.web_websocket_window_bits,
+        settings_.web_websocket_context_takeover);
+    manager_->set_websocket_keepalive(
+        asio::seconds(settings_.web_websocket_ping_seconds),
+        settings_.web_websocket_missed_pongs);
+
+    // Query clients may skip JSON with the binary subprotocol.
+    if (!handlers_.empty())
+        manager_->set_websocket_protocols({ binary_query::protocol });
+
+    // A cached file is buffered whole, so it must fit within the connection
+    // high water mark (2MB) along with its header.
+    static constexpr uint32_t maximum_asset_file_bytes = 1024 * 1024;
+
+    manager_->assets().set_limits(
+        static_cast<size_t>(settings_.web_asset_cache_bytes),
+        std::min(settings_.web_asset_file_bytes, maximum_asset_file_bytes));
+
+    manager_->routes() = routes_;
+
     if (secure_)
     {
         options.ssl_key = settings_.web_server_private_key;
@@ -513,6 +700,11 @@ const std::shared_ptr<zmq::socket> socket::service() const
     return nullptr;
 }
 
+int32_t socket::compression_level() const
+{
+    return static_cast<int32_t>(settings_.web_compression_level);
+}
+
 bool socket::start_websocket_handler()
 {
     auto status = socket_started_.get_future();
@@ -533,6 +725,12 @@ size_t socket::connection_count() const
     return work_.size();
 }
 
+// Called by the websocket handling thread via the manager.
+size_t socket::pending_query_count() const
+{
+    return correlations_.size();
+}
+
 // Called by the websocket handling thread via handle_event.
 void socket::add_connection(connection_ptr connection)
 {
@@ -567,6 +765,42 @@ void socket::remove_connection(connection_ptr connection)
         query_work_map.clear();
         work_.erase(it);
     }
+
+    // Critical Section.
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(subscription_mutex_);
+    subscriptions_.remove(connection);
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Called by the websocket handling thread via handle_event.
+//
+// False if the method is not a subscription method, otherwise the result is
+// written (an error code, as zmq subscriptions are answered).
+bool socket::subscription(connection_ptr connection, const std::string& method,
+    uint32_t id, const std::string& topic)
+{
+    const auto subscribe = method == "subscribe";
+    if (!subscribe && method != "unsubscribe")
+        return false;
+
+    bool result;
+
+    // Critical Section.
+    ///////////////////////////////////////////////////////////////////////////
+    subscription_mutex_.lock();
+    result = subscribe ? subscriptions_.subscribe(connection, topic) :
+        subscriptions_.unsubscribe(connection, topic);
+    subscription_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    LOG_VERBOSE(LOG_PROTOCOL)
+        << (subscribe ? "Subscribe " : "Unsubscribe ") << topic << " ["
+        << connection << "] " << (result ? "succeeded" : "failed");
+
+    connection->write(to_json(result ? system::error::success :
+        system::error::http_invalid_request, id));
+    return true;
 }
 
 // Called by the websocket handling thread via handle_event.
@@ -577,10 +811,17 @@ void socket::notify_query_work(connection_ptr connection,
     const std::string& method, uint32_t id, const std::string& parameters)
 {
     const auto rpc = connection->json_rpc();
+    const auto slot = connection->active_slot();
     const auto send_error_reply = [=](protocol_status status, const code& ec)
     {
+        if (rpc)
+        {
+            write_rpc_response(connection, slot, status, rpc::to_json(ec, id));
+            return;
+        }
+
         http_reply reply;
-        const auto error = (rpc ? rpc::to_json(ec, id) : to_json(ec, id));
+        const auto error = to_json(ec, id);
         const auto response = reply.generate(status, {}, error.size(), false);
         LOG_VERBOSE(LOG_PROTOCOL) << response + error;
         connection->write(response + error);
@@ -625,7 +866,8 @@ void socket::notify_query_work(connection_ptr connection,
     {
         LOG_ERROR(LOG_PROTOCOL)
             << "Query work provided for unknown connection " << connection;
-        return;
+        return send_error_reply(protocol_status::internal_server_error,
+            system::error::http_internal_error);
     }
 
     auto& query_work_map = it->second;
@@ -637,7 +879,8 @@ void socket::notify_query_work(connection_ptr connection,
     }
 
     query_work_map.emplace(id,
-        query_work_item{ id, sequence_, connection, method, parameters });
+        query_work_item{ id, sequence_, connection, method, parameters, slot,
+            false });
 
     // Encode request based on query work and send to query_websocket.
     zmq::message request;
@@ -670,29 +913,197 @@ void socket::notify_query_work(connection_ptr connection,
     }
 }
 
-// Sends json strings to the specified web or json_rpc socket (does nothing if
-// neither).
+// The query is forwarded as the parts of a zmq query, without translation,
+// so its command must be that of a query handler.
+void socket::notify_binary_query(connection_ptr connection,
+    const binary_query& query)
+{
+    const auto send_error_reply = [&](const code& ec)
+    {
+        const auto error = binary_query::encode(query.command, query.id,
+            to_chunk(to_little_endian(static_cast<uint32_t>(ec.value()))));
+        connection->write(error.data(), error.size(), websocket_op::binary);
+    };
+
+    const auto command = [&query](const handler_map::value_type& entry)
+    {
+        return entry.second.command == query.command;
+    };
+
+    if (std::none_of(handlers_.begin(), handlers_.end(), command))
+    {
+        LOG_VERBOSE(LOG_PROTOCOL)
+            << "Binary command " << query.command << " not found";
+        return send_error_reply(system::error::http_method_not_found);
+    }
+
+    auto it = work_.find(connection);
+    if (it == work_.end())
+    {
+        LOG_ERROR(LOG_PROTOCOL)
+            << "Query work provided for unknown connection " << connection;
+        return send_error_reply(system::error::http_internal_error);
+    }
+
+    auto& query_work_map = it->second;
+    if (query_work_map.find(query.id) != query_work_map.end())
+        return send_error_reply(system::error::http_internal_error);
+
+    query_work_map.emplace(query.id, query_work_item{ query.id, sequence_,
+        connection, query.command, {}, connection->active_slot(), true });
+
+    zmq::message request;
+    request.enqueue(query.command);
+    request.enqueue_little_endian(sequence_);
+    request.enqueue(query.payload);
+
+    // See notify_query_work for correlation.
+    correlations_[sequence_++] = { connection, query.id };
+
+    if (service()->send(request))
+        send_error_reply(system::error::http_internal_error);
+}
+
+// Sends json strings to the specified web, json_rpc or event stream socket
+// (does nothing if none).
 void socket::send(connection_ptr connection, const std::string& json)
 {
-    if (!connection || connection->closed() ||
-        (!connection->websocket() && !connection->json_rpc()))
+    if (!connection || !connection->event_stream())
+    {
+        send(connection, json, 0);
+        return;
+    }
+
+    // Events sent to a single stream are numbered but not retained.
+    uint64_t event_id;
+
+    // Critical Section.
+    ///////////////////////////////////////////////////////////////////////////
+    event_mutex_.lock();
+    event_id = ++event_id_;
+    event_mutex_.unlock();
+    ///////////////////////////////////////////////////////////////////////////
+
+    send(connection, json, event_id);
+}
+
+void socket::send(connection_ptr connection, const std::string& json,
+    uint64_t event_id)
+{
+    if (!connection || connection->closed() || (!connection->websocket() &&
+        !connection->json_rpc() && !connection->event_stream()))
         return;
 
     // By using a task_sender via the manager's execute method, we guarantee
     // that the write is performed on the manager's websocket thread (at the
-    // expense of copied json send and response payloads).
-    manager_->execute(std::make_shared<task_sender>(connection, json));
+    // expense of copied json send and response payloads). JSON-RPC replies
+    // are sent while decoding on that thread, so the active slot is the
+    // request being answered.
+    manager_->execute(std::make_shared<task_sender>(connection, json,
+        connection->active_slot(), event_id));
+}
+
+void socket::send_stream(connection_ptr connection,
+    connection::producer producer)
+{
+    if (!connection || connection->closed() || !producer)
+        return;
+
+    if (connection->json_rpc())
+    {
+        manager_->execute(std::make_shared<stream_task_sender>(connection,
+            producer, connection->active_slot()));
+        return;
+    }
+
+    // Each call appends the next piece.
+    std::string json;
+    while (producer(json))
+        continue;
+
+    send(connection, json);
 }
 
-// Sends json strings to all connected web and json_rpc sockets.
+// Sends json strings to all connected websocket and event stream sockets.
+// JSON-RPC connections are not sent broadcasts, as a reply may only answer a
+// request (and its slot is only read on the web thread).
 void socket::broadcast(const std::string& json)
 {
-    auto sender = [this, &json](std::pair<connection_ptr, query_work_map> entry)
+    // Critical Section.
+    ///////////////////////////////////////////////////////////////////////////
+    unique_lock lock(event_mutex_);
+
+    // The event is numbered and retained while posting so that a concurrent
+    // replay cannot observe it out of order.
+    const auto event_id = ++event_id_;
+    events_.emplace_back(event_id, json);
+
+    if (events_.size() > event_replay_limit)
+        events_.pop_front();
+
+    // Websocket frames are encoded once for all websocket connections.
+    connection_list websockets;
+
+    for (const auto& entry: work_)
     {
-        send(entry.first, json);
-    };
+        const auto& connection = entry.first;
+        if (!connection)
+            continue;
+
+        if (connection->websocket())
+            websockets.push_back(connection);
+        else if (connection->event_stream())
+            send(connection, json, event_id);
+    }
+
+    if (!websockets.empty())
+        manager_->execute(std::make_shared<broadcast_task_sender>(*manager_,
+            std::move(websockets), json));
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+// Sends json strings to the websocket clients subscribed to the topic, at a
+// cost in proportion to the subscribers.
+void socket::publish(const std::string& topic, const std::string& json)
+{
+    connection_list subscribers;
+
+    // Critical Section.
+    ///////////////////////////////////////////////////////////////////////////
+    subscription_mutex_.lock_shared();
+    subscribers = subscriptions_.subscribers(topic);
+    subscription_mutex_.unlock_shared();
+    ///////////////////////////////////////////////////////////////////////////
+
+    if (subscribers.empty())
+        return;
 
-    std::for_each(work_.begin(), work_.end(), sender);
+    // The frame is encoded once for all subscribers.
+    manager_->execute(std::make_shared<broadcast_task_sender>(*manager_,
+        std::move(subscribers), json));
+}
+
+// Called by the websocket handling thread via handle_event.
+//
+// Retained broadcasts after the given event are written directly, later
+// queued events of no greater id are then skipped by the connection.
+void socket::replay(connection_ptr connection, uint64_t last_event_id)
+{
+    // Critical Section.
+    ///////////////////////////////////////////////////////////////////////////
+    shared_lock lock(event_mutex_);
+
+    for (const auto& event: events_)
+        if (event.first > last_event_id &&
+            !connection->write_event(event.first, event.second))
+            return;
+    ///////////////////////////////////////////////////////////////////////////
+}
+
+bool socket::route(const std::string& method, const std::string& pattern,
+    route_table::handler handler)
+{
+    return routes_.add(method, pattern, handler);
 }
 
 void socket::set_default_page_data(const std::string& data)
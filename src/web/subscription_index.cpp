@@ -0,0 +1,124 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/protocol/web/subscription_index.hpp>
+
+#include <cstddef>
+#include <string>
+#include <bitcoin/protocol/web/connection.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+constexpr size_t subscription_index::default_topic_limit;
+constexpr size_t subscription_index::maximum_topic_length;
+
+subscription_index::subscription_index(size_t topic_limit)
+  : topic_limit_(topic_limit)
+{
+}
+
+bool subscription_index::subscribe(connection_ptr connection,
+    const std::string& topic)
+{
+    if (!connection || topic.empty() || topic.size() > maximum_topic_length)
+        return false;
+
+    auto& topics = topics_[connection];
+    if (topics.find(topic) != topics.end())
+        return true;
+
+    if (topics.size() >= topic_limit_)
+    {
+        if (topics.empty())
+            topics_.erase(connection);
+
+        return false;
+    }
+
+    topics.insert(topic);
+    subscribers_[topic].insert(connection);
+    return true;
+}
+
+bool subscription_index::unsubscribe(connection_ptr connection,
+    const std::string& topic)
+{
+    const auto topics = topics_.find(connection);
+    if (topics == topics_.end() || topics->second.erase(topic) == 0)
+        return false;
+
+    if (topics->second.empty())
+        topics_.erase(topics);
+
+    const auto subscribers = subscribers_.find(topic);
+    if (subscribers != subscribers_.end())
+    {
+        subscribers->second.erase(connection);
+        if (subscribers->second.empty())
+            subscribers_.erase(subscribers);
+    }
+
+    return true;
+}
+
+void subscription_index::remove(connection_ptr connection)
+{
+    const auto topics = topics_.find(connection);
+    if (topics == topics_.end())
+        return;
+
+    for (const auto& topic: topics->second)
+    {
+        const auto subscribers = subscribers_.find(topic);
+        if (subscribers == subscribers_.end())
+            continue;
+
+        subscribers->second.erase(connection);
+        if (subscribers->second.empty())
+            subscribers_.erase(subscribers);
+    }
+
+    topics_.erase(topics);
+}
+
+connection_list subscription_index::subscribers(
+    const std::string& topic) const
+{
+    const auto subscribers = subscribers_.find(topic);
+    if (subscribers == subscribers_.end())
+        return {};
+
+    return { subscribers->second.begin(), subscribers->second.end() };
+}
+
+size_t subscription_index::topics() const
+{
+    return subscribers_.size();
+}
+
+size_t subscription_index::topics(connection_ptr connection) const
+{
+    const auto topics = topics_.find(connection);
+    return topics == topics_.end() ? 0 : topics->second.size();
+}
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
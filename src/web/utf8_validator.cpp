@@ -0,0 +1,480 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/protocol/web/utf8_validator.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "cpu_features.hpp"
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+typedef bool (*validate_function)(const uint8_t* data, size_t size);
+
+// The length of the character begun by the byte, or zero if the byte cannot
+// begin a character (a continuation, or the lead of an overlong or above
+// U+10FFFF encoding).
+static size_t sequence_length(uint8_t lead)
+{
+    if (lead < 0x80)
+        return 1;
+    if (lead < 0xc2)
+        return 0;
+    if (lead < 0xe0)
+        return 2;
+    if (lead < 0xf0)
+        return 3;
+    if (lead < 0xf5)
+        return 4;
+
+    return 0;
+}
+
+// The length of the valid character at the data, or zero if invalid. The
+// second byte is limited to exclude overlong, surrogate and above U+10FFFF
+// encodings (Unicode table 3-7).
+static size_t character(const uint8_t* data, size_t size)
+{
+    const auto lead = data[0];
+    const auto length = sequence_length(lead);
+    if (length <= 1 || size < length)
+        return length == 1 ? 1 : 0;
+
+    uint8_t low = 0x80;
+    uint8_t high = 0xbf;
+
+    switch (lead)
+    {
+        case 0xe0:
+            low = 0xa0;
+            break;
+        case 0xed:
+            high = 0x9f;
+            break;
+        case 0xf0:
+            low = 0x90;
+            break;
+        case 0xf4:
+            high = 0x8f;
+            break;
+        default:
+            break;
+    }
+
+    if (data[1] < low || data[1] > high)
+        return 0;
+
+    for (size_t index = 2; index < length; ++index)
+        if ((data[index] & 0xc0) != 0x80)
+            return 0;
+
+    return length;
+}
+
+// Characters are checked in turn until the end of the data or the position.
+static bool characters(const uint8_t* data, size_t size, size_t& index,
+    size_t end)
+{
+    while (index < end)
+    {
+        const auto length = character(data + index, size - index);
+        if (length == 0)
+            return false;
+
+        index += length;
+    }
+
+    return true;
+}
+
+static bool validate_scalar(const uint8_t* data, size_t size)
+{
+    static constexpr uint64_t high_bits = 0x8080808080808080;
+
+    size_t index = 0;
+    while (index < size)
+    {
+        // ASCII is skipped a word at a time.
+        if (size - index >= sizeof(uint64_t))
+        {
+            uint64_t word;
+            std::memcpy(&word, data + index, sizeof(word));
+            if ((word & high_bits) == 0)
+            {
+                index += sizeof(uint64_t);
+                continue;
+            }
+        }
+
+        if (!characters(data, size, index, index + 1))
+            return false;
+    }
+
+    return true;
+}
+
+// Vector kernels leave data too short to benefit to the scalar kernel.
+static constexpr size_t vector_minimum = 64;
+
+#ifdef CPU_FEATURES_X64
+static bool validate_sse2(const uint8_t* data, size_t size)
+{
+    static constexpr size_t width = sizeof(__m128i);
+
+    if (size < vector_minimum)
+        return validate_scalar(data, size);
+
+    size_t index = 0;
+    while (size - index >= width)
+    {
+        const auto block = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(data + index));
+
+        // Otherwise characters are checked to the end of the block (or the
+        // end of the last character beginning in it).
+        const auto end = index + width;
+        if (_mm_movemask_epi8(block) != 0 &&
+            !characters(data, size, index, end))
+            return false;
+
+        index = std::max(index, end);
+    }
+
+    return validate_scalar(data + index, size - index);
+}
+
+// Error bits of the lookup method, each a case of invalid UTF-8 detected
+// from the high nibble of a byte and both nibbles of the byte before it.
+static constexpr uint8_t too_short = 1 << 0;
+static constexpr uint8_t too_long = 1 << 1;
+static constexpr uint8_t overlong_3 = 1 << 2;
+static constexpr uint8_t too_large = 1 << 3;
+static constexpr uint8_t surrogate = 1 << 4;
+static constexpr uint8_t overlong_2 = 1 << 5;
+static constexpr uint8_t too_large_1000 = 1 << 6;
+static constexpr uint8_t overlong_4 = 1 << 6;
+static constexpr uint8_t two_continuations = 1 << 7;
+static constexpr uint8_t carry = too_short | too_long | two_continuations;
+
+// Indexed by the high nibble of the previous byte.
+static const uint8_t first_high[16]
+{
+    // ASCII.
+    too_long, too_long, too_long, too_long,
+    too_long, too_long, too_long, too_long,
+
+    // Continuation.
+    two_continuations, two_continuations,
+    two_continuations, two_continuations,
+
+    // Two byte lead (1100 and 1101).
+    too_short | overlong_2,
+    too_short,
+
+    // Three byte lead.
+    too_short | overlong_3 | surrogate,
+
+    // Four byte lead.
+    too_short | too_large | too_large_1000 | overlong_4
+};
+
+// Indexed by the low nibble of the previous byte.
+static const uint8_t first_low[16]
+{
+    carry | overlong_3 | overlong_2 | overlong_4,
+    carry | overlong_2,
+    carry,
+    carry,
+    carry | too_large,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000 | surrogate,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000
+};
+
+// Indexed by the high nibble of the byte.
+static const uint8_t second_high[16]
+{
+    // ASCII.
+    too_short, too_short, too_short, too_short,
+    too_short, too_short, too_short, too_short,
+
+    // Continuation 1000, 1001 and 101x.
+    too_long | overlong_2 | two_continuations | overlong_3 |
+        too_large_1000 | overlong_4,
+    too_long | overlong_2 | two_continuations | overlong_3 | too_large,
+    too_long | overlong_2 | two_continuations | surrogate | too_large,
+    too_long | overlong_2 | two_continuations | surrogate | too_large,
+
+    // Lead.
+    too_short, too_short, too_short, too_short
+};
+
+// A lead in the last three bytes of a block exceeds the corresponding limit
+// if its character continues into the next block.
+static const uint8_t incomplete_limits[32]
+{
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xf0 - 1, 0xe0 - 1, 0xc0 - 1
+};
+
+CPU_FEATURES_AVX2
+static __m256i lookup(const uint8_t* table, __m256i index)
+{
+    const auto lanes = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(table)));
+
+    return _mm256_shuffle_epi8(lanes, index);
+}
+
+// The input shifted to begin with the last bytes of the prior block.
+template <int Shift>
+CPU_FEATURES_AVX2
+static __m256i previous(__m256i input, __m256i prior)
+{
+    return _mm256_alignr_epi8(input,
+        _mm256_permute2x128_si256(prior, input, 0x21), 16 - Shift);
+}
+
+// Nonzero bytes are errors. A third or fourth byte of a character must be
+// a continuation, which is then excused from the two continuations error.
+CPU_FEATURES_AVX2
+static __m256i check_block(__m256i input, __m256i prior)
+{
+    const auto nibble = _mm256_set1_epi8(0x0f);
+    const auto prior1 = previous<1>(input, prior);
+    const auto high1 = _mm256_and_si256(_mm256_srli_epi16(prior1, 4), nibble);
+    const auto low1 = _mm256_and_si256(prior1, nibble);
+    const auto high = _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble);
+
+    const auto special = _mm256_and_si256(_mm256_and_si256(
+        lookup(first_high, high1), lookup(first_low, low1)),
+        lookup(second_high, high));
+
+    const auto third = _mm256_subs_epu8(previous<2>(input, prior),
+        _mm256_set1_epi8(static_cast<char>(0xe0 - 0x80)));
+    const auto fourth = _mm256_subs_epu8(previous<3>(input, prior),
+        _mm256_set1_epi8(static_cast<char>(0xf0 - 0x80)));
+    const auto required = _mm256_and_si256(_mm256_or_si256(third, fourth),
+        _mm256_set1_epi8(static_cast<char>(0x80)));
+
+    return _mm256_xor_si256(required, special);
+}
+
+CPU_FEATURES_AVX2
+static bool validate_avx2(const uint8_t* data, size_t size)
+{
+    static constexpr size_t width = sizeof(__m256i);
+
+    if (size < vector_minimum)
+        return validate_scalar(data, size);
+
+    const auto limits = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(incomplete_limits));
+
+    auto error = _mm256_setzero_si256();
+    auto prior = _mm256_setzero_si256();
+    auto incomplete = _mm256_setzero_si256();
+
+    for (size_t index = 0; index < size; index += width)
+    {
+        // The last block is padded with (ASCII) zeros.
+        uint8_t last[width];
+        const auto remaining = size - index;
+        if (remaining < width)
+        {
+            std::memset(last, 0, width);
+            std::memcpy(last, data + index, remaining);
+        }
+
+        const auto input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+            remaining < width ? last : data + index));
+
+        // ASCII cannot continue a character begun in the prior block.
+        if (_mm256_movemask_epi8(input) == 0)
+        {
+            error = _mm256_or_si256(error, incomplete);
+            incomplete = _mm256_setzero_si256();
+        }
+        else
+        {
+            error = _mm256_or_si256(error, check_block(input, prior));
+            incomplete = _mm256_subs_epu8(input, limits);
+        }
+
+        prior = input;
+    }
+
+    error = _mm256_or_si256(error, incomplete);
+    return _mm256_testz_si256(error, error) != 0;
+}
+
+#endif
+
+#ifdef CPU_FEATURES_ARM64
+static bool validate_neon(const uint8_t* data, size_t size)
+{
+    static constexpr size_t width = sizeof(uint8x16_t);
+
+    if (size < vector_minimum)
+        return validate_scalar(data, size);
+
+    size_t index = 0;
+    while (size - index >= width)
+    {
+        // Otherwise characters are checked to the end of the block (or the
+        // end of the last character beginning in it).
+        const auto end = index + width;
+        if (vmaxvq_u8(vld1q_u8(data + index)) >= 0x80 &&
+            !characters(data, size, index, end))
+            return false;
+
+        index = std::max(index, end);
+    }
+
+    return validate_scalar(data + index, size - index);
+}
+#endif
+
+// An unsupported kernel falls back to scalar.
+static validate_function select(utf8_validator::kernel type)
+{
+    if (!utf8_validator::supported(type))
+        return validate_scalar;
+
+    switch (type)
+    {
+#ifdef CPU_FEATURES_X64
+        case utf8_validator::kernel::sse2:
+            return validate_sse2;
+        case utf8_validator::kernel::avx2:
+            return validate_avx2;
+#endif
+#ifdef CPU_FEATURES_ARM64
+        case utf8_validator::kernel::neon:
+            return validate_neon;
+#endif
+        case utf8_validator::kernel::scalar:
+        default:
+            return validate_scalar;
+    }
+}
+
+// The bytes ending the data that begin a character continued beyond it, or
+// zero if there are none (or they cannot begin a character).
+static size_t incomplete_tail(const uint8_t* data, size_t size)
+{
+    const auto limit = std::min<size_t>(size, 3);
+    for (size_t back = 1; back <= limit; ++back)
+    {
+        const auto byte = data[size - back];
+        if ((byte & 0xc0) == 0x80)
+            continue;
+
+        return sequence_length(byte) > back ? back : 0;
+    }
+
+    return 0;
+}
+
+utf8_validator::kernel utf8_validator::best()
+{
+    return cpu_features::best();
+}
+
+bool utf8_validator::supported(kernel type)
+{
+    return cpu_features::supported(type);
+}
+
+std::string utf8_validator::to_string(kernel type)
+{
+    return cpu_features::to_string(type);
+}
+
+bool utf8_validator::validate(const uint8_t* data, size_t size)
+{
+    static const auto function = select(best());
+    return function(data, size);
+}
+
+bool utf8_validator::validate(kernel type, const uint8_t* data, size_t size)
+{
+    return select(type)(data, size);
+}
+
+utf8_validator::utf8_validator()
+  : valid_(true), pending_{}, pending_size_(0)
+{
+}
+
+bool utf8_validator::update(const uint8_t* data, size_t size)
+{
+    // A character split from the previous part is completed first.
+    while (valid_ && pending_size_ != 0 && size != 0)
+    {
+        pending_[pending_size_++] = *data++;
+        --size;
+
+        if (pending_size_ == sequence_length(pending_[0]))
+        {
+            valid_ = character(pending_, pending_size_) == pending_size_;
+            pending_size_ = 0;
+        }
+    }
+
+    if (!valid_ || size == 0)
+        return valid_;
+
+    // The start of a character continued in the next part is held back.
+    const auto tail = incomplete_tail(data, size);
+    valid_ = validate(data, size - tail);
+    std::memcpy(pending_, data + size - tail, tail);
+    pending_size_ = tail;
+    return valid_;
+}
+
+bool utf8_validator::complete() const
+{
+    return valid_ && pending_size_ == 0;
+}
+
+void utf8_validator::reset()
+{
+    valid_ = true;
+    pending_size_ = 0;
+}
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
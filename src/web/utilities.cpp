@@ -18,10 +18,14 @@
  */
 #include <bitcoin/protocol/web/utilities.hpp>
 
+#include <algorithm>
 #include <cstddef>
 #include <ctime>
+#include <string>
+#include <vector>
 #include <bitcoin/system.hpp>
 #include <boost/algorithm/string.hpp>
+#include <bitcoin/protocol/web/http_parser.hpp>
 
 // TODO: missing includes.
 
@@ -132,158 +136,10 @@ bool is_json_request(const std::string& header_value)
 
 bool parse_http(http_request& out, const std::string& request)
 {
-    auto& headers = out.headers;
-    auto& parameters = out.parameters;
-
-    out.message_length = request.size();
-
-    // Parse out the first line for: Method, URI, Protocol.
-    auto position = request.find("\r\n");
-    if (position == std::string::npos)
-        return false;
-
-    const auto method_line = request.substr(0, position);
-    string_list elements;
-    boost::split(elements, method_line, boost::is_any_of(" "));
-    if (elements.size() != 3)
-        return false;
-
-    for (auto& element: elements)
-        boost::algorithm::trim(element);
-
-    // truncate the parameters from the uri (if any)
-    position = elements[1].find("?");
-    if (position != std::string::npos)
-        elements[1] = elements[1].substr(0, position);
-
-    boost::algorithm::to_lower(elements[0]);
-    boost::algorithm::to_lower(elements[2]);
-
-    out.method = elements[0];
-    out.uri = elements[1];
-    out.protocol = elements[2];
-
-    position = out.protocol.find("/");
-    if (position != std::string::npos)
-    {
-        const auto version = out.protocol.substr(position);
-        out.protocol_version = strtod(version.c_str(), nullptr);
-    }
-
-    LOG_VERBOSE(LOG_PROTOCOL_HTTP)
-        << "Parsing HTTP request: Method: " << out.method << ", Uri: "
-        << out.uri <<  ", Protocol: " << out.protocol;
-
-    // Parse out remaining lines to build both the header map and
-    // parameter map.
-    string_list header_lines;
-    boost::split(header_lines, request, boost::is_any_of("\r\n"));
-
-    auto parse_line = [&headers](const std::string& line)
-    {
-        if (line.empty())
-            return;
-
-        string_list elements;
-        boost::split(elements, line, boost::is_any_of(":"));
-        if (elements.size() == 2)
-        {
-            boost::algorithm::trim(elements[0]);
-            boost::algorithm::trim(elements[1]);
-            boost::algorithm::to_lower(elements[0]);
-
-            if (elements[0] != "sec-websocket-key")
-                boost::algorithm::to_lower(elements[1]);
-
-            headers[elements[0]] = elements[1];
-        }
-        else if (elements.size() > 2)
-        {
-            std::stringstream buffer;
-            for (size_t i = 0; i < elements.size(); i++)
-            {
-                boost::algorithm::trim(elements[i]);
-
-                if (elements[0] != "sec-websocket-key")
-                    boost::algorithm::to_lower(elements[i]);
-
-                if (i > 0)
-                {
-                    buffer << elements[i];
-                    if (i != elements.size() -1)
-                        buffer << ":";
-                }
-            }
-
-            headers[elements[0]] = buffer.str();
-        }
-    };
-
-    std::for_each(header_lines.begin(), header_lines.end(), parse_line);
-
-    // Parse passed parameters (if any)
-    position = method_line.find("?");
-    if (position != std::string::npos)
-    {
-        auto parameter_string = method_line.substr(position + 1);
-
-        string_list parameter_elements;
-        boost::split(parameter_elements, parameter_string,
-            boost::is_any_of("&"));
-
-        auto parse_parameter = [&parameters](const std::string& line)
-        {
-            if (line.empty())
-                return;
-
-            const auto line_end = line.find(" ");
-            const auto input_line = ((line_end == std::string::npos) ? line :
-                line.substr(0, line_end));
-
-            string_list elements;
-            boost::split(elements, input_line, boost::is_any_of("= "));
-            if (elements.size() == 2)
-            {
-                boost::algorithm::trim(elements[0]);
-                boost::algorithm::trim(elements[1]);
-                boost::algorithm::to_lower(elements[0]);
-                boost::algorithm::to_lower(elements[1]);
-                parameters[elements[0]] = elements[1];
-            }
-        };
-
-        std::for_each(parameter_elements.begin(), parameter_elements.end(),
-            parse_parameter);
-    }
-
-    // Determine if this request contains the content length.
-    auto content_length = headers.find("content-length");
-    out.content_length = (content_length != headers.end() ?
-        std::strtoul(content_length->second.c_str(), nullptr, 0) : 0);
-
-    // Determine if this request is an upgrade request
-    auto connection = headers.find("connection");
-    out.upgrade_request = ((connection != headers.end()) &&
-         (connection->second.find("upgrade") != std::string::npos) &&
-         (headers.find("sec-websocket-key") != headers.end()));
-
-    // Determine if this request is a JSON-RPC request, or at least
-    // one that we support (i.e. non-standard; may not contain the
-    // required accept header nor the optional content-type header),
-    // via POST-only, etc.  Instead we try to safely parse the data as
-    // JSON.
-    if (out.method == "post" && out.content_length > 0)
-    {
-        const auto json_request = request.substr(request.size() -
-            out.content_length, out.content_length);
-
-        LOG_VERBOSE(LOG_PROTOCOL_HTTP)
-            << "POST content: " << json_request;
-
-        out.json_rpc = property_tree(out.json_tree, json_request);
-    }
-
-    return true;
+    http_parser parser;
+    const auto data = reinterpret_cast<const uint8_t*>(request.data());
+    return parser.parse(data, request.size()) ==
+        http_parser::result::complete && parser.to_request(out);
 }
 
 std::string mime_type(const boost::filesystem::path& path)
@@ -350,6 +206,134 @@ std::string mime_type(const boost::filesystem::path& path)
     return { "text/plain" };
 }
 
+bool accepts_encoding(const std::string& accept_encoding,
+    const std::string& coding)
+{
+    std::vector<std::string> tokens;
+    boost::split(tokens, accept_encoding, boost::is_any_of(","));
+
+    // An explicit entry for the coding overrides the wildcard.
+    auto wildcard = false;
+
+    for (auto& token: tokens)
+    {
+        std::vector<std::string> parameters;
+        boost::split(parameters, token, boost::is_any_of(";"));
+
+        auto name = parameters.front();
+        boost::trim(name);
+
+        const auto explicit_name = boost::iequals(name, coding);
+        if (!explicit_name && name != "*")
+            continue;
+
+        auto refused = false;
+        for (auto parameter = std::next(parameters.begin());
+            parameter != parameters.end(); ++parameter)
+        {
+            auto value = *parameter;
+            boost::erase_all(value, " ");
+
+            if (boost::istarts_with(value, "q=") &&
+                value.find_first_not_of("0.", 2) == std::string::npos)
+                refused = true;
+        }
+
+        if (explicit_name)
+            return !refused;
+
+        wildcard = !refused;
+    }
+
+    return wildcard;
+}
+
+// Parse a decimal position, rejecting empty, signed or overflowing values.
+static bool parse_position(size_t& out, const std::string& text)
+{
+    if (text.empty() || text.find_first_not_of("0123456789") !=
+        std::string::npos)
+        return false;
+
+    out = 0;
+    for (const auto digit: text)
+    {
+        const size_t value = digit - '0';
+        if (out > (max_size_t - value) / 10)
+            return false;
+
+        out = out * 10 + value;
+    }
+
+    return true;
+}
+
+bool parse_ranges(byte_range_list& out, const std::string& header,
+    size_t size)
+{
+    // Limits the cost of a request, as each part is sent separately.
+    static constexpr size_t maximum_ranges = 16;
+    static const std::string unit = "bytes=";
+
+    out.clear();
+    auto value = boost::trim_copy(header);
+    if (!boost::istarts_with(value, unit))
+        return false;
+
+    std::vector<std::string> specifiers;
+    value.erase(0, unit.size());
+    boost::split(specifiers, value, boost::is_any_of(","));
+
+    size_t count = 0;
+    for (auto& specifier: specifiers)
+    {
+        // Empty list elements are permitted (RFC 7230 section 7).
+        boost::trim(specifier);
+        if (specifier.empty())
+            continue;
+
+        if (++count > maximum_ranges)
+            return false;
+
+        const auto dash = specifier.find('-');
+        if (dash == std::string::npos)
+            return false;
+
+        const auto first_text = specifier.substr(0, dash);
+        const auto last_text = specifier.substr(dash + 1);
+        size_t first;
+        size_t last;
+
+        if (first_text.empty())
+        {
+            // A suffix range, the final bytes of the representation.
+            if (!parse_position(last, last_text))
+                return false;
+
+            if (last != 0 && size != 0)
+            {
+                const auto length = std::min(last, size);
+                out.push_back({ size - length, length });
+            }
+
+            continue;
+        }
+
+        if (!parse_position(first, first_text))
+            return false;
+
+        if (last_text.empty())
+            last = size == 0 ? 0 : size - 1;
+        else if (!parse_position(last, last_text) || last < first)
+            return false;
+
+        if (first < size)
+            out.push_back({ first, std::min(last, size - 1) - first + 1 });
+    }
+
+    return count != 0;
+}
+
 } // namespace http
 } // namespace protocol
 } // namespace libbitcoin
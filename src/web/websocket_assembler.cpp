@@ -0,0 +1,111 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/protocol/web/websocket_assembler.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/system.hpp>
+#include <bitcoin/protocol/web/buffer_pool.hpp>
+#include <bitcoin/protocol/web/websocket_op.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+using namespace bc::system;
+
+static constexpr uint8_t final_flag = 0x80;
+static constexpr uint8_t op_mask = 0x0f;
+
+websocket_assembler::websocket_assembler()
+  : in_progress_(false), complete_(false), flags_(0)
+{
+}
+
+websocket_assembler::result websocket_assembler::append(buffer_pool& pool,
+    uint8_t flags, const uint8_t* data, size_t size, size_t limit)
+{
+    const auto final = (flags & final_flag) != 0;
+    const auto code = static_cast<websocket_op>(flags & op_mask);
+
+    // A completed message is not retained once the next frame arrives.
+    if (complete_)
+        reset(pool);
+
+    if (code == websocket_op::continuation)
+    {
+        if (!in_progress_)
+            return result::invalid;
+    }
+    else
+    {
+        if (in_progress_)
+            return result::invalid;
+
+        if (final)
+            return size > limit ? result::oversized : result::single;
+
+        in_progress_ = true;
+        flags_ = flags;
+        message_ = pool.acquire();
+    }
+
+    if (size > limit || message_.size() > limit - size)
+        return result::oversized;
+
+    message_.insert(message_.end(), data, data + size);
+    if (!final)
+        return result::incomplete;
+
+    flags_ |= final_flag;
+    complete_ = true;
+    return result::complete;
+}
+
+void websocket_assembler::reset(buffer_pool& pool)
+{
+    pool.release(message_);
+    in_progress_ = false;
+    complete_ = false;
+    flags_ = 0;
+}
+
+bool websocket_assembler::in_progress() const
+{
+    return in_progress_ && !complete_;
+}
+
+const data_chunk& websocket_assembler::message() const
+{
+    return message_;
+}
+
+uint8_t websocket_assembler::flags() const
+{
+    return flags_;
+}
+
+websocket_op websocket_assembler::code() const
+{
+    return static_cast<websocket_op>(flags_ & op_mask);
+}
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
@@ -0,0 +1,158 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/protocol/web/websocket_decoder.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/system.hpp>
+#include <bitcoin/protocol/web/event.hpp>
+#include <bitcoin/protocol/web/websocket_frame.hpp>
+#include <bitcoin/protocol/web/utf8_validator.hpp>
+#include <bitcoin/protocol/web/websocket_mask.hpp>
+#include <bitcoin/protocol/web/websocket_op.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+using namespace bc::system;
+
+// Control frames (close, ping, pong) carry little or no payload.
+static constexpr size_t maximum_control_payload = 125;
+
+// RSV1 marks a message compressed by permessage-deflate.
+static constexpr uint8_t compressed_flag = 0x40;
+
+// Text is validated as it is unmasked, a block at a time while in cache.
+static constexpr size_t validation_block = 4096;
+
+websocket_decoder::websocket_decoder()
+  : unmasked_(0), validating_(false)
+{
+}
+
+websocket_decoder::result websocket_decoder::decode(data_chunk& input,
+    size_t limit, const handler& handler)
+{
+    auto outcome = result::incomplete;
+    size_t position = 0;
+
+    while (position < input.size())
+    {
+        const auto data = input.data() + position;
+        const auto available = input.size() - position;
+        const websocket_frame frame(data, available);
+
+        if (!frame.complete())
+            break;
+
+        const auto control = frame.event_type() ==
+            event::websocket_control_frame;
+
+        // Control frames may arrive between fragments but are never
+        // fragmented (RFC 6455 section 5.5).
+        if (!frame || (control && (!frame.final() ||
+            frame.data_length() > maximum_control_payload)))
+        {
+            outcome = result::invalid;
+            break;
+        }
+
+        if (frame.data_length() > limit)
+        {
+            outcome = result::oversized;
+            break;
+        }
+
+        // Uncompressed text must be UTF-8, across the fragments of a message.
+        // A compressed message is validated once inflated.
+        if (!control && unmasked_ == 0)
+        {
+            const auto code = frame.op_code();
+            if (code == websocket_op::text)
+            {
+                validating_ = (frame.flags() & compressed_flag) == 0;
+                text_.reset();
+            }
+            else if (code != websocket_op::continuation)
+            {
+                validating_ = false;
+            }
+        }
+
+        // Unmask (and validate) the payload received since the last read.
+        const auto validate = validating_ && !control;
+        const auto header_length = frame.header_length();
+        const auto payload = data + header_length;
+        const auto mask = payload - frame.mask_length();
+        const auto received = std::min(frame.data_length(),
+            available - header_length);
+
+        for (auto offset = unmasked_; offset < received;
+            offset += validation_block)
+        {
+            const auto size = std::min(validation_block, received - offset);
+            websocket_mask::apply(payload + offset, size, mask, offset);
+
+            if (validate && !text_.update(payload + offset, size))
+            {
+                outcome = result::invalid_text;
+                break;
+            }
+        }
+
+        unmasked_ = received;
+
+        if (outcome == result::invalid_text ||
+            received < frame.data_length())
+            break;
+
+        // A text message may not end within a character.
+        if (validate && frame.final() && !text_.complete())
+        {
+            outcome = result::invalid_text;
+            break;
+        }
+
+        unmasked_ = 0;
+        position += header_length + frame.data_length();
+
+        if (!handler(frame, payload))
+        {
+            outcome = result::stopped;
+            break;
+        }
+    }
+
+    // Decoded frames are removed at once, moving any partial frame forward.
+    input.erase(input.begin(), input.begin() + position);
+    return outcome;
+}
+
+void websocket_decoder::reset()
+{
+    unmasked_ = 0;
+    validating_ = false;
+    text_.reset();
+}
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
@@ -0,0 +1,512 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/protocol/web/websocket_deflate.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+#include <bitcoin/system.hpp>
+
+#ifdef WITH_ZLIB
+    #include <zlib.h>
+#endif
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+using namespace bc::system;
+
+static const std::string extension_name = "permessage-deflate";
+
+// Streams of each kind and window size kept for reuse.
+static constexpr size_t maximum_pooled = 4;
+
+#ifdef WITH_ZLIB
+static constexpr int memory_level = 8;
+static constexpr size_t output_chunk = 16 * 1024;
+
+// Each message ends with an empty stored block (RFC 7692 section 7.2.1).
+static const uint8_t message_tail[]{ 0x00, 0x00, 0xff, 0xff };
+
+struct websocket_deflate::stream
+{
+    z_stream zlib;
+    bool deflater;
+    size_t window_bits;
+};
+#else
+struct websocket_deflate::stream
+{
+};
+#endif
+
+void websocket_deflate::stream_deleter::operator()(stream* value) const
+{
+#ifdef WITH_ZLIB
+    if (value->deflater)
+        deflateEnd(&value->zlib);
+    else
+        inflateEnd(&value->zlib);
+#endif
+
+    delete value;
+}
+
+constexpr size_t websocket_deflate::minimum_window_bits;
+constexpr size_t websocket_deflate::maximum_window_bits;
+constexpr size_t websocket_deflate::default_threshold;
+
+static std::string trim(const std::string& value)
+{
+    const auto space = [](char character)
+    {
+        return std::isspace(static_cast<unsigned char>(character)) != 0;
+    };
+
+    const auto begin = std::find_if_not(value.begin(), value.end(), space);
+    const auto end = std::find_if_not(value.rbegin(),
+        std::string::const_reverse_iterator(begin), space).base();
+    return { begin, end };
+}
+
+static std::vector<std::string> split(const std::string& value,
+    char delimiter)
+{
+    std::vector<std::string> out;
+    size_t start = 0;
+
+    while (true)
+    {
+        const auto end = value.find(delimiter, start);
+        out.push_back(trim(value.substr(start, end - start)));
+        if (end == std::string::npos)
+            return out;
+
+        start = end + 1;
+    }
+}
+
+static std::string to_lower(std::string value)
+{
+    std::transform(value.begin(), value.end(), value.begin(),
+        [](char character)
+        {
+            return static_cast<char>(std::tolower(
+                static_cast<unsigned char>(character)));
+        });
+
+    return value;
+}
+
+// A window bits parameter value is 8 to 15, optionally quoted.
+static bool parse_window_bits(size_t& out, std::string value)
+{
+    if (value.size() > 2 && value.front() == '"' && value.back() == '"')
+        value = value.substr(1, value.size() - 2);
+
+    if (value.empty() || value.size() > 2 ||
+        !std::all_of(value.begin(), value.end(), ::isdigit))
+        return false;
+
+    out = std::stoul(value);
+    return out >= 8 && out <= websocket_deflate::maximum_window_bits;
+}
+
+websocket_deflate::websocket_deflate(int32_t level, size_t window_bits,
+    bool context_takeover, size_t threshold)
+  : level_(0),
+    window_bits_(maximum_window_bits),
+    context_takeover_(false),
+    threshold_(default_threshold)
+{
+    configure(level, window_bits, context_takeover, threshold);
+}
+
+bool websocket_deflate::available()
+{
+#ifdef WITH_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+void websocket_deflate::configure(int32_t level, size_t window_bits,
+    bool context_takeover, size_t threshold)
+{
+    level = std::max(0, std::min(level, 9));
+    window_bits = std::max(minimum_window_bits,
+        std::min(window_bits, maximum_window_bits));
+
+    // Deflate state is initialized for a level, so pooled state is dropped.
+    if (level != level_)
+        pool_.clear();
+
+    level_ = level;
+    window_bits_ = window_bits;
+    context_takeover_ = context_takeover;
+    threshold_ = threshold;
+}
+
+bool websocket_deflate::enabled() const
+{
+    return available() && level_ != 0;
+}
+
+// The server window is no larger than the client allows (zlib cannot deflate
+// with 8 bits), and without context takeover the client is asked not to take
+// over its context either, so that neither side holds state between
+// messages.
+bool websocket_deflate::negotiate(parameters& out,
+    const std::string& offers) const
+{
+    if (!enabled() || offers.empty())
+        return false;
+
+    for (const auto& offer: split(to_lower(offers), ','))
+    {
+        const auto tokens = split(offer, ';');
+        if (tokens.front() != extension_name)
+            continue;
+
+        parameters agreed
+        {
+            true,
+            static_cast<uint8_t>(window_bits_),
+            static_cast<uint8_t>(maximum_window_bits),
+            false,
+            !context_takeover_,
+            !context_takeover_
+        };
+
+        auto valid = true;
+        std::vector<std::string> names;
+
+        for (auto token = tokens.begin() + 1; valid && token != tokens.end();
+            ++token)
+        {
+            const auto equals = token->find('=');
+            const auto name = trim(token->substr(0, equals));
+            const auto value = equals == std::string::npos ? std::string{} :
+                trim(token->substr(equals + 1));
+            size_t bits = maximum_window_bits;
+
+            // Parameters may not be repeated.
+            if (std::find(names.begin(), names.end(), name) != names.end())
+            {
+                valid = false;
+                break;
+            }
+
+            names.push_back(name);
+
+            if (name == "server_no_context_takeover")
+            {
+                valid = value.empty();
+                agreed.server_no_context_takeover = true;
+            }
+            else if (name == "client_no_context_takeover")
+            {
+                valid = value.empty();
+                agreed.client_no_context_takeover = true;
+            }
+            else if (name == "server_max_window_bits")
+            {
+                valid = parse_window_bits(bits, value) &&
+                    bits >= minimum_window_bits;
+                agreed.server_window_bits = static_cast<uint8_t>(
+                    std::min(window_bits_, bits));
+            }
+            else if (name == "client_max_window_bits")
+            {
+                valid = value.empty() || parse_window_bits(bits, value);
+                agreed.client_window_bits_offered = true;
+                agreed.client_window_bits = static_cast<uint8_t>(std::min(
+                    bits, std::max(minimum_window_bits, window_bits_)));
+            }
+            else
+            {
+                valid = false;
+            }
+        }
+
+        if (valid)
+        {
+            out = agreed;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::string websocket_deflate::to_string(const parameters& agreed)
+{
+    auto out = extension_name;
+
+    if (agreed.server_no_context_takeover)
+        out += "; server_no_context_takeover";
+
+    if (agreed.client_no_context_takeover)
+        out += "; client_no_context_takeover";
+
+    if (agreed.server_window_bits < maximum_window_bits)
+        out += "; server_max_window_bits=" +
+            std::to_string(agreed.server_window_bits);
+
+    // This may only be sent if offered.
+    if (agreed.client_window_bits_offered)
+        out += "; client_max_window_bits=" +
+            std::to_string(agreed.client_window_bits);
+
+    return out;
+}
+
+const data_chunk* websocket_deflate::compress(session& state,
+    const uint8_t* data, size_t size)
+{
+#ifdef WITH_ZLIB
+    const auto& agreed = state.agreed;
+    if (!agreed.enabled || level_ == 0 || size < threshold_ ||
+        size > std::numeric_limits<uInt>::max())
+        return nullptr;
+
+    // With context takeover the stream is held by the connection.
+    const auto takeover = !agreed.server_no_context_takeover;
+    stream_ptr borrowed;
+    auto& held = takeover ? state.deflater : borrowed;
+
+    if (!held)
+        held = acquire(true, agreed.server_window_bits);
+
+    if (!held)
+        return nullptr;
+
+    auto& zlib = held->zlib;
+    zlib.next_in = const_cast<Bytef*>(data);
+    zlib.avail_in = static_cast<uInt>(size);
+    buffer_.clear();
+
+    // The sync flush completes the message on a byte boundary.
+    int result;
+    do
+    {
+        const auto used = buffer_.size();
+        buffer_.resize(used + std::max(output_chunk, size / 2));
+        zlib.next_out = buffer_.data() + used;
+        zlib.avail_out = static_cast<uInt>(buffer_.size() - used);
+        result = deflate(&zlib, Z_SYNC_FLUSH);
+        buffer_.resize(buffer_.size() - zlib.avail_out);
+    } while ((result == Z_OK || result == Z_BUF_ERROR) &&
+        zlib.avail_out == 0);
+
+    const auto tail = sizeof(message_tail);
+    const auto flushed = (result == Z_OK || result == Z_BUF_ERROR) &&
+        buffer_.size() >= tail && std::equal(buffer_.end() - tail,
+            buffer_.end(), message_tail);
+
+    if (!flushed)
+    {
+        // The stream is discarded, and the message sent as is. A client
+        // window that includes past messages is unaffected by a new stream.
+        LOG_ERROR(LOG_PROTOCOL_HTTP)
+            << "Failed to compress websocket message.";
+        held.reset();
+        return nullptr;
+    }
+
+    buffer_.resize(buffer_.size() - tail);
+
+    if (takeover)
+        return &buffer_;
+
+    // Without context takeover the message may be sent as is if larger.
+    recycle(held);
+    return buffer_.size() < size ? &buffer_ : nullptr;
+#else
+    return nullptr;
+#endif
+}
+
+bool websocket_deflate::decompress(data_chunk& out, session& state,
+    const uint8_t* data, size_t size, size_t limit)
+{
+#ifdef WITH_ZLIB
+    const auto& agreed = state.agreed;
+    if (!agreed.enabled || size > std::numeric_limits<uInt>::max())
+        return false;
+
+    const auto takeover = !agreed.client_no_context_takeover;
+    stream_ptr borrowed;
+    auto& held = takeover ? state.inflater : borrowed;
+
+    if (!held)
+        held = acquire(false, agreed.client_window_bits);
+
+    if (!held)
+        return false;
+
+    auto& zlib = held->zlib;
+    const struct
+    {
+        const uint8_t* data;
+        size_t size;
+    } parts[]
+    {
+        { data, size },
+        { message_tail, sizeof(message_tail) }
+    };
+
+    out.clear();
+    auto valid = true;
+
+    for (const auto& part: parts)
+    {
+        zlib.next_in = const_cast<Bytef*>(part.data);
+        zlib.avail_in = static_cast<uInt>(part.size);
+
+        while (valid)
+        {
+            const auto used = out.size();
+            out.resize(used + output_chunk);
+            zlib.next_out = out.data() + used;
+            zlib.avail_out = static_cast<uInt>(output_chunk);
+            const auto result = inflate(&zlib, Z_SYNC_FLUSH);
+            out.resize(out.size() - zlib.avail_out);
+
+            // A final block ends the stream, which restarts for the next.
+            if (result == Z_STREAM_END)
+                valid = inflateReset(&zlib) == Z_OK;
+            else if (result == Z_BUF_ERROR)
+                break;
+            else
+                valid = result == Z_OK;
+
+            valid = valid && out.size() <= limit;
+
+            // Output stops short of the buffer once input is exhausted.
+            if (zlib.avail_in == 0 && zlib.avail_out != 0)
+                break;
+        }
+    }
+
+    if (!valid)
+    {
+        held.reset();
+        return false;
+    }
+
+    if (!takeover)
+        recycle(held);
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+void websocket_deflate::release(session& state)
+{
+    if (state.deflater)
+        recycle(state.deflater);
+
+    if (state.inflater)
+        recycle(state.inflater);
+}
+
+size_t websocket_deflate::pooled() const
+{
+    return pool_.size();
+}
+
+// private
+// ----------------------------------------------------------------------------
+
+websocket_deflate::stream_ptr websocket_deflate::acquire(bool deflater,
+    size_t window_bits)
+{
+#ifdef WITH_ZLIB
+    for (auto it = pool_.rbegin(); it != pool_.rend(); ++it)
+    {
+        if ((*it)->deflater == deflater && (*it)->window_bits == window_bits)
+        {
+            auto value = std::move(*it);
+            pool_.erase(std::next(it).base());
+            return value;
+        }
+    }
+
+    // Raw deflate, the stream is not moved once initialized.
+    stream_ptr value(new stream{ {}, deflater, window_bits });
+    auto& zlib = value->zlib;
+    zlib.zalloc = Z_NULL;
+    zlib.zfree = Z_NULL;
+    zlib.opaque = Z_NULL;
+
+    const auto bits = -static_cast<int>(window_bits);
+    const auto result = deflater ?
+        deflateInit2(&zlib, level_, Z_DEFLATED, bits, memory_level,
+            Z_DEFAULT_STRATEGY) : inflateInit2(&zlib, bits);
+
+    if (result != Z_OK)
+    {
+        LOG_ERROR(LOG_PROTOCOL_HTTP)
+            << "Failed to initialize websocket "
+            << (deflater ? "compressor." : "decompressor.");
+
+        // Not initialized, so not ended.
+        delete value.release();
+        return {};
+    }
+
+    return value;
+#else
+    return {};
+#endif
+}
+
+void websocket_deflate::recycle(stream_ptr& value)
+{
+#ifdef WITH_ZLIB
+    const auto kind = [&value](const stream_ptr& other)
+    {
+        return other->deflater == value->deflater &&
+            other->window_bits == value->window_bits;
+    };
+
+    const auto reset = value->deflater ? deflateReset(&value->zlib) :
+        inflateReset(&value->zlib);
+
+    if (reset == Z_OK &&
+        static_cast<size_t>(std::count_if(pool_.begin(), pool_.end(), kind)) <
+            maximum_pooled)
+        pool_.push_back(std::move(value));
+#endif
+
+    value.reset();
+}
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
@@ -27,40 +27,50 @@ namespace http {
 using namespace bc::system;
 
 websocket_frame::websocket_frame(const uint8_t* data, size_t size)
-  : valid_(false), flags_(0), header_(0), data_(0)
+  : valid_(false), complete_(false), flags_(0), header_(0), data_(0)
 {
     from_data(data, size);
 }
 
+constexpr size_t websocket_frame::maximum_header_length;
+
 /// static
-data_chunk websocket_frame::to_header(size_t length, websocket_op code)
+size_t websocket_frame::to_header(header_buffer& out, size_t length,
+    websocket_op code, bool compressed)
 {
+    // FIN, and RSV1 if the payload is compressed (RFC 7692).
+    out[0] = static_cast<uint8_t>((compressed ? 0xc0 : 0x80) |
+        static_cast<uint8_t>(code));
+
     if (length < 0x7e)
     {
-        return build_chunk(
-        {
-            to_array(uint8_t(0x80) | static_cast<uint8_t>(code)),
-            to_array(static_cast<uint8_t>(length))
-        });
+        out[1] = static_cast<uint8_t>(length);
+        return 2;
     }
-    else if (length < max_uint16)
-    {
-        return build_chunk(
-        {
-            to_array(uint8_t(0x80) | static_cast<uint8_t>(code)),
-            to_array(uint8_t(0x7e)),
-            to_big_endian(static_cast<uint16_t>(length))
-        });
-    }
-    else
+
+    // The extended length is big endian.
+    const auto extended = length <= max_uint16 ? sizeof(uint16_t) :
+        sizeof(uint64_t);
+
+    out[1] = extended == sizeof(uint16_t) ? 0x7e : 0x7f;
+    auto value = static_cast<uint64_t>(length);
+
+    for (auto index = extended + 1; index > 1; --index)
     {
-        return build_chunk(
-        {
-            to_array(uint8_t(0x80) | static_cast<uint8_t>(code)),
-            to_array(uint8_t(0x7f)),
-            to_big_endian(static_cast<uint64_t>(length))
-        });
+        out[index] = static_cast<uint8_t>(value);
+        value >>= 8;
     }
+
+    return 2 + extended;
+}
+
+/// static
+data_chunk websocket_frame::to_header(size_t length, websocket_op code,
+    bool compressed)
+{
+    header_buffer header;
+    const auto size = to_header(header, length, code, compressed);
+    return { header.begin(), header.begin() + size };
 }
 
 websocket_frame::operator bool() const
@@ -68,6 +78,11 @@ websocket_frame::operator bool() const
     return valid_;
 }
 
+bool websocket_frame::complete() const
+{
+    return complete_;
+}
+
 bool websocket_frame::final() const
 {
     return (flags_ & 0x80) != 0;
@@ -109,41 +124,63 @@ size_t websocket_frame::mask_length() const
     return valid_ ? mask_ : 0;
 }
 
+// The header may be incomplete (a partial read), in which case the required
+// length is known once the second byte is available.
 void websocket_frame::from_data(const uint8_t* data, size_t read_length)
 {
     static constexpr size_t prefix = 2;
     static constexpr size_t prefix16 = prefix + sizeof(uint16_t);
     static constexpr size_t prefix64 = prefix + sizeof(uint64_t);
 
-    // Invalid websocket frame (too small).
-    // Invalid websocket frame (unmasked).
-    if (read_length < 2 || (data[1] & 0x80) == 0)
+    if (read_length < prefix)
         return;
 
     flags_ = data[0];
+    const auto masked = (data[1] & 0x80) != 0;
     const size_t length = (data[1] & 0x7f);
 
-    if (read_length >= mask_ && length < 0x7e)
+    // Client frames must be masked, which is known from the first bytes.
+    if (!masked)
     {
+        complete_ = true;
+        return;
+    }
+
+    if (length < 0x7e)
         header_ = prefix + mask_;
+    else if (length == 0x7e)
+        header_ = prefix16 + mask_;
+    else
+        header_ = prefix64 + mask_;
+
+    if (read_length < header_)
+        return;
+
+    complete_ = true;
+
+    if (length < 0x7e)
+    {
         data_ = length;
     }
-    else if (read_length >= prefix16 + mask_ && length == 0x7e)
+    else if (length == 0x7e)
     {
-        header_ = prefix16 + mask_;
         data_ = from_big_endian<uint16_t>(&data[prefix], &data[prefix16]);
     }
-    else if (read_length >= prefix64 + mask_)
+    else
     {
-        header_ = prefix64 + mask_;
-        data_ = from_big_endian<uint64_t>(&data[prefix], &data[prefix64]);
+        // The most significant bit of a 64 bit length must be zero.
+        const auto value = from_big_endian<uint64_t>(&data[prefix],
+            &data[prefix64]);
+
+        if ((value >> 63) != 0 || value > max_size_t - header_)
+            return;
+
+        data_ = static_cast<size_t>(value);
     }
 
     valid_ = true;
-    return;
 }
 
-
 } // namespace http
 } // namespace protocol
 } // namespace libbitcoin
@@ -0,0 +1,114 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/protocol/web/websocket_keepalive.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <bitcoin/system.hpp>
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+using namespace bc::system;
+
+constexpr size_t websocket_keepalive::payload_size;
+
+// The smoothed value moves by 1/8 of the difference to each sample.
+static constexpr int64_t smoothing_shift = 3;
+
+websocket_keepalive::websocket_keepalive()
+  : sequence_(0),
+    outstanding_(false),
+    missed_(0),
+    sent_(clock::now()),
+    smoothed_(0),
+    sample_(0)
+{
+}
+
+void websocket_keepalive::start(clock::time_point now)
+{
+    outstanding_ = false;
+    missed_ = 0;
+    sent_ = now;
+    smoothed_ = microseconds(0);
+    sample_ = microseconds(0);
+}
+
+bool websocket_keepalive::due(clock::time_point now,
+    const clock::duration& interval) const
+{
+    return now - sent_ >= interval;
+}
+
+data_chunk websocket_keepalive::ping(clock::time_point now)
+{
+    if (outstanding_)
+        ++missed_;
+
+    outstanding_ = true;
+    sent_ = now;
+    return to_chunk(to_big_endian(++sequence_));
+}
+
+bool websocket_keepalive::pong(const uint8_t* data, size_t size,
+    clock::time_point now)
+{
+    if (!outstanding_ || size != payload_size ||
+        from_big_endian<uint64_t>(data, data + size) != sequence_)
+        return false;
+
+    outstanding_ = false;
+    missed_ = 0;
+    sample_ = std::chrono::duration_cast<microseconds>(now - sent_);
+
+    if (smoothed_.count() == 0)
+        smoothed_ = sample_;
+    else
+        smoothed_ += microseconds((sample_ - smoothed_).count() >>
+            smoothing_shift);
+
+    return true;
+}
+
+size_t websocket_keepalive::missed() const
+{
+    return missed_;
+}
+
+bool websocket_keepalive::outstanding() const
+{
+    return outstanding_;
+}
+
+websocket_keepalive::microseconds websocket_keepalive::round_trip() const
+{
+    return smoothed_;
+}
+
+websocket_keepalive::microseconds websocket_keepalive::last_round_trip() const
+{
+    return sample_;
+}
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
@@ -0,0 +1,240 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <bitcoin/protocol/web/websocket_mask.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "cpu_features.hpp"
+
+namespace libbitcoin {
+namespace protocol {
+namespace http {
+
+constexpr size_t websocket_mask::mask_size;
+
+typedef void (*mask_function)(uint8_t* data, size_t size, const uint8_t* mask,
+    size_t offset);
+
+// The mask rotated to begin at the offset, as a word in memory order.
+static uint32_t mask_word(const uint8_t* mask, size_t offset)
+{
+    uint8_t rotated[websocket_mask::mask_size];
+    for (size_t index = 0; index < websocket_mask::mask_size; ++index)
+        rotated[index] = mask[(offset + index) % websocket_mask::mask_size];
+
+    uint32_t word;
+    std::memcpy(&word, rotated, sizeof(word));
+    return word;
+}
+
+// The number of leading bytes before the data is aligned to the width.
+static size_t misaligned(const uint8_t* data, size_t size, size_t width)
+{
+    const auto remainder = reinterpret_cast<uintptr_t>(data) % width;
+    return remainder == 0 ? 0 : std::min(size, width - remainder);
+}
+
+static void apply_bytes(uint8_t* data, size_t size, const uint8_t* mask,
+    size_t offset)
+{
+    for (size_t index = 0; index < size; ++index)
+        data[index] ^= mask[(offset + index) % websocket_mask::mask_size];
+}
+
+// Both halves of the wide word are the rotated mask, so it is independent of
+// byte order.
+static void apply_scalar(uint8_t* data, size_t size, const uint8_t* mask,
+    size_t offset)
+{
+    const auto head = misaligned(data, size, sizeof(uint64_t));
+    apply_bytes(data, head, mask, offset);
+    data += head;
+    size -= head;
+    offset += head;
+
+    const uint64_t word = mask_word(mask, offset);
+    const auto wide = word | (word << 32);
+
+    for (; size >= sizeof(uint64_t); data += sizeof(uint64_t),
+        size -= sizeof(uint64_t))
+    {
+        uint64_t value;
+        std::memcpy(&value, data, sizeof(value));
+        value ^= wide;
+        std::memcpy(data, &value, sizeof(value));
+    }
+
+    // Whole words do not change the position within the mask.
+    apply_bytes(data, size, mask, offset);
+}
+
+// Vector kernels align to their width with the scalar kernel, which also
+// serves payloads too short to benefit (as measured for SSE2 and AVX2).
+static constexpr size_t vector_minimum = 512;
+
+#ifdef CPU_FEATURES_X64
+static void apply_sse2(uint8_t* data, size_t size, const uint8_t* mask,
+    size_t offset)
+{
+    static constexpr size_t width = sizeof(__m128i);
+
+    if (size < vector_minimum)
+    {
+        apply_scalar(data, size, mask, offset);
+        return;
+    }
+
+    const auto head = misaligned(data, size, width);
+    apply_scalar(data, head, mask, offset);
+    data += head;
+    size -= head;
+    offset += head;
+
+    const auto vector = _mm_set1_epi32(
+        static_cast<int32_t>(mask_word(mask, offset)));
+
+    for (; size >= width; data += width, size -= width)
+    {
+        const auto block = reinterpret_cast<__m128i*>(data);
+        _mm_store_si128(block, _mm_xor_si128(_mm_load_si128(block), vector));
+    }
+
+    apply_scalar(data, size, mask, offset);
+}
+
+CPU_FEATURES_AVX2
+static void apply_avx2(uint8_t* data, size_t size, const uint8_t* mask,
+    size_t offset)
+{
+    static constexpr size_t width = sizeof(__m256i);
+
+    if (size < vector_minimum)
+    {
+        apply_scalar(data, size, mask, offset);
+        return;
+    }
+
+    const auto head = misaligned(data, size, width);
+    apply_scalar(data, head, mask, offset);
+    data += head;
+    size -= head;
+    offset += head;
+
+    const auto vector = _mm256_set1_epi32(
+        static_cast<int32_t>(mask_word(mask, offset)));
+
+    for (; size >= width; data += width, size -= width)
+    {
+        const auto block = reinterpret_cast<__m256i*>(data);
+        _mm256_store_si256(block,
+            _mm256_xor_si256(_mm256_load_si256(block), vector));
+    }
+
+    apply_scalar(data, size, mask, offset);
+}
+
+#endif
+
+#ifdef CPU_FEATURES_ARM64
+static void apply_neon(uint8_t* data, size_t size, const uint8_t* mask,
+    size_t offset)
+{
+    static constexpr size_t width = sizeof(uint8x16_t);
+
+    if (size < vector_minimum)
+    {
+        apply_scalar(data, size, mask, offset);
+        return;
+    }
+
+    const auto head = misaligned(data, size, width);
+    apply_scalar(data, head, mask, offset);
+    data += head;
+    size -= head;
+    offset += head;
+
+    const auto vector = vreinterpretq_u8_u32(vdupq_n_u32(
+        mask_word(mask, offset)));
+
+    for (; size >= width; data += width, size -= width)
+        vst1q_u8(data, veorq_u8(vld1q_u8(data), vector));
+
+    apply_scalar(data, size, mask, offset);
+}
+#endif
+
+// An unsupported kernel falls back to scalar.
+static mask_function select(websocket_mask::kernel type)
+{
+    if (!websocket_mask::supported(type))
+        return apply_scalar;
+
+    switch (type)
+    {
+#ifdef CPU_FEATURES_X64
+        case websocket_mask::kernel::sse2:
+            return apply_sse2;
+        case websocket_mask::kernel::avx2:
+            return apply_avx2;
+#endif
+#ifdef CPU_FEATURES_ARM64
+        case websocket_mask::kernel::neon:
+            return apply_neon;
+#endif
+        case websocket_mask::kernel::scalar:
+        default:
+            return apply_scalar;
+    }
+}
+
+websocket_mask::kernel websocket_mask::best()
+{
+    return cpu_features::best();
+}
+
+bool websocket_mask::supported(kernel type)
+{
+    return cpu_features::supported(type);
+}
+
+std::string websocket_mask::to_string(kernel type)
+{
+    return cpu_features::to_string(type);
+}
+
+void websocket_mask::apply(uint8_t* data, size_t size, const uint8_t* mask,
+    size_t offset)
+{
+    static const auto function = select(best());
+    function(data, size, mask, offset);
+}
+
+void websocket_mask::apply(kernel type, uint8_t* data, size_t size,
+    const uint8_t* mask, size_t offset)
+{
+    select(type)(data, size, mask, offset);
+}
+
+} // namespace http
+} // namespace protocol
+} // namespace libbitcoin
@@ -40,9 +40,10 @@ const config::endpoint authenticator::endpoint(
     "inproc://zeromq.zap.01");
 
 // There may be only one authenticator per process.
-authenticator::authenticator(thread_priority priority)
+authenticator::authenticator(thread_priority priority,
+    const cpu_list& io_affinity)
   : worker(priority),
-    context_(false),
+    context_(false, io_affinity),
     require_allow_(false)
 {
 }
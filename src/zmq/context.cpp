@@ -30,8 +30,8 @@ using namespace bc::system;
 
 static constexpr int32_t zmq_fail = -1;
 
-context::context(bool started)
-  : self_(nullptr)
+context::context(bool started, const cpu_list& affinity)
+  : self_(nullptr), affinity_(affinity)
 {
     if (started)
         start();
@@ -53,7 +53,21 @@ bool context::start()
         return false;
 
     self_.store(zmq_ctx_new());
-    return self_ != nullptr;
+    if (self_ == nullptr)
+        return false;
+
+    // I/O threads are created with the first socket, so this must precede it.
+    for (const auto cpu: affinity_)
+    {
+        if (zmq_ctx_set(self_, ZMQ_THREAD_AFFINITY_CPU_ADD,
+            static_cast<int32_t>(cpu)) == zmq_fail)
+        {
+            LOG_WARNING(LOG_PROTOCOL)
+                << "Failed to add context processor affinity: " << cpu;
+        }
+    }
+
+    return true;
     ///////////////////////////////////////////////////////////////////////////
 }
 
@@ -34,8 +34,9 @@ using namespace bc::system;
 #define NAME "worker"
 
 // Derive from this abstract worker to implement concrete worker.
-worker::worker(thread_priority priority)
+worker::worker(thread_priority priority, const cpu_list& affinity)
   : priority_(priority),
+    affinity_(affinity),
     stopped_(true)
 {
 }
@@ -114,7 +115,15 @@ bool worker::started(bool result)
     started_.set_value(result);
 
     if (result)
+    {
         set_priority(priority_);
+
+        if (!set_affinity(affinity_))
+        {
+            LOG_WARNING(LOG_PROTOCOL)
+                << "Failed to set " NAME " processor affinity.";
+        }
+    }
     else
         finished(true);
 
@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <bitcoin/protocol.hpp>
+#include "utility.hpp"
+
+#include <cstdint>
+#include <limits>
+
+#ifdef __linux__
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+using namespace bc::protocol;
+
+BOOST_AUTO_TEST_SUITE(affinity_tests)
+
+BOOST_AUTO_TEST_CASE(affinity__set_affinity__empty__true)
+{
+    BOOST_REQUIRE(set_affinity({}));
+}
+
+BOOST_AUTO_TEST_CASE(affinity__set_affinity__invalid_cpu__false)
+{
+    auto result = true;
+    simple_thread thread([&]()
+    {
+        result = set_affinity({ 0, std::numeric_limits<uint32_t>::max() });
+    });
+
+    thread.join();
+    BOOST_REQUIRE(!result);
+}
+
+#ifdef __linux__
+
+// Pinned on another thread, so the test thread remains unrestricted.
+BOOST_AUTO_TEST_CASE(affinity__set_affinity__allowed_cpu__current_thread_pinned)
+{
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    BOOST_REQUIRE_EQUAL(::sched_getaffinity(0, sizeof(allowed), &allowed), 0);
+
+    uint32_t cpu = 0;
+    while (cpu < CPU_SETSIZE && !CPU_ISSET(cpu, &allowed))
+        ++cpu;
+
+    BOOST_REQUIRE(cpu < CPU_SETSIZE);
+
+    auto result = false;
+    auto pinned = 0;
+    simple_thread thread([&]()
+    {
+        result = set_affinity({ cpu });
+
+        cpu_set_t current;
+        CPU_ZERO(&current);
+        if (::pthread_getaffinity_np(::pthread_self(), sizeof(current),
+            &current) == 0 && CPU_ISSET(cpu, &current))
+            pinned = CPU_COUNT(&current);
+    });
+
+    thread.join();
+    BOOST_REQUIRE(result);
+    BOOST_REQUIRE_EQUAL(pinned, 1);
+}
+
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
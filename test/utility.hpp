@@ -23,6 +23,7 @@
 #include <future>
 #include <thread>
 #include <utility>
+#include <bitcoin/protocol.hpp>
 
 #define TEST_DOMAIN "testing"
 #define TEST_MESSAGE "hello world!"
@@ -76,4 +77,15 @@ public:
     }
 };
 
+// The default connection has no socket, so writes are only buffered and it
+// must not be closed on destruct.
+struct closing_connection
+  : bc::protocol::http::connection
+{
+    ~closing_connection()
+    {
+        set_state(bc::protocol::http::connection_state::closed);
+    }
+};
+
 #endif
@@ -0,0 +1,342 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <fstream>
+#include <string>
+#include <boost/filesystem.hpp>
+#include <bitcoin/protocol.hpp>
+
+using namespace bc::system;
+using namespace bc::protocol::http;
+using boost::filesystem::path;
+
+BOOST_AUTO_TEST_SUITE(asset_cache_tests)
+
+// Creates a unique scratch directory, removed with its contents.
+struct directory_setup
+{
+    directory_setup()
+      : directory(boost::filesystem::temp_directory_path() /
+            boost::filesystem::unique_path())
+    {
+        boost::filesystem::create_directories(directory);
+    }
+
+    ~directory_setup()
+    {
+        boost::system::error_code ec;
+        boost::filesystem::remove_all(directory, ec);
+    }
+
+    path write(const std::string& name, const std::string& content)
+    {
+        const auto file = directory / name;
+        std::ofstream stream(file.string(), std::ios::binary);
+        stream << content;
+        return file;
+    }
+
+    const path directory;
+};
+
+static std::string to_string(const data_chunk& data)
+{
+    return { data.begin(), data.end() };
+}
+
+static bool contains(const std::string& text, const std::string& value)
+{
+    return text.find(value) != std::string::npos;
+}
+
+BOOST_AUTO_TEST_CASE(asset_cache__enabled__default__false)
+{
+    asset_cache instance;
+    BOOST_REQUIRE(!instance.enabled());
+}
+
+BOOST_AUTO_TEST_CASE(asset_cache__load__disabled__null)
+{
+    directory_setup setup;
+    const auto file = setup.write("index.html", "<html/>");
+    asset_cache instance;
+    BOOST_REQUIRE(!instance.load("/index.html", file));
+    BOOST_REQUIRE_EQUAL(instance.count(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(asset_cache__load__file__fields_and_body)
+{
+    directory_setup setup;
+    const auto file = setup.write("index.html", "<html/>");
+    asset_cache instance(1024);
+    const auto asset = instance.load("/index.html", file);
+    BOOST_REQUIRE(asset);
+    BOOST_REQUIRE_EQUAL(asset->variants.size(), 1u);
+
+    const auto& variant = asset->variants.front();
+    BOOST_REQUIRE(variant.coding == asset_cache::encoding::identity);
+    BOOST_REQUIRE_EQUAL(to_string(variant.body), "<html/>");
+    BOOST_REQUIRE(contains(variant.fields, "Content-Type: text/html\r\n"));
+    BOOST_REQUIRE(contains(variant.fields, "Content-Length: 7\r\n"));
+    BOOST_REQUIRE(contains(variant.fields, "ETag: " + variant.etag + "\r\n"));
+    BOOST_REQUIRE(contains(variant.fields, "Last-Modified: "));
+    BOOST_REQUIRE(!contains(variant.fields, "Vary:"));
+    BOOST_REQUIRE(!contains(variant.not_modified_fields, "Content-Length"));
+    BOOST_REQUIRE_EQUAL(variant.etag.front(), '"');
+    BOOST_REQUIRE_EQUAL(variant.etag.back(), '"');
+}
+
+BOOST_AUTO_TEST_CASE(asset_cache__find__loaded__same_asset)
+{
+    directory_setup setup;
+    const auto file = setup.write("app.js", "var x;");
+    asset_cache instance(1024);
+    const auto loaded = instance.load("/app.js", file);
+    BOOST_REQUIRE(loaded);
+    BOOST_REQUIRE_EQUAL(instance.find("/app.js"), loaded);
+    BOOST_REQUIRE(!instance.find("/other.js"));
+}
+
+BOOST_AUTO_TEST_CASE(asset_cache__load__missing_file__null)
+{
+    directory_setup setup;
+    asset_cache instance(1024);
+    BOOST_REQUIRE(!instance.load("/missing", setup.directory / "missing"));
+}
+
+BOOST_AUTO_TEST_CASE(asset_cache__load__directory__null)
+{
+    directory_setup setup;
+    asset_cache instance(1024);
+    BOOST_REQUIRE(!instance.load("/", setup.directory));
+}
+
+BOOST_AUTO_TEST_CASE(asset_cache__load__exceeds_file_limit__null)
+{
+    directory_setup setup;
+    const auto file = setup.write("big.txt", std::string(100, 'x'));
+    asset_cache instance(1024, 99);
+    BOOST_REQUIRE(!instance.load("/big.txt", file));
+}
+
+BOOST_AUTO_TEST_CASE(asset_cache__load__exceeds_total__evicts_least_recent)
+{
+    directory_setup setup;
+    const auto first = setup.write("a.txt", std::string(100, 'a'));
+    const auto second = setup.write("b.txt", std::string(100, 'b'));
+    const auto third = setup.write("c.txt", std::string(100, 'c'));
+
+    // Room for two assets (bodies and fields) but not three.
+    asset_cache instance(700);
+    BOOST_REQUIRE(instance.load("/a.txt", first));
+    BOOST_REQUIRE(instance.load("/b.txt", second));
+    BOOST_REQUIRE(instance.find("/a.txt"));
+    BOOST_REQUIRE(instance.load("/c.txt", third));
+
+    BOOST_REQUIRE_EQUAL(instance.count(), 2u);
+    BOOST_REQUIRE(instance.find("/a.txt"));
+    BOOST_REQUIRE(!instance.find("/b.txt"));
+    BOOST_REQUIRE(instance.find("/c.txt"));
+    BOOST_REQUIRE_LE(instance.size(), 700u);
+}
+
+BOOST_AUTO_TEST_CASE(asset_cache__load__compressed_siblings__preferred_variants)
+{
+    directory_setup setup;
+    const auto file = setup.write("app.js", std::string(64, 'x'));
+    setup.write("app.js.gz", "gzipped");
+    setup.write("app.js.br", "brotli");
+
+    asset_cache instance(4096);
+    const auto asset = instance.load("/app.js", file);
+    BOOST_REQUIRE(asset);
+    BOOST_REQUIRE_EQUAL(asset->variants.size(), 3u);
+
+    const auto& brotli = asset->select("gzip, deflate, br");
+    BOOST_REQUIRE(brotli.coding == asset_cache::encoding::brotli);
+    BOOST_REQUIRE_EQUAL(to_string(brotli.body), "brotli");
+    BOOST_REQUIRE(contains(brotli.fields, "Content-Encoding: br\r\n"));
+    BOOST_REQUIRE(contains(brotli.fields, "Vary: Accept-Encoding\r\n"));
+    BOOST_REQUIRE(contains(brotli.fields,
+        "Content-Type: application/x-javascript\r\n"));
+
+    const auto& gzip = asset->select("gzip");
+    BOOST_REQUIRE(gzip.coding == asset_cache::encoding::gzip);
+    BOOST_REQUIRE(contains(gzip.fields, "Content-Encoding: gzip\r\n"));
+
+    const auto& refused = asset->select("br;q=0, gzip;q=0.5");
+    BOOST_REQUIRE(refused.coding == asset_cache::encoding::gzip);
+
+    const auto& identity = asset->select("");
+    BOOST_REQUIRE(identity.coding == asset_cache::encoding::identity);
+    BOOST_REQUIRE(contains(identity.fields, "Vary: Accept-Encoding\r\n"));
+    BOOST_REQUIRE(!contains(identity.fields, "Content-Encoding"));
+
+    BOOST_REQUIRE_NE(brotli.etag, gzip.etag);
+    BOOST_REQUIRE_NE(gzip.etag, identity.etag);
+}
+
+BOOST_AUTO_TEST_CASE(asset_cache__load__compressor_without_sibling__gzip_generated)
+{
+    directory_setup setup;
+    const auto file = setup.write("app.js", std::string(4096, 'x'));
+    setup.write("image.png", std::string(4096, 'x'));
+
+    compressor gzip;
+    asset_cache instance(1024 * 1024);
+    instance.set_compressor(&gzip);
+
+    const auto script = instance.load("/app.js", file);
+    const auto image = instance.load("/image.png", setup.directory /
+        "image.png");
+    BOOST_REQUIRE(script);
+    BOOST_REQUIRE(image);
+    BOOST_REQUIRE_EQUAL(image->variants.size(), 1u);
+
+    if (compressor::available())
+    {
+        BOOST_REQUIRE_EQUAL(script->variants.size(), 2u);
+        BOOST_REQUIRE(script->select("gzip").coding ==
+            asset_cache::encoding::gzip);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(asset_cache__load__larger_sibling__ignored)
+{
+    directory_setup setup;
+    const auto file = setup.write("a.txt", "small");
+    setup.write("a.txt.gz", "much larger than the original");
+    asset_cache instance(4096);
+    const auto asset = instance.load("/a.txt", file);
+    BOOST_REQUIRE(asset);
+    BOOST_REQUIRE_EQUAL(asset->variants.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(asset_cache__load__changed_content__different_etag)
+{
+    directory_setup setup;
+    const auto file = setup.write("a.txt", "version one");
+    asset_cache instance(4096);
+    const auto before = instance.load("/a.txt", file)->variants.back().etag;
+    setup.write("a.txt", "version two");
+    const auto after = instance.load("/a.txt", file)->variants.back().etag;
+    BOOST_REQUIRE_NE(before, after);
+    BOOST_REQUIRE_EQUAL(instance.count(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(asset_cache__find__file_changed__invalidated)
+{
+    directory_setup setup;
+    const auto file = setup.write("a.txt", "version one");
+    asset_cache instance(4096);
+    BOOST_REQUIRE(instance.load("/a.txt", file));
+
+    // Notification (or a later modification time) invalidates the entry.
+    setup.write("a.txt", "version two");
+    boost::filesystem::last_write_time(file,
+        boost::filesystem::last_write_time(file) + 10);
+
+    BOOST_REQUIRE(!instance.find("/a.txt"));
+    BOOST_REQUIRE_EQUAL(instance.count(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(asset_cache__invalidate__loaded__removed)
+{
+    directory_setup setup;
+    const auto file = setup.write("a.txt", "a");
+    asset_cache instance(4096);
+    BOOST_REQUIRE(instance.load("/a.txt", file));
+    instance.invalidate("/a.txt");
+    BOOST_REQUIRE(!instance.find("/a.txt"));
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(asset_cache__read__file__not_cached)
+{
+    directory_setup setup;
+    const auto file = setup.write("a.txt", "a");
+    asset_cache instance(4096);
+    const auto value = instance.read(file, nullptr);
+    BOOST_REQUIRE(value);
+    BOOST_REQUIRE_EQUAL(to_string(value->variants.back().body), "a");
+    BOOST_REQUIRE_EQUAL(instance.count(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(asset_cache__insert__read_twice__cached)
+{
+    directory_setup setup;
+    const auto file = setup.write("a.txt", "a");
+    asset_cache instance(4096);
+
+    // A directory is watched by the first insert, so the second caches.
+    instance.insert("/a.txt", instance.read(file, nullptr), instance.version());
+    const auto version = instance.version();
+    const auto value = instance.read(file, nullptr);
+    BOOST_REQUIRE(instance.insert("/a.txt", value, version));
+    BOOST_REQUIRE(instance.find("/a.txt") == value);
+    BOOST_REQUIRE_EQUAL(instance.count(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(asset_cache__insert__null__false)
+{
+    asset_cache instance(4096);
+    BOOST_REQUIRE(!instance.insert("/a.txt", nullptr, instance.version()));
+    BOOST_REQUIRE_EQUAL(instance.count(), 0u);
+}
+
+#ifdef __linux__
+BOOST_AUTO_TEST_CASE(asset_cache__insert__changed_since_version__not_cached)
+{
+    directory_setup setup;
+    const auto file = setup.write("a.txt", "version one");
+    asset_cache instance(4096);
+    BOOST_REQUIRE(instance.load("/a.txt", file));
+    instance.invalidate("/a.txt");
+
+    const auto version = instance.version();
+    const auto value = instance.read(file, nullptr);
+    setup.write("a.txt", "version two");
+
+    BOOST_REQUIRE(!instance.insert("/a.txt", value, version));
+    BOOST_REQUIRE_EQUAL(instance.count(), 0u);
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(asset_cache__matches__various__expected)
+{
+    const std::string etag = "\"0123456789abcdef\"";
+    BOOST_REQUIRE(!asset_cache::matches("", etag));
+    BOOST_REQUIRE(asset_cache::matches(etag, etag));
+    BOOST_REQUIRE(asset_cache::matches("*", etag));
+    BOOST_REQUIRE(asset_cache::matches("W/" + etag, etag));
+    BOOST_REQUIRE(asset_cache::matches("\"other\", " + etag, etag));
+    BOOST_REQUIRE(!asset_cache::matches("\"other\"", etag));
+}
+
+BOOST_AUTO_TEST_CASE(asset_cache__to_http_date__epoch__rfc7231)
+{
+    BOOST_REQUIRE_EQUAL(asset_cache::to_http_date(0),
+        "Thu, 01 Jan 1970 00:00:00 GMT");
+    BOOST_REQUIRE_EQUAL(asset_cache::to_http_date(784111777),
+        "Sun, 06 Nov 1994 08:49:37 GMT");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <string>
+#include <bitcoin/protocol.hpp>
+
+using namespace bc::system;
+using namespace bc::protocol::http;
+
+BOOST_AUTO_TEST_SUITE(binary_query_tests)
+
+BOOST_AUTO_TEST_CASE(binary_query__encode__command_id_payload__expected)
+{
+    const auto out = binary_query::encode("a.b", 0x01020304, { 0xaa, 0xbb });
+    const data_chunk expected
+    {
+        0x03, 'a', '.', 'b', 0x04, 0x03, 0x02, 0x01, 0xaa, 0xbb
+    };
+
+    BOOST_REQUIRE(out == expected);
+}
+
+BOOST_AUTO_TEST_CASE(binary_query__encode__invalid_command__empty)
+{
+    BOOST_REQUIRE(binary_query::encode("", 1, {}).empty());
+    BOOST_REQUIRE(binary_query::encode(std::string(256, 'x'), 1, {}).empty());
+}
+
+BOOST_AUTO_TEST_CASE(binary_query__decode__encoded__round_trip)
+{
+    const data_chunk payload{ 0x00, 0x01, 0x02 };
+    const auto message = binary_query::encode("blockchain.fetch_history4",
+        42, payload);
+
+    binary_query query;
+    BOOST_REQUIRE(binary_query::decode(query, message.data(),
+        message.size()));
+    BOOST_REQUIRE_EQUAL(query.command, "blockchain.fetch_history4");
+    BOOST_REQUIRE_EQUAL(query.id, 42u);
+    BOOST_REQUIRE(query.payload == payload);
+}
+
+BOOST_AUTO_TEST_CASE(binary_query__decode__empty_payload__true)
+{
+    const data_chunk message{ 0x01, 'x', 0x07, 0x00, 0x00, 0x00 };
+    binary_query query;
+    BOOST_REQUIRE(binary_query::decode(query, message.data(),
+        message.size()));
+    BOOST_REQUIRE_EQUAL(query.id, 7u);
+    BOOST_REQUIRE(query.payload.empty());
+}
+
+BOOST_AUTO_TEST_CASE(binary_query__decode__truncated__false)
+{
+    const data_chunk message{ 0x01, 'x', 0x07, 0x00, 0x00, 0x00 };
+    binary_query query;
+    BOOST_REQUIRE(!binary_query::decode(query, message.data(), 0));
+
+    for (size_t size = 1; size < message.size(); ++size)
+        BOOST_REQUIRE(!binary_query::decode(query, message.data(), size));
+}
+
+BOOST_AUTO_TEST_CASE(binary_query__decode__empty_command__false)
+{
+    const data_chunk message{ 0x00, 0x07, 0x00, 0x00, 0x00 };
+    binary_query query;
+    BOOST_REQUIRE(!binary_query::decode(query, message.data(),
+        message.size()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,72 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <bitcoin/protocol.hpp>
+
+using namespace bc::system;
+using namespace bc::protocol::http;
+
+BOOST_AUTO_TEST_SUITE(buffer_pool_tests)
+
+BOOST_AUTO_TEST_CASE(buffer_pool__acquire__empty_pool__empty_buffer)
+{
+    buffer_pool instance;
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+    BOOST_REQUIRE(instance.acquire().empty());
+}
+
+BOOST_AUTO_TEST_CASE(buffer_pool__release__acquire__capacity_retained)
+{
+    buffer_pool instance;
+    auto buffer = instance.acquire();
+    buffer.resize(1000, 0x42);
+    const auto capacity = buffer.capacity();
+
+    instance.release(buffer);
+    BOOST_REQUIRE(buffer.empty());
+    BOOST_REQUIRE_EQUAL(buffer.capacity(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+
+    const auto reused = instance.acquire();
+    BOOST_REQUIRE(reused.empty());
+    BOOST_REQUIRE_EQUAL(reused.capacity(), capacity);
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(buffer_pool__release__full__discarded)
+{
+    buffer_pool instance(1);
+    data_chunk first(10);
+    data_chunk second(10);
+    instance.release(first);
+    instance.release(second);
+    BOOST_REQUIRE_EQUAL(instance.size(), 1u);
+    BOOST_REQUIRE_EQUAL(second.capacity(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(buffer_pool__release__no_capacity__not_kept)
+{
+    buffer_pool instance;
+    data_chunk buffer;
+    instance.release(buffer);
+    BOOST_REQUIRE_EQUAL(instance.size(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
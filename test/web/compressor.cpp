@@ -0,0 +1,177 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <string>
+#include <bitcoin/protocol.hpp>
+
+using namespace bc::system;
+using namespace bc::protocol::http;
+
+BOOST_AUTO_TEST_SUITE(compressor_tests)
+
+#ifdef WITH_ZLIB
+static std::string inflate_body(const std::string& body, bool gzip)
+{
+    z_stream stream{};
+    if (inflateInit2(&stream, gzip ? 15 + 16 : 15) != Z_OK)
+        return {};
+
+    std::string out(1024 * 1024, '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(body.data()));
+    stream.avail_in = static_cast<uInt>(body.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&out[0]);
+    stream.avail_out = static_cast<uInt>(out.size());
+
+    const auto result = inflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    inflateEnd(&stream);
+    return result == Z_STREAM_END ? out : std::string{};
+}
+#endif
+
+static std::string json_body()
+{
+    std::string body = "[";
+    for (size_t index = 0; index < 200; ++index)
+        body += "{\"hash\":\"000000000019d6689c085ae165831e93\",\"height\":" +
+            std::to_string(index) + "},";
+
+    body.back() = ']';
+    return body;
+}
+
+BOOST_AUTO_TEST_CASE(compressor__to_string__codings__expected)
+{
+    BOOST_REQUIRE_EQUAL(compressor::to_string(content_coding::identity), "identity");
+    BOOST_REQUIRE_EQUAL(compressor::to_string(content_coding::gzip), "gzip");
+    BOOST_REQUIRE_EQUAL(compressor::to_string(content_coding::deflate), "deflate");
+}
+
+BOOST_AUTO_TEST_CASE(compressor__configure__out_of_range_level__clamped)
+{
+    compressor instance;
+    BOOST_REQUIRE_EQUAL(instance.level(), compressor::default_level);
+    BOOST_REQUIRE_EQUAL(instance.threshold(), compressor::default_threshold);
+
+    instance.configure(42, 10);
+    BOOST_REQUIRE_EQUAL(instance.level(), 9);
+    BOOST_REQUIRE_EQUAL(instance.threshold(), 10u);
+
+    instance.configure(-1, 10);
+    BOOST_REQUIRE_EQUAL(instance.level(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(compressor__negotiate__disabled__identity)
+{
+    const compressor instance(0);
+    BOOST_REQUIRE(instance.negotiate("gzip, deflate") == content_coding::identity);
+}
+
+BOOST_AUTO_TEST_CASE(compressor__negotiate__accept_encoding__expected)
+{
+    const compressor instance;
+    const auto gzip = compressor::available() ? content_coding::gzip :
+        content_coding::identity;
+    const auto deflate = compressor::available() ? content_coding::deflate :
+        content_coding::identity;
+
+    BOOST_REQUIRE(instance.negotiate("") == content_coding::identity);
+    BOOST_REQUIRE(instance.negotiate("br") == content_coding::identity);
+    BOOST_REQUIRE(instance.negotiate("gzip, deflate, br") == gzip);
+    BOOST_REQUIRE(instance.negotiate("deflate") == deflate);
+    BOOST_REQUIRE(instance.negotiate("gzip;q=0, deflate") == deflate);
+    BOOST_REQUIRE(instance.negotiate("*") == gzip);
+}
+
+BOOST_AUTO_TEST_CASE(compressor__compress__below_threshold__false)
+{
+    compressor instance(6, 1024);
+    std::string out;
+    BOOST_REQUIRE(!instance.compress(out, std::string(1023, 'a'),
+        content_coding::gzip));
+}
+
+BOOST_AUTO_TEST_CASE(compressor__compress__identity__false)
+{
+    compressor instance(6, 0);
+    std::string out;
+    BOOST_REQUIRE(!instance.compress(out, json_body(),
+        content_coding::identity));
+}
+
+#ifdef WITH_ZLIB
+
+BOOST_AUTO_TEST_CASE(compressor__compress__gzip__round_trip)
+{
+    compressor instance;
+    const auto body = json_body();
+    std::string out;
+    BOOST_REQUIRE(instance.compress(out, body, content_coding::gzip));
+    BOOST_REQUIRE_LT(out.size(), body.size());
+
+    // gzip magic (RFC 1952).
+    BOOST_REQUIRE_EQUAL(static_cast<uint8_t>(out[0]), 0x1f);
+    BOOST_REQUIRE_EQUAL(static_cast<uint8_t>(out[1]), 0x8b);
+    BOOST_REQUIRE_EQUAL(inflate_body(out, true), body);
+}
+
+BOOST_AUTO_TEST_CASE(compressor__compress__deflate__round_trip)
+{
+    compressor instance;
+    const auto body = json_body();
+    std::string out;
+    BOOST_REQUIRE(instance.compress(out, body, content_coding::deflate));
+    BOOST_REQUIRE_EQUAL(inflate_body(out, false), body);
+}
+
+BOOST_AUTO_TEST_CASE(compressor__compress__reused__same_output)
+{
+    compressor instance;
+    const auto body = json_body();
+    std::string first;
+    std::string second;
+    std::string other;
+    BOOST_REQUIRE(instance.compress(first, body, content_coding::gzip));
+    BOOST_REQUIRE(instance.compress(other, body + " ", content_coding::gzip));
+    BOOST_REQUIRE(instance.compress(second, body, content_coding::gzip));
+    BOOST_REQUIRE_EQUAL(first, second);
+}
+
+BOOST_AUTO_TEST_CASE(compressor__compress__level_changed__round_trip)
+{
+    compressor instance(1);
+    const auto body = json_body();
+    std::string out;
+    BOOST_REQUIRE(instance.compress(out, body, content_coding::gzip));
+    instance.configure(9, 0);
+    BOOST_REQUIRE(instance.compress(out, body, content_coding::gzip));
+    BOOST_REQUIRE_EQUAL(inflate_body(out, true), body);
+}
+
+BOOST_AUTO_TEST_CASE(compressor__compress__incompressible__false)
+{
+    compressor instance(6, 0);
+    std::string out;
+    BOOST_REQUIRE(!instance.compress(out, "x", content_coding::gzip));
+}
+
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,526 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <bitcoin/protocol.hpp>
+#include "../utility.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace bc::system;
+using namespace bc::protocol::http;
+
+BOOST_AUTO_TEST_SUITE(connection_tests)
+
+// The default connection has no socket, writes are only buffered.
+static std::string written(connection& instance)
+{
+    const auto& buffer = instance.write_buffer();
+    return { buffer.begin(), buffer.end() };
+}
+
+BOOST_AUTO_TEST_CASE(connection__reserve_slot__sequential__pending)
+{
+    closing_connection instance;
+    BOOST_REQUIRE_EQUAL(instance.pending_responses(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.reserve_slot(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.reserve_slot(), 1u);
+    BOOST_REQUIRE_EQUAL(instance.pending_responses(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(connection__write_response__in_order__written)
+{
+    closing_connection instance;
+    const auto first = instance.reserve_slot();
+    const auto second = instance.reserve_slot();
+    BOOST_REQUIRE(instance.write_response(first, "a"));
+    BOOST_REQUIRE_EQUAL(written(instance), "a");
+    BOOST_REQUIRE(instance.write_response(second, "b"));
+    BOOST_REQUIRE_EQUAL(written(instance), "ab");
+    BOOST_REQUIRE_EQUAL(instance.pending_responses(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(connection__write_response__out_of_order__request_order)
+{
+    closing_connection instance;
+    const auto first = instance.reserve_slot();
+    const auto second = instance.reserve_slot();
+    const auto third = instance.reserve_slot();
+
+    BOOST_REQUIRE(instance.write_response(third, "c"));
+    BOOST_REQUIRE(instance.write_response(second, "b"));
+    BOOST_REQUIRE(written(instance).empty());
+    BOOST_REQUIRE_EQUAL(instance.pending_responses(), 3u);
+
+    BOOST_REQUIRE(instance.write_response(first, "a"));
+    BOOST_REQUIRE_EQUAL(written(instance), "abc");
+    BOOST_REQUIRE_EQUAL(instance.pending_responses(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(connection__write_response__answered_slot__written_without_advance)
+{
+    closing_connection instance;
+    const auto first = instance.reserve_slot();
+    const auto second = instance.reserve_slot();
+    BOOST_REQUIRE(instance.write_response(first, "a"));
+    BOOST_REQUIRE(instance.write_response(first, "x"));
+    BOOST_REQUIRE_EQUAL(instance.pending_responses(), 1u);
+    BOOST_REQUIRE(instance.write_response(second, "b"));
+    BOOST_REQUIRE_EQUAL(written(instance), "axb");
+}
+
+// Beyond the connection high water mark (2MB).
+static const std::string oversized(3 * 1024 * 1024, 'x');
+
+BOOST_AUTO_TEST_CASE(connection__write__high_water__failed)
+{
+    closing_connection instance;
+    BOOST_REQUIRE_EQUAL(instance.write(oversized), -1);
+    BOOST_REQUIRE(written(instance).empty());
+}
+
+BOOST_AUTO_TEST_CASE(connection__write_response__pipelined_overflow__failed_without_advance)
+{
+    closing_connection instance;
+    const auto first = instance.reserve_slot();
+    const auto second = instance.reserve_slot();
+    BOOST_REQUIRE(instance.write_response(second, "b"));
+
+    // The held reply must not be written as the answer to the first.
+    BOOST_REQUIRE(!instance.write_response(first, oversized));
+    BOOST_REQUIRE(written(instance).empty());
+    BOOST_REQUIRE_EQUAL(instance.pending_responses(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(connection__write_header__high_water__failed)
+{
+    closing_connection instance;
+    const std::string filler(2 * 1024 * 1024 - 10, 'x');
+    BOOST_REQUIRE_EQUAL(instance.write(filler), static_cast<int32_t>(
+        filler.size()));
+
+    BOOST_REQUIRE_EQUAL(instance.write_header(protocol_status::ok,
+        "text/html", 0, true), -1);
+    BOOST_REQUIRE_EQUAL(instance.write_header(protocol_status::ok,
+        std::string{}, true), -1);
+    BOOST_REQUIRE_EQUAL(instance.write_buffer().size(), filler.size());
+}
+
+static connection::producer pieces(const std::vector<std::string>& values)
+{
+    auto index = std::make_shared<size_t>(0);
+    return [=](std::string& piece)
+    {
+        piece += values[*index];
+        return ++(*index) < values.size();
+    };
+}
+
+BOOST_AUTO_TEST_CASE(connection__write_stream__current_slot__chunked)
+{
+    closing_connection instance;
+    const auto slot = instance.reserve_slot();
+    BOOST_REQUIRE(instance.write_stream(slot, "H", pieces({ "abc", "",
+        std::string(16, 'x') })));
+    BOOST_REQUIRE(instance.streaming());
+    BOOST_REQUIRE_EQUAL(written(instance), "H");
+
+    BOOST_REQUIRE(instance.continue_stream(1024));
+    BOOST_REQUIRE(!instance.streaming());
+    BOOST_REQUIRE_EQUAL(instance.pending_responses(), 0u);
+    BOOST_REQUIRE_EQUAL(written(instance), "H3\r\nabc\r\n10\r\n" +
+        std::string(16, 'x') + "\r\n0\r\n\r\n");
+}
+
+BOOST_AUTO_TEST_CASE(connection__continue_stream__high_water__paused)
+{
+    closing_connection instance;
+    const auto slot = instance.reserve_slot();
+    BOOST_REQUIRE(instance.write_stream(slot, "H", pieces({ "a", "b" })));
+    BOOST_REQUIRE(instance.continue_stream(1));
+    BOOST_REQUIRE(instance.streaming());
+    BOOST_REQUIRE_EQUAL(written(instance), "H");
+
+    instance.write_buffer().clear();
+    BOOST_REQUIRE(instance.continue_stream(1));
+    BOOST_REQUIRE(instance.streaming());
+    BOOST_REQUIRE_EQUAL(written(instance), "1\r\na\r\n");
+}
+
+BOOST_AUTO_TEST_CASE(connection__write_stream__between_responses__request_order)
+{
+    closing_connection instance;
+    const auto first = instance.reserve_slot();
+    const auto second = instance.reserve_slot();
+    const auto third = instance.reserve_slot();
+
+    BOOST_REQUIRE(instance.write_response(third, "c"));
+    BOOST_REQUIRE(instance.write_stream(second, "H", pieces({ "b" })));
+    BOOST_REQUIRE(!instance.streaming());
+
+    BOOST_REQUIRE(instance.write_response(first, "a"));
+    BOOST_REQUIRE(instance.streaming());
+    BOOST_REQUIRE_EQUAL(written(instance), "aH");
+
+    BOOST_REQUIRE(instance.continue_stream(1024));
+    BOOST_REQUIRE_EQUAL(written(instance), "aH1\r\nb\r\n0\r\n\r\nc");
+    BOOST_REQUIRE_EQUAL(instance.pending_responses(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(connection__write_response__large_body__chunked)
+{
+    closing_connection instance;
+    const auto first = instance.reserve_slot();
+    const auto second = instance.reserve_slot();
+    BOOST_REQUIRE(instance.write_response(second, "b"));
+
+    // Beyond high water as one write, so streamed rather than dropped.
+    BOOST_REQUIRE(instance.write_response(first, protocol_status::ok,
+        oversized));
+    BOOST_REQUIRE(instance.streaming());
+
+    std::string out;
+    do
+    {
+        out += written(instance);
+        instance.write_buffer().clear();
+        BOOST_REQUIRE(instance.continue_stream(1024 * 1024));
+    } while (instance.streaming());
+
+    out += written(instance);
+    const auto header = out.substr(0, out.find("\r\n\r\n") + 4);
+    BOOST_REQUIRE(header.find("Transfer-Encoding: chunked\r\n") !=
+        std::string::npos);
+    BOOST_REQUIRE(header.find("Content-Length") == std::string::npos);
+
+    // 64KiB chunks of the body, the terminal chunk and then the held reply.
+    const auto chunks = oversized.size() / (64 * 1024);
+    BOOST_REQUIRE_EQUAL(out.size(), header.size() +
+        chunks * (7 + 64 * 1024 + 2) + 5 + 1);
+    BOOST_REQUIRE_EQUAL(out.substr(header.size(), 7), "10000\r\n");
+    BOOST_REQUIRE_EQUAL(out.substr(out.size() - 6), "0\r\n\r\nb");
+    BOOST_REQUIRE_EQUAL(instance.pending_responses(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(connection__write_response__large_body_http_1_0__length)
+{
+    closing_connection instance;
+    instance.set_protocol_version(1.0);
+    BOOST_REQUIRE(!instance.chunked());
+    BOOST_REQUIRE(instance.write_response(instance.reserve_slot(),
+        protocol_status::ok, oversized));
+
+    std::string out;
+    do
+    {
+        out += written(instance);
+        instance.write_buffer().clear();
+        BOOST_REQUIRE(instance.continue_stream(1024 * 1024));
+    } while (instance.streaming());
+
+    out += written(instance);
+    const auto header = out.substr(0, out.find("\r\n\r\n") + 4);
+    BOOST_REQUIRE(header.find("Transfer-Encoding") == std::string::npos);
+    BOOST_REQUIRE(header.find("Content-Length: " +
+        std::to_string(oversized.size()) + "\r\n") != std::string::npos);
+    BOOST_REQUIRE(out.substr(header.size()) == oversized);
+    BOOST_REQUIRE_EQUAL(instance.pending_responses(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(connection__write_stream__http_1_0__one_body)
+{
+    closing_connection instance;
+    instance.set_protocol_version(1.0);
+    const auto slot = instance.reserve_slot();
+    BOOST_REQUIRE(instance.write_stream(slot, "H", pieces({ "a", "bc" })));
+    BOOST_REQUIRE(!instance.streaming());
+    BOOST_REQUIRE_EQUAL(instance.pending_responses(), 0u);
+
+    const auto response = written(instance);
+    BOOST_REQUIRE(response.find("Content-Length: 3\r\n") !=
+        std::string::npos);
+    BOOST_REQUIRE_EQUAL(response.substr(response.size() - 3), "abc");
+}
+
+BOOST_AUTO_TEST_CASE(connection__write_response__identity__uncompressed)
+{
+    closing_connection instance;
+    compressor gzip(6, 0);
+    instance.set_compressor(&gzip);
+    const auto body = std::string(2048, 'a');
+    BOOST_REQUIRE(instance.write_response(instance.reserve_slot(),
+        protocol_status::ok, body));
+
+    const auto response = written(instance);
+    BOOST_REQUIRE(response.find("Content-Encoding") == std::string::npos);
+    BOOST_REQUIRE(response.find("Content-Length: 2048\r\n") !=
+        std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(connection__write_response__negotiated_gzip__compressed)
+{
+    closing_connection instance;
+    compressor gzip(6, 0);
+    instance.set_compressor(&gzip);
+    const auto slot = instance.reserve_slot();
+    instance.set_content_coding(slot, gzip.negotiate("gzip"));
+    const auto body = std::string(2048, 'a');
+    BOOST_REQUIRE(instance.write_response(slot, protocol_status::ok, body));
+
+    const auto response = written(instance);
+    const auto compressed = response.find("Content-Encoding: gzip\r\n") !=
+        std::string::npos;
+    BOOST_REQUIRE_EQUAL(compressed, compressor::available());
+    BOOST_REQUIRE_EQUAL(response.size() < body.size(), compressed);
+}
+
+BOOST_AUTO_TEST_CASE(connection__write_response__pipelined_codings__per_slot)
+{
+    closing_connection instance;
+    compressor gzip(6, 0);
+    instance.set_compressor(&gzip);
+    const auto first = instance.reserve_slot();
+    instance.set_content_coding(first, gzip.negotiate("gzip"));
+    const auto second = instance.reserve_slot();
+    instance.set_content_coding(second, gzip.negotiate("identity"));
+    BOOST_REQUIRE(instance.coding(first) == gzip.negotiate("gzip"));
+    BOOST_REQUIRE(instance.coding(second) == content_coding::identity);
+
+    // The later request does not change the coding of the earlier one.
+    const auto body = std::string(2048, 'a');
+    BOOST_REQUIRE(instance.write_response(second, protocol_status::ok, body));
+    BOOST_REQUIRE(instance.write_response(first, protocol_status::ok, body));
+    BOOST_REQUIRE(instance.coding(first) == content_coding::identity);
+
+    const auto response = written(instance);
+    const auto split = response.find("HTTP/1.1", 1);
+    BOOST_REQUIRE(split != std::string::npos);
+    BOOST_REQUIRE_EQUAL(response.substr(0, split).find(
+        "Content-Encoding: gzip\r\n") != std::string::npos,
+        compressor::available());
+    BOOST_REQUIRE(response.substr(split).find("Content-Encoding") ==
+        std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(connection__keep_alive__default__true)
+{
+    closing_connection instance;
+    BOOST_REQUIRE(instance.keep_alive());
+    instance.set_keep_alive(false);
+    BOOST_REQUIRE(!instance.keep_alive());
+}
+
+BOOST_AUTO_TEST_CASE(connection__write_response__http2__framed_on_stream)
+{
+    closing_connection instance;
+    BOOST_REQUIRE(instance.http2() == nullptr);
+    const auto session = instance.start_http2(1024);
+    BOOST_REQUIRE(instance.http2() == session);
+
+    // Client preface and an empty GET on stream 1.
+    const auto& preface = http2_session::preface;
+    data_chunk input(preface.begin(), preface.end());
+    data_chunk block;
+    hpack::encode(block, { { ":method", "GET" }, { ":path", "/" } });
+    http2_session::write_frame(input, http2_session::frame_type::headers,
+        0x05, 1, block.data(), block.size());
+
+    http2_session::request_list requests;
+    BOOST_REQUIRE(session->receive(requests, input, instance.write_buffer()));
+    BOOST_REQUIRE_EQUAL(requests.size(), 1u);
+    instance.write_buffer().clear();
+
+    BOOST_REQUIRE(instance.write_response(1, protocol_status::ok, "body"));
+    const auto response = written(instance);
+    BOOST_REQUIRE_EQUAL(response.size(), 9u + 5u + 9u + 4u);
+    BOOST_REQUIRE_EQUAL(response.substr(response.size() - 4), "body");
+    BOOST_REQUIRE_EQUAL(instance.pending_responses(), 0u);
+    BOOST_REQUIRE(!instance.streaming());
+}
+
+BOOST_AUTO_TEST_CASE(connection__write_event__lines__chunked_fields)
+{
+    closing_connection instance;
+    BOOST_REQUIRE(!instance.event_stream());
+    instance.set_event_stream(true);
+    BOOST_REQUIRE(instance.event_stream());
+
+    BOOST_REQUIRE(instance.write_event(7, "a\nb"));
+    const std::string event = "id: 7\ndata: a\ndata: b\n\n";
+    BOOST_REQUIRE_EQUAL(written(instance), "17\r\n" + event + "\r\n");
+}
+
+BOOST_AUTO_TEST_CASE(connection__write_event__http_1_0__unframed)
+{
+    closing_connection instance;
+    instance.set_protocol_version(1.0);
+    instance.set_event_stream(true);
+    BOOST_REQUIRE(instance.write_event(7, "a"));
+    BOOST_REQUIRE_EQUAL(written(instance), "id: 7\ndata: a\n\n");
+}
+
+BOOST_AUTO_TEST_CASE(connection__write_event__stale_id__skipped)
+{
+    closing_connection instance;
+    instance.set_event_stream(true);
+    BOOST_REQUIRE(instance.write_event(2, "x"));
+    const auto size = instance.write_buffer().size();
+    BOOST_REQUIRE(instance.write_event(2, "y"));
+    BOOST_REQUIRE(instance.write_event(1, "z"));
+    BOOST_REQUIRE_EQUAL(instance.write_buffer().size(), size);
+}
+
+BOOST_AUTO_TEST_CASE(connection__write_frame__not_websocket__false)
+{
+    closing_connection instance;
+    const auto payload = std::make_shared<const data_chunk>(data_chunk{ 'a' });
+    BOOST_REQUIRE(!instance.write_frame(payload));
+    BOOST_REQUIRE_EQUAL(instance.buffered(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(connection__write_frame__shared__queued_without_copy)
+{
+    closing_connection first;
+    closing_connection second;
+    first.set_websocket(true);
+    second.set_websocket(true);
+
+    const shared_payload payload = std::make_shared<const data_chunk>(
+        data_chunk{ 'a', 'b', 'c' });
+
+    BOOST_REQUIRE(first.write_frame(payload));
+    BOOST_REQUIRE(second.write_frame(payload));
+    BOOST_REQUIRE_EQUAL(payload.use_count(), 3);
+    BOOST_REQUIRE_EQUAL(first.buffered(), 5u);
+    BOOST_REQUIRE_EQUAL(second.buffered(), 5u);
+    BOOST_REQUIRE(first.write_buffer().empty());
+}
+
+BOOST_AUTO_TEST_CASE(connection__write_frame__high_water__dropped_with_header)
+{
+    closing_connection instance;
+    instance.set_websocket(true);
+
+    // The payload alone fits, but not with its ten byte header.
+    const auto size = 2u * 1024u * 1024u - 9u;
+    BOOST_REQUIRE(instance.write_frame(std::make_shared<const data_chunk>(
+        size)));
+    BOOST_REQUIRE_EQUAL(instance.buffered(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.dropped(), 1u);
+
+    const data_chunk message(size);
+    BOOST_REQUIRE(instance.write_frame(message.data(), message.size()));
+    BOOST_REQUIRE_EQUAL(instance.buffered(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.dropped(), 2u);
+
+    BOOST_REQUIRE(instance.write_frame(message.data(), 3));
+    BOOST_REQUIRE_EQUAL(instance.buffered(), 5u);
+    BOOST_REQUIRE_EQUAL(instance.dropped(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(connection__write__queued_frames__queued_behind)
+{
+    closing_connection instance;
+    instance.set_websocket(true);
+    BOOST_REQUIRE_EQUAL(instance.write("one"), 3);
+    BOOST_REQUIRE(instance.write_frame(std::make_shared<const data_chunk>(
+        data_chunk{ 't', 'w', 'o' })));
+    BOOST_REQUIRE_EQUAL(instance.write("three"), 5);
+
+    // Only the message ahead of the queued frame is buffered.
+    BOOST_REQUIRE_EQUAL(written(instance), "\x81\x03" "one");
+    BOOST_REQUIRE_EQUAL(instance.buffered(), 5u + 5u + 7u);
+}
+
+#ifndef _MSC_VER
+
+// A connection over one end of a socket pair, the other end is read.
+struct paired_connection
+  : connection
+{
+    paired_connection(const std::vector<int>& pair)
+      : connection(pair[0], {}), peer(pair[1])
+    {
+        set_state(connection_state::connected);
+        set_socket_non_blocking();
+    }
+
+    ~paired_connection()
+    {
+        ::close(peer);
+    }
+
+    std::string received()
+    {
+        char buffer[256];
+        const auto size = ::recv(peer, buffer, sizeof(buffer), MSG_DONTWAIT);
+        return size <= 0 ? std::string{} : std::string(buffer, size);
+    }
+
+    int peer;
+};
+
+static std::vector<int> socket_pair()
+{
+    int pair[2];
+    BOOST_REQUIRE_EQUAL(::socketpair(AF_UNIX, SOCK_STREAM, 0, pair), 0);
+    return { pair[0], pair[1] };
+}
+
+BOOST_AUTO_TEST_CASE(connection__flush__buffer_and_frames__written_in_order)
+{
+    paired_connection instance(socket_pair());
+    instance.set_websocket(true);
+    instance.write("one");
+    instance.write_frame(std::make_shared<const data_chunk>(
+        data_chunk{ 't', 'w', 'o' }));
+    instance.write("three");
+
+    BOOST_REQUIRE_EQUAL(instance.flush(1024), 17);
+    BOOST_REQUIRE_EQUAL(instance.buffered(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.received(),
+        "\x81\x03" "one" "\x81\x03" "two" "\x81\x05" "three");
+}
+
+BOOST_AUTO_TEST_CASE(connection__flush__limit__resumed_within_frame)
+{
+    paired_connection instance(socket_pair());
+    instance.set_websocket(true);
+    instance.write_frame(std::make_shared<const data_chunk>(
+        data_chunk{ 'a', 'b', 'c' }));
+    instance.write_frame(std::make_shared<const data_chunk>(
+        data_chunk{ 'd', 'e' }));
+
+    BOOST_REQUIRE_EQUAL(instance.flush(1), 1);
+    BOOST_REQUIRE_EQUAL(instance.buffered(), 8u);
+    BOOST_REQUIRE_EQUAL(instance.flush(3), 3);
+    BOOST_REQUIRE_EQUAL(instance.flush(1024), 5);
+    BOOST_REQUIRE_EQUAL(instance.buffered(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.received(), "\x81\x03" "abc" "\x81\x02" "de");
+
+    // Once drained messages are buffered again.
+    instance.write("f");
+    BOOST_REQUIRE_EQUAL(written(instance), "\x81\x01" "f");
+}
+
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,112 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <vector>
+#include <bitcoin/protocol.hpp>
+
+using namespace bc::protocol::http;
+
+BOOST_AUTO_TEST_SUITE(file_pool_tests)
+
+BOOST_AUTO_TEST_CASE(file_pool__post__single_thread__run_in_order)
+{
+    file_pool instance(1);
+    std::mutex mutex;
+    std::vector<size_t> order;
+    std::promise<void> done;
+
+    for (size_t index = 0; index < 10; ++index)
+    {
+        BOOST_REQUIRE(instance.post([&, index]()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(index);
+            if (index == 9)
+                done.set_value();
+        }));
+    }
+
+    BOOST_REQUIRE(done.get_future().wait_for(std::chrono::seconds(10)) ==
+        std::future_status::ready);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    BOOST_REQUIRE_EQUAL(order.size(), 10u);
+    for (size_t index = 0; index < order.size(); ++index)
+        BOOST_REQUIRE_EQUAL(order[index], index);
+}
+
+BOOST_AUTO_TEST_CASE(file_pool__post__multiple_threads__all_run)
+{
+    std::atomic<size_t> count{ 0 };
+
+    {
+        file_pool instance(4);
+        std::promise<void> done;
+
+        for (size_t index = 0; index < 100; ++index)
+            BOOST_REQUIRE(instance.post([&]()
+            {
+                if (++count == 100)
+                    done.set_value();
+            }));
+
+        BOOST_REQUIRE(done.get_future().wait_for(std::chrono::seconds(10)) ==
+            std::future_status::ready);
+    }
+
+    BOOST_REQUIRE_EQUAL(count.load(), 100u);
+}
+
+BOOST_AUTO_TEST_CASE(file_pool__post__stopped__false)
+{
+    file_pool instance;
+    instance.stop();
+    BOOST_REQUIRE(!instance.post([]() {}));
+    BOOST_REQUIRE_EQUAL(instance.pending(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(file_pool__stop__blocked_job__queued_discarded)
+{
+    file_pool instance(1);
+    std::promise<void> started;
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    std::atomic<bool> ran{ false };
+
+    BOOST_REQUIRE(instance.post([&]()
+    {
+        started.set_value();
+        released.wait();
+    }));
+
+    BOOST_REQUIRE(instance.post([&]() { ran = true; }));
+    started.get_future().wait();
+    BOOST_REQUIRE_EQUAL(instance.pending(), 1u);
+
+    release.set_value();
+    instance.stop();
+    BOOST_REQUIRE_EQUAL(instance.pending(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,226 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <string>
+#include <bitcoin/protocol.hpp>
+
+using namespace bc::system;
+using namespace bc::protocol::http;
+
+BOOST_AUTO_TEST_SUITE(hpack_tests)
+
+static data_chunk from_hex(const std::string& hex)
+{
+    data_chunk out;
+    for (size_t index = 0; index + 1 < hex.size(); index += 2)
+        out.push_back(static_cast<uint8_t>(
+            std::stoul(hex.substr(index, 2), nullptr, 16)));
+
+    return out;
+}
+
+static bool decode(hpack& decoder, hpack::header_list& out,
+    const std::string& hex)
+{
+    const auto block = from_hex(hex);
+    out.clear();
+    return decoder.decode(out, block.data(), block.size());
+}
+
+// RFC 7541 C.1.1-C.1.3
+BOOST_AUTO_TEST_CASE(hpack__integer__rfc_examples__round_trip)
+{
+    data_chunk out;
+    hpack::encode_integer(out, 10, 5, 0x00);
+    BOOST_REQUIRE(out == from_hex("0a"));
+
+    out.clear();
+    hpack::encode_integer(out, 1337, 5, 0x00);
+    BOOST_REQUIRE(out == from_hex("1f9a0a"));
+
+    out.clear();
+    hpack::encode_integer(out, 42, 8, 0x00);
+    BOOST_REQUIRE(out == from_hex("2a"));
+
+    const auto data = from_hex("1f9a0a");
+    auto it = data.data();
+    size_t value;
+    BOOST_REQUIRE(hpack::decode_integer(value, it, data.data() + data.size(), 5));
+    BOOST_REQUIRE_EQUAL(value, 1337u);
+    BOOST_REQUIRE(it == data.data() + data.size());
+}
+
+BOOST_AUTO_TEST_CASE(hpack__decode_integer__truncated__false)
+{
+    const auto data = from_hex("1f9a");
+    auto it = data.data();
+    size_t value;
+    BOOST_REQUIRE(!hpack::decode_integer(value, it, data.data() + data.size(), 5));
+}
+
+BOOST_AUTO_TEST_CASE(hpack__decode_huffman__rfc_string__expected)
+{
+    const auto data = from_hex("f1e3c2e5f23a6ba0ab90f4ff");
+    std::string out;
+    BOOST_REQUIRE(hpack::decode_huffman(out, data.data(), data.size()));
+    BOOST_REQUIRE_EQUAL(out, "www.example.com");
+}
+
+BOOST_AUTO_TEST_CASE(hpack__decode_huffman__invalid_padding__false)
+{
+    // 'a' is 00011 followed by zero padding rather than ones.
+    const auto data = from_hex("18");
+    std::string out;
+    BOOST_REQUIRE(!hpack::decode_huffman(out, data.data(), data.size()));
+}
+
+BOOST_AUTO_TEST_CASE(hpack__decode_huffman__excess_padding__false)
+{
+    const auto data = from_hex("1fff");
+    std::string out;
+    BOOST_REQUIRE(!hpack::decode_huffman(out, data.data(), data.size()));
+}
+
+// RFC 7541 C.2.1
+BOOST_AUTO_TEST_CASE(hpack__decode__literal_with_indexing__inserted)
+{
+    hpack decoder;
+    hpack::header_list headers;
+    BOOST_REQUIRE(decode(decoder, headers,
+        "400a637573746f6d2d6b65790d637573746f6d2d686561646572"));
+    BOOST_REQUIRE_EQUAL(headers.size(), 1u);
+    BOOST_REQUIRE_EQUAL(headers[0].first, "custom-key");
+    BOOST_REQUIRE_EQUAL(headers[0].second, "custom-header");
+    BOOST_REQUIRE_EQUAL(decoder.table_size(), 55u);
+}
+
+// RFC 7541 C.2.2
+BOOST_AUTO_TEST_CASE(hpack__decode__literal_without_indexing__not_inserted)
+{
+    hpack decoder;
+    hpack::header_list headers;
+    BOOST_REQUIRE(decode(decoder, headers, "040c2f73616d706c652f70617468"));
+    BOOST_REQUIRE_EQUAL(headers.size(), 1u);
+    BOOST_REQUIRE_EQUAL(headers[0].first, ":path");
+    BOOST_REQUIRE_EQUAL(headers[0].second, "/sample/path");
+    BOOST_REQUIRE_EQUAL(decoder.table_size(), 0u);
+}
+
+// RFC 7541 C.4.1-C.4.3
+BOOST_AUTO_TEST_CASE(hpack__decode__rfc_huffman_requests__expected)
+{
+    hpack decoder;
+    hpack::header_list headers;
+
+    BOOST_REQUIRE(decode(decoder, headers,
+        "828684418cf1e3c2e5f23a6ba0ab90f4ff"));
+    BOOST_REQUIRE_EQUAL(headers.size(), 4u);
+    BOOST_REQUIRE_EQUAL(headers[0].first, ":method");
+    BOOST_REQUIRE_EQUAL(headers[0].second, "GET");
+    BOOST_REQUIRE_EQUAL(headers[1].second, "http");
+    BOOST_REQUIRE_EQUAL(headers[2].second, "/");
+    BOOST_REQUIRE_EQUAL(headers[3].first, ":authority");
+    BOOST_REQUIRE_EQUAL(headers[3].second, "www.example.com");
+    BOOST_REQUIRE_EQUAL(decoder.table_size(), 57u);
+
+    BOOST_REQUIRE(decode(decoder, headers, "828684be5886a8eb10649cbf"));
+    BOOST_REQUIRE_EQUAL(headers.size(), 5u);
+    BOOST_REQUIRE_EQUAL(headers[3].second, "www.example.com");
+    BOOST_REQUIRE_EQUAL(headers[4].first, "cache-control");
+    BOOST_REQUIRE_EQUAL(headers[4].second, "no-cache");
+    BOOST_REQUIRE_EQUAL(decoder.table_size(), 110u);
+
+    BOOST_REQUIRE(decode(decoder, headers,
+        "828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf"));
+    BOOST_REQUIRE_EQUAL(headers.size(), 5u);
+    BOOST_REQUIRE_EQUAL(headers[1].second, "https");
+    BOOST_REQUIRE_EQUAL(headers[2].second, "/index.html");
+    BOOST_REQUIRE_EQUAL(headers[3].second, "www.example.com");
+    BOOST_REQUIRE_EQUAL(headers[4].first, "custom-key");
+    BOOST_REQUIRE_EQUAL(headers[4].second, "custom-value");
+    BOOST_REQUIRE_EQUAL(decoder.table_size(), 164u);
+}
+
+BOOST_AUTO_TEST_CASE(hpack__decode__table_size_update__evicts)
+{
+    hpack decoder;
+    hpack::header_list headers;
+    BOOST_REQUIRE(decode(decoder, headers,
+        "400a637573746f6d2d6b65790d637573746f6d2d686561646572"));
+    BOOST_REQUIRE_EQUAL(decoder.table_size(), 55u);
+
+    // Size update to zero empties the table, index 62 is then invalid.
+    BOOST_REQUIRE(decode(decoder, headers, "20"));
+    BOOST_REQUIRE_EQUAL(decoder.table_size(), 0u);
+    BOOST_REQUIRE(!decode(decoder, headers, "be"));
+}
+
+BOOST_AUTO_TEST_CASE(hpack__decode__size_update_above_maximum__false)
+{
+    hpack decoder(100);
+    hpack::header_list headers;
+    BOOST_REQUIRE(!decode(decoder, headers, "3f46"));
+}
+
+BOOST_AUTO_TEST_CASE(hpack__decode__list_above_maximum__false)
+{
+    // A 93 byte entry (with overhead) indexed, then referenced again.
+    data_chunk block{ 0x40, 0x01, 'a', 0x3c };
+    block.resize(block.size() + 60, 'x');
+    block.push_back(0xbe);
+
+    hpack decoder(hpack::default_table_size, 100);
+    hpack::header_list headers;
+    BOOST_REQUIRE(!decoder.decode(headers, block.data(), block.size()));
+
+    hpack larger(hpack::default_table_size, 186);
+    headers.clear();
+    BOOST_REQUIRE(larger.decode(headers, block.data(), block.size()));
+    BOOST_REQUIRE_EQUAL(headers.size(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(hpack__decode__index_zero__false)
+{
+    hpack decoder;
+    hpack::header_list headers;
+    BOOST_REQUIRE(!decode(decoder, headers, "80"));
+}
+
+BOOST_AUTO_TEST_CASE(hpack__encode__static_and_literal__decodes)
+{
+    const hpack::header_list headers
+    {
+        { ":status", "200" },
+        { "content-type", "application/json" },
+        { "x-custom", "value" }
+    };
+
+    data_chunk block;
+    hpack::encode(block, headers);
+    BOOST_REQUIRE_EQUAL(block.front(), 0x88);
+
+    hpack decoder;
+    hpack::header_list decoded;
+    BOOST_REQUIRE(decoder.decode(decoded, block.data(), block.size()));
+    BOOST_REQUIRE(decoded == headers);
+    BOOST_REQUIRE_EQUAL(decoder.table_size(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
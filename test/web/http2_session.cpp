@@ -0,0 +1,421 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <bitcoin/protocol.hpp>
+
+using namespace bc::system;
+using namespace bc::protocol::http;
+
+BOOST_AUTO_TEST_SUITE(http2_session_tests)
+
+typedef http2_session::frame_type frame_type;
+
+struct frame
+{
+    frame_type type;
+    uint8_t flags;
+    uint32_t stream;
+    data_chunk payload;
+};
+
+static std::vector<frame> parse_frames(const data_chunk& data)
+{
+    std::vector<frame> out;
+    for (size_t offset = 0; offset + 9 <= data.size();)
+    {
+        const auto header = data.data() + offset;
+        const size_t length = (header[0] << 16) | (header[1] << 8) | header[2];
+        const uint32_t stream = ((header[5] & 0x7f) << 24) |
+            (header[6] << 16) | (header[7] << 8) | header[8];
+
+        out.push_back({ static_cast<frame_type>(header[3]), header[4], stream,
+            { header + 9, header + 9 + length } });
+
+        offset += 9 + length;
+    }
+
+    return out;
+}
+
+static void write_frame(data_chunk& out, frame_type type, uint8_t flags,
+    uint32_t stream, const data_chunk& payload)
+{
+    http2_session::write_frame(out, type, flags, stream, payload.data(),
+        payload.size());
+}
+
+static data_chunk preface()
+{
+    const auto& text = http2_session::preface;
+    data_chunk out(text.begin(), text.end());
+    write_frame(out, frame_type::settings, 0, 0, {});
+    return out;
+}
+
+static void write_request(data_chunk& out, uint32_t stream,
+    const std::string& body)
+{
+    data_chunk block;
+    hpack::encode(block,
+    {
+        { ":method", "POST" },
+        { ":scheme", "http" },
+        { ":path", "/?Key=Value" },
+        { ":authority", "localhost" },
+        { "Accept-Encoding", "identity" }
+    });
+
+    write_frame(out, frame_type::headers, body.empty() ? 0x05 : 0x04, stream,
+        block);
+
+    if (!body.empty())
+        write_frame(out, frame_type::data, 0x01, stream,
+            { body.begin(), body.end() });
+}
+
+static const std::string json = "{\"id\":1,\"method\":\"test\",\"params\":[]}";
+
+BOOST_AUTO_TEST_CASE(http2_session__match_preface__prefix__true)
+{
+    const std::string partial = "PRI * HT";
+    const std::string other = "POST / HTTP/1.1\r\n";
+    const auto data = reinterpret_cast<const uint8_t*>(partial.data());
+    BOOST_REQUIRE(http2_session::match_preface(data, partial.size()));
+    BOOST_REQUIRE(!http2_session::match_preface(
+        reinterpret_cast<const uint8_t*>(other.data()), other.size()));
+}
+
+BOOST_AUTO_TEST_CASE(http2_session__receive__preface_and_settings__settings_and_ack)
+{
+    http2_session session(1024);
+    http2_session::request_list requests;
+    auto input = preface();
+    data_chunk output;
+
+    BOOST_REQUIRE(session.receive(requests, input, output));
+    BOOST_REQUIRE(input.empty());
+    BOOST_REQUIRE(requests.empty());
+
+    const auto frames = parse_frames(output);
+    BOOST_REQUIRE_EQUAL(frames.size(), 2u);
+    BOOST_REQUIRE(frames[0].type == frame_type::settings);
+    BOOST_REQUIRE_EQUAL(frames[0].flags, 0u);
+    BOOST_REQUIRE_EQUAL(frames[0].payload.size(), 12u);
+    BOOST_REQUIRE(frames[1].type == frame_type::settings);
+    BOOST_REQUIRE_EQUAL(frames[1].flags, 0x01u);
+}
+
+BOOST_AUTO_TEST_CASE(http2_session__receive__partial_frame__retained)
+{
+    http2_session session(1024);
+    http2_session::request_list requests;
+    auto input = preface();
+    data_chunk output;
+    write_request(input, 1, json);
+    const auto tail = data_chunk(input.end() - 5, input.end());
+    input.resize(input.size() - 5);
+
+    BOOST_REQUIRE(session.receive(requests, input, output));
+    BOOST_REQUIRE(requests.empty());
+    BOOST_REQUIRE(!input.empty());
+
+    input.insert(input.end(), tail.begin(), tail.end());
+    BOOST_REQUIRE(session.receive(requests, input, output));
+    BOOST_REQUIRE(input.empty());
+    BOOST_REQUIRE_EQUAL(requests.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(http2_session__receive__json_rpc_request__expected)
+{
+    http2_session session(1024);
+    http2_session::request_list requests;
+    auto input = preface();
+    data_chunk output;
+    write_request(input, 1, json);
+    write_request(input, 3, json);
+
+    BOOST_REQUIRE(session.receive(requests, input, output));
+    BOOST_REQUIRE_EQUAL(requests.size(), 2u);
+    BOOST_REQUIRE_EQUAL(session.streams(), 2u);
+
+    const auto& request = requests[0].request;
+    BOOST_REQUIRE_EQUAL(requests[0].stream, 1u);
+    BOOST_REQUIRE_EQUAL(requests[1].stream, 3u);
+    BOOST_REQUIRE_EQUAL(request.method, "post");
+    BOOST_REQUIRE_EQUAL(request.uri, "/");
+    BOOST_REQUIRE_EQUAL(request.protocol_version, 2.0);
+    BOOST_REQUIRE_EQUAL(request.header("host"), "localhost");
+    BOOST_REQUIRE_EQUAL(request.header("accept-encoding"), "identity");
+    BOOST_REQUIRE_EQUAL(request.parameter("key"), "value");
+    BOOST_REQUIRE_EQUAL(request.content_length, json.size());
+    BOOST_REQUIRE(request.json_rpc);
+    BOOST_REQUIRE_EQUAL(request.json_tree.get<std::string>("method"), "test");
+}
+
+BOOST_AUTO_TEST_CASE(http2_session__respond__out_of_order__framed_on_streams)
+{
+    http2_session session(1024);
+    http2_session::request_list requests;
+    auto input = preface();
+    data_chunk output;
+    write_request(input, 1, json);
+    write_request(input, 3, json);
+    BOOST_REQUIRE(session.receive(requests, input, output));
+    output.clear();
+
+    session.respond(3, protocol_status::ok, {}, "three");
+    session.respond(1, protocol_status::not_implemented, {}, {});
+    session.flush(output, 65536);
+    BOOST_REQUIRE_EQUAL(session.streams(), 0u);
+    BOOST_REQUIRE(!session.writable());
+
+    const auto frames = parse_frames(output);
+    BOOST_REQUIRE_EQUAL(frames.size(), 3u);
+    BOOST_REQUIRE(frames[0].type == frame_type::headers);
+    BOOST_REQUIRE_EQUAL(frames[0].stream, 3u);
+    BOOST_REQUIRE_EQUAL(frames[0].flags, 0x04u);
+    BOOST_REQUIRE(frames[1].type == frame_type::headers);
+    BOOST_REQUIRE_EQUAL(frames[1].stream, 1u);
+    BOOST_REQUIRE_EQUAL(frames[1].flags, 0x05u);
+    BOOST_REQUIRE(frames[2].type == frame_type::data);
+    BOOST_REQUIRE_EQUAL(frames[2].stream, 3u);
+    BOOST_REQUIRE_EQUAL(frames[2].flags, 0x01u);
+    BOOST_REQUIRE_EQUAL(std::string(frames[2].payload.begin(),
+        frames[2].payload.end()), "three");
+
+    hpack decoder;
+    hpack::header_list headers;
+    BOOST_REQUIRE(decoder.decode(headers, frames[1].payload.data(),
+        frames[1].payload.size()));
+    BOOST_REQUIRE_EQUAL(headers[0].first, ":status");
+    BOOST_REQUIRE_EQUAL(headers[0].second, "501");
+}
+
+BOOST_AUTO_TEST_CASE(http2_session__flush__stream_window__resumed_by_window_update)
+{
+    http2_session session(1024);
+    http2_session::request_list requests;
+    auto input = preface();
+    data_chunk output;
+
+    // SETTINGS_INITIAL_WINDOW_SIZE of 4 bytes.
+    write_frame(input, frame_type::settings, 0, 0, { 0, 4, 0, 0, 0, 4 });
+    write_request(input, 1, json);
+    BOOST_REQUIRE(session.receive(requests, input, output));
+    output.clear();
+
+    session.respond(1, protocol_status::ok, {}, "0123456789");
+    session.flush(output, 65536);
+    BOOST_REQUIRE(!session.writable());
+
+    auto frames = parse_frames(output);
+    BOOST_REQUIRE_EQUAL(frames.size(), 2u);
+    BOOST_REQUIRE(frames[1].type == frame_type::data);
+    BOOST_REQUIRE_EQUAL(frames[1].payload.size(), 4u);
+    BOOST_REQUIRE_EQUAL(frames[1].flags, 0u);
+
+    output.clear();
+    write_frame(input, frame_type::window_update, 0, 1, { 0, 0, 0, 100 });
+    BOOST_REQUIRE(session.receive(requests, input, output));
+    BOOST_REQUIRE(session.writable());
+    session.flush(output, 65536);
+
+    frames = parse_frames(output);
+    BOOST_REQUIRE_EQUAL(frames.size(), 1u);
+    BOOST_REQUIRE_EQUAL(std::string(frames[0].payload.begin(),
+        frames[0].payload.end()), "456789");
+    BOOST_REQUIRE_EQUAL(frames[0].flags, 0x01u);
+    BOOST_REQUIRE_EQUAL(session.streams(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(http2_session__receive__ping__acknowledged)
+{
+    http2_session session(1024);
+    http2_session::request_list requests;
+    auto input = preface();
+    data_chunk output;
+    BOOST_REQUIRE(session.receive(requests, input, output));
+    output.clear();
+
+    write_frame(input, frame_type::ping, 0, 0, { 1, 2, 3, 4, 5, 6, 7, 8 });
+    BOOST_REQUIRE(session.receive(requests, input, output));
+
+    const auto frames = parse_frames(output);
+    BOOST_REQUIRE_EQUAL(frames.size(), 1u);
+    BOOST_REQUIRE(frames[0].type == frame_type::ping);
+    BOOST_REQUIRE_EQUAL(frames[0].flags, 0x01u);
+    BOOST_REQUIRE(frames[0].payload == data_chunk({ 1, 2, 3, 4, 5, 6, 7, 8 }));
+}
+
+BOOST_AUTO_TEST_CASE(http2_session__receive__concurrency_exceeded__refused)
+{
+    http2_session session(1024, 1);
+    http2_session::request_list requests;
+    auto input = preface();
+    data_chunk output;
+    write_request(input, 1, json);
+    write_request(input, 3, json);
+    BOOST_REQUIRE(session.receive(requests, input, output));
+    BOOST_REQUIRE_EQUAL(requests.size(), 1u);
+
+    // The refused stream's DATA is still counted against the connection.
+    const auto frames = parse_frames(output);
+    const auto reset = std::find_if(frames.begin(), frames.end(),
+        [](const frame& item)
+        {
+            return item.type == frame_type::rst_stream;
+        });
+
+    BOOST_REQUIRE(reset != frames.end());
+    BOOST_REQUIRE_EQUAL(reset->stream, 3u);
+    BOOST_REQUIRE_EQUAL(reset->payload.back(), 0x07u);
+    BOOST_REQUIRE(frames.back().type == frame_type::window_update);
+    BOOST_REQUIRE_EQUAL(frames.back().stream, 0u);
+}
+
+static void write_reset(data_chunk& out, uint32_t stream)
+{
+    write_frame(out, frame_type::rst_stream, 0, stream, { 0, 0, 0, 8 });
+}
+
+BOOST_AUTO_TEST_CASE(http2_session__receive__reset_dispatched__still_counted)
+{
+    http2_session session(1024, 1);
+    http2_session::request_list requests;
+    auto input = preface();
+    data_chunk output;
+    write_request(input, 1, json);
+    write_reset(input, 1);
+    write_request(input, 3, json);
+    BOOST_REQUIRE(session.receive(requests, input, output));
+
+    // The reset request is still being answered, so the next is refused.
+    BOOST_REQUIRE_EQUAL(requests.size(), 1u);
+    BOOST_REQUIRE_EQUAL(session.streams(), 1u);
+
+    // Its response is dropped, which then releases the stream.
+    session.respond(1, protocol_status::ok, {}, "a");
+    BOOST_REQUIRE_EQUAL(session.streams(), 0u);
+    output.clear();
+    session.flush(output, 1024);
+    BOOST_REQUIRE(output.empty());
+}
+
+BOOST_AUTO_TEST_CASE(http2_session__receive__rapid_reset__goaway)
+{
+    http2_session session(1024, 2);
+    http2_session::request_list requests;
+    auto input = preface();
+    data_chunk output;
+    BOOST_REQUIRE(session.receive(requests, input, output));
+
+    // Each cancelled request is answered, but cancellations accumulate.
+    uint32_t stream = 1;
+    for (; stream <= 5; stream += 2)
+    {
+        write_request(input, stream, json);
+        write_reset(input, stream);
+        if (!session.receive(requests, input, output))
+            break;
+
+        session.respond(stream, protocol_status::ok, {}, "a");
+    }
+
+    BOOST_REQUIRE_EQUAL(stream, 5u);
+    BOOST_REQUIRE(session.closing());
+    BOOST_REQUIRE(parse_frames(output).back().type == frame_type::goaway);
+}
+
+BOOST_AUTO_TEST_CASE(http2_session__receive__excessive_body__reset)
+{
+    http2_session session(8);
+    http2_session::request_list requests;
+    auto input = preface();
+    data_chunk output;
+    write_request(input, 1, json);
+    BOOST_REQUIRE(session.receive(requests, input, output));
+    BOOST_REQUIRE(requests.empty());
+    BOOST_REQUIRE_EQUAL(session.streams(), 0u);
+
+    const auto frames = parse_frames(output);
+    BOOST_REQUIRE(frames.back().type == frame_type::rst_stream);
+    BOOST_REQUIRE_EQUAL(frames.back().payload.back(), 0x0bu);
+}
+
+BOOST_AUTO_TEST_CASE(http2_session__receive__interleaved_continuation__goaway)
+{
+    http2_session session(1024);
+    http2_session::request_list requests;
+    auto input = preface();
+    data_chunk output;
+
+    // HEADERS without END_HEADERS must be followed by CONTINUATION.
+    data_chunk block;
+    hpack::encode(block, { { ":method", "POST" } });
+    write_frame(input, frame_type::headers, 0, 1, block);
+    write_frame(input, frame_type::ping, 0, 0, { 0, 0, 0, 0, 0, 0, 0, 0 });
+
+    BOOST_REQUIRE(!session.receive(requests, input, output));
+    BOOST_REQUIRE(session.closing());
+
+    const auto frames = parse_frames(output);
+    BOOST_REQUIRE(frames.back().type == frame_type::goaway);
+    BOOST_REQUIRE_EQUAL(frames.back().payload.back(), 0x01u);
+}
+
+BOOST_AUTO_TEST_CASE(http2_session__receive__continuation__request)
+{
+    http2_session session(1024);
+    http2_session::request_list requests;
+    auto input = preface();
+    data_chunk output;
+
+    data_chunk block;
+    hpack::encode(block, { { ":method", "GET" }, { ":path", "/index.html" } });
+    const data_chunk first(block.begin(), block.begin() + 1);
+    const data_chunk second(block.begin() + 1, block.end());
+    write_frame(input, frame_type::headers, 0x01, 1, first);
+    write_frame(input, frame_type::continuation, 0x04, 1, second);
+
+    BOOST_REQUIRE(session.receive(requests, input, output));
+    BOOST_REQUIRE_EQUAL(requests.size(), 1u);
+    BOOST_REQUIRE_EQUAL(requests[0].request.method, "get");
+    BOOST_REQUIRE_EQUAL(requests[0].request.uri, "/index.html");
+    BOOST_REQUIRE(!requests[0].request.json_rpc);
+}
+
+BOOST_AUTO_TEST_CASE(http2_session__receive__bad_preface__goaway)
+{
+    http2_session session(1024);
+    http2_session::request_list requests;
+    const std::string text = "PRI * HTTP/2.0\r\n\r\nXX\r\n\r\n";
+    data_chunk input(text.begin(), text.end());
+    data_chunk output;
+
+    BOOST_REQUIRE(!session.receive(requests, input, output));
+    const auto frames = parse_frames(output);
+    BOOST_REQUIRE_EQUAL(frames.size(), 1u);
+    BOOST_REQUIRE(frames[0].type == frame_type::goaway);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,295 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <bitcoin/protocol.hpp>
+
+#include <cstdint>
+#include <string>
+
+using namespace bc::system;
+using namespace bc::protocol::http;
+
+BOOST_AUTO_TEST_SUITE(http_parser_tests)
+
+typedef http_parser::result result;
+
+static result parse(http_parser& parser, const std::string& input)
+{
+    return parser.parse(reinterpret_cast<const uint8_t*>(input.data()),
+        input.size());
+}
+
+static const std::string get_request =
+    "GET /index.html?Foo=Bar&baz=1 HTTP/1.1\r\n"
+    "Host: localhost\r\n"
+    "Connection: Upgrade\r\n"
+    "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+    "\r\n";
+
+static const std::string post_request =
+    "POST / HTTP/1.1\r\n"
+    "Content-Type: application/json\r\n"
+    "Content-Length: 41\r\n"
+    "\r\n"
+    "{\"id\":1,\"method\":\"test\",\"params\":[\"abc\"]}";
+
+BOOST_AUTO_TEST_CASE(http_parser__parse__get__complete)
+{
+    http_parser parser;
+    BOOST_REQUIRE(parse(parser, get_request) == result::complete);
+    BOOST_REQUIRE(parser.headers_complete());
+    BOOST_REQUIRE_EQUAL(parser.method(), "GET");
+    BOOST_REQUIRE_EQUAL(parser.target(), "/index.html?Foo=Bar&baz=1");
+    BOOST_REQUIRE_EQUAL(parser.path(), "/index.html");
+    BOOST_REQUIRE_EQUAL(parser.query(), "Foo=Bar&baz=1");
+    BOOST_REQUIRE_EQUAL(parser.protocol(), "HTTP/1.1");
+    BOOST_REQUIRE_EQUAL(parser.minor_version(), 1u);
+    BOOST_REQUIRE_EQUAL(parser.header_count(), 3u);
+    BOOST_REQUIRE_EQUAL(parser.header_name(0), "Host");
+    BOOST_REQUIRE_EQUAL(parser.header_value(0), "localhost");
+    BOOST_REQUIRE_EQUAL(parser.header_length(), get_request.size());
+    BOOST_REQUIRE_EQUAL(parser.message_length(), get_request.size());
+    BOOST_REQUIRE(parser.body().empty());
+}
+
+BOOST_AUTO_TEST_CASE(http_parser__complete__until_reset__held)
+{
+    http_parser parser;
+    BOOST_REQUIRE(parse(parser, post_request.substr(0, 40)) ==
+        result::incomplete);
+    BOOST_REQUIRE(!parser.complete());
+    BOOST_REQUIRE(parse(parser, post_request) == result::complete);
+    BOOST_REQUIRE(parser.complete());
+    parser.reset();
+    BOOST_REQUIRE(!parser.complete());
+}
+
+BOOST_AUTO_TEST_CASE(http_parser__header__mixed_case__found)
+{
+    http_parser parser;
+    BOOST_REQUIRE(parse(parser, get_request) == result::complete);
+    BOOST_REQUIRE_EQUAL(parser.header("sec-websocket-key"),
+        "dGhlIHNhbXBsZSBub25jZQ==");
+    BOOST_REQUIRE_EQUAL(parser.header("CONNECTION"), "Upgrade");
+    BOOST_REQUIRE(parser.header("missing").empty());
+}
+
+BOOST_AUTO_TEST_CASE(http_parser__parse__optional_whitespace__trimmed)
+{
+    http_parser parser;
+    const std::string input = "GET / HTTP/1.0\r\nHost: \t a:b:c \t\r\n\r\n";
+    BOOST_REQUIRE(parse(parser, input) == result::complete);
+    BOOST_REQUIRE_EQUAL(parser.header("host"), "a:b:c");
+    BOOST_REQUIRE_EQUAL(parser.minor_version(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(http_parser__parse__bare_line_feeds__complete)
+{
+    http_parser parser;
+    const std::string input = "GET / HTTP/1.1\nHost: x\n\n";
+    BOOST_REQUIRE(parse(parser, input) == result::complete);
+    BOOST_REQUIRE_EQUAL(parser.header("host"), "x");
+}
+
+BOOST_AUTO_TEST_CASE(http_parser__parse__leading_empty_lines__ignored)
+{
+    http_parser parser;
+    const std::string input = "\r\n\r\nGET / HTTP/1.1\r\n\r\n";
+    BOOST_REQUIRE(parse(parser, input) == result::complete);
+    BOOST_REQUIRE_EQUAL(parser.method(), "GET");
+}
+
+BOOST_AUTO_TEST_CASE(http_parser__parse__post__body)
+{
+    http_parser parser;
+    BOOST_REQUIRE(parse(parser, post_request) == result::complete);
+    BOOST_REQUIRE_EQUAL(parser.content_length(), 41u);
+    BOOST_REQUIRE_EQUAL(parser.message_length(), post_request.size());
+    BOOST_REQUIRE_EQUAL(parser.body(), post_request.substr(
+        post_request.size() - 41));
+}
+
+BOOST_AUTO_TEST_CASE(http_parser__parse__every_split__complete)
+{
+    // Resume at every possible split point, with the input relocated.
+    for (size_t split = 0; split < post_request.size(); ++split)
+    {
+        http_parser parser;
+        const std::string first = post_request.substr(0, split);
+        BOOST_REQUIRE(parse(parser, first) == result::incomplete);
+        const std::string copy = post_request;
+        BOOST_REQUIRE(parse(parser, copy) == result::complete);
+        BOOST_REQUIRE_EQUAL(parser.method(), "POST");
+        BOOST_REQUIRE_EQUAL(parser.header("content-type"), "application/json");
+        BOOST_REQUIRE_EQUAL(parser.body().size(), 41u);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(http_parser__parse__byte_at_a_time__complete)
+{
+    http_parser parser;
+    for (size_t size = 1; size < get_request.size(); ++size)
+        BOOST_REQUIRE(parse(parser, get_request.substr(0, size)) ==
+            result::incomplete);
+
+    BOOST_REQUIRE(parse(parser, get_request) == result::complete);
+    BOOST_REQUIRE_EQUAL(parser.header_count(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(http_parser__parse__partial_headers__available)
+{
+    http_parser parser;
+    const std::string input = "GET / HTTP/1.1\r\nHost: x\r\nAcc";
+    BOOST_REQUIRE(parse(parser, input) == result::incomplete);
+    BOOST_REQUIRE(!parser.headers_complete());
+    BOOST_REQUIRE_EQUAL(parser.method(), "GET");
+    BOOST_REQUIRE_EQUAL(parser.header_count(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(http_parser__parse__pipelined__first_message_length)
+{
+    http_parser parser;
+    const auto input = get_request + post_request;
+    BOOST_REQUIRE(parse(parser, input) == result::complete);
+    BOOST_REQUIRE_EQUAL(parser.message_length(), get_request.size());
+}
+
+BOOST_AUTO_TEST_CASE(http_parser__reset__complete__reparses)
+{
+    http_parser parser;
+    BOOST_REQUIRE(parse(parser, get_request) == result::complete);
+    parser.reset();
+    BOOST_REQUIRE(parse(parser, post_request) == result::complete);
+    BOOST_REQUIRE_EQUAL(parser.method(), "POST");
+}
+
+BOOST_AUTO_TEST_CASE(http_parser__parse__invalid_request_line__error)
+{
+    http_parser parser1;
+    BOOST_REQUIRE(parse(parser1, "GET /\r\n\r\n") == result::error);
+    http_parser parser2;
+    BOOST_REQUIRE(parse(parser2, "GET / HTTP/2.0\r\n\r\n") == result::error);
+    http_parser parser3;
+    BOOST_REQUIRE(parse(parser3, "GET  / HTTP/1.1\r\n\r\n") == result::error);
+    http_parser parser4;
+    BOOST_REQUIRE(parse(parser4, "G(T / HTTP/1.1\r\n\r\n") == result::error);
+}
+
+BOOST_AUTO_TEST_CASE(http_parser__parse__invalid_header__error)
+{
+    http_parser parser1;
+    BOOST_REQUIRE(parse(parser1, "GET / HTTP/1.1\r\nHost x\r\n\r\n") ==
+        result::error);
+    http_parser parser2;
+    BOOST_REQUIRE(parse(parser2, "GET / HTTP/1.1\r\nHost : x\r\n\r\n") ==
+        result::error);
+    http_parser parser3;
+    BOOST_REQUIRE(parse(parser3, "GET / HTTP/1.1\r\nA: b\r\n folded\r\n\r\n") ==
+        result::error);
+}
+
+BOOST_AUTO_TEST_CASE(http_parser__parse__invalid_content_length__error)
+{
+    http_parser parser1;
+    BOOST_REQUIRE(parse(parser1,
+        "POST / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n") == result::error);
+    http_parser parser2;
+    BOOST_REQUIRE(parse(parser2,
+        "POST / HTTP/1.1\r\nContent-Length: 99999999999999999999999\r\n\r\n") ==
+        result::error);
+    http_parser parser3;
+    BOOST_REQUIRE(parse(parser3,
+        "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n") ==
+        result::error);
+}
+
+BOOST_AUTO_TEST_CASE(http_parser__parse__repeated_content_length__agreed)
+{
+    http_parser parser1;
+    BOOST_REQUIRE(parse(parser1, "POST / HTTP/1.1\r\nContent-Length: 1\r\n"
+        "Content-Length: 2\r\n\r\nab") == result::error);
+    http_parser parser2;
+    BOOST_REQUIRE(parse(parser2, "POST / HTTP/1.1\r\nContent-Length: 2\r\n"
+        "Content-Length: 2\r\n\r\nab") == result::complete);
+    BOOST_REQUIRE_EQUAL(parser2.content_length(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(http_parser__parse__oversized_header__error)
+{
+    http_parser parser;
+    const std::string input = "GET / HTTP/1.1\r\nX: " +
+        std::string(http_parser::maximum_header_length, 'a');
+    BOOST_REQUIRE(parse(parser, input) == result::error);
+}
+
+BOOST_AUTO_TEST_CASE(http_parser__parse__too_many_headers__error)
+{
+    http_parser parser;
+    std::string input = "GET / HTTP/1.1\r\n";
+    for (size_t index = 0; index <= http_parser::maximum_headers; ++index)
+        input += "X: y\r\n";
+
+    BOOST_REQUIRE(parse(parser, input + "\r\n") == result::error);
+}
+
+BOOST_AUTO_TEST_CASE(http_parser__to_request__get__legacy_fields)
+{
+    http_parser parser;
+    http_request out;
+    BOOST_REQUIRE(parse(parser, get_request) == result::complete);
+    BOOST_REQUIRE(parser.to_request(out));
+    BOOST_REQUIRE_EQUAL(out.method, "get");
+    BOOST_REQUIRE_EQUAL(out.uri, "/index.html");
+    BOOST_REQUIRE_EQUAL(out.protocol, "http/1.1");
+    BOOST_REQUIRE_CLOSE(out.protocol_version, 1.1, 0.001);
+    BOOST_REQUIRE_EQUAL(out.header("Connection"), "upgrade");
+    BOOST_REQUIRE_EQUAL(out.header("sec-websocket-key"),
+        "dGhlIHNhbXBsZSBub25jZQ==");
+    BOOST_REQUIRE_EQUAL(out.parameter("foo"), "bar");
+    BOOST_REQUIRE_EQUAL(out.parameter("baz"), "1");
+    BOOST_REQUIRE(out.upgrade_request);
+    BOOST_REQUIRE(!out.json_rpc);
+}
+
+BOOST_AUTO_TEST_CASE(http_parser__to_request__incomplete__false)
+{
+    http_parser parser;
+    http_request out;
+    BOOST_REQUIRE(parse(parser, "GET / HTTP/1.1\r\n") == result::incomplete);
+    BOOST_REQUIRE(!parser.to_request(out));
+}
+
+BOOST_AUTO_TEST_CASE(http_parser__parse_http__post__json_rpc)
+{
+    http_request out;
+    BOOST_REQUIRE(parse_http(out, post_request));
+    BOOST_REQUIRE(out.json_rpc);
+    BOOST_REQUIRE_EQUAL(out.content_length, 41u);
+    BOOST_REQUIRE_EQUAL(out.json_tree.get<std::string>("method"), "test");
+}
+
+BOOST_AUTO_TEST_CASE(http_parser__parse_http__truncated_body__false)
+{
+    http_request out;
+    BOOST_REQUIRE(!parse_http(out, post_request.substr(0,
+        post_request.size() - 1)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
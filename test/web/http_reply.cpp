@@ -0,0 +1,121 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <bitcoin/protocol.hpp>
+
+#include <string>
+
+using namespace bc::system;
+using namespace bc::protocol::http;
+
+BOOST_AUTO_TEST_SUITE(http_reply_tests)
+
+static bool contains(const std::string& text, const std::string& value)
+{
+    return text.find(value) != std::string::npos;
+}
+
+BOOST_AUTO_TEST_CASE(http_reply__to_string__known__status_line)
+{
+    BOOST_REQUIRE_EQUAL(http_reply::to_string(protocol_status::ok),
+        "HTTP/1.1 200 OK\r\n");
+    BOOST_REQUIRE_EQUAL(http_reply::to_string(
+        protocol_status::service_unavailable),
+        "HTTP/1.1 503 Service Unavailable\r\n");
+}
+
+BOOST_AUTO_TEST_CASE(http_reply__to_string__unknown__empty)
+{
+    BOOST_REQUIRE(http_reply::to_string(
+        static_cast<protocol_status>(299)).empty());
+}
+
+BOOST_AUTO_TEST_CASE(http_reply__generate__keep_alive__expected_fields)
+{
+    const auto header = http_reply::generate(protocol_status::not_found,
+        "text/html", 1234, true);
+
+    BOOST_REQUIRE_EQUAL(header.find("HTTP/1.1 404 Not Found\r\nDate: "), 0u);
+    BOOST_REQUIRE(contains(header, " GMT\r\n"));
+    BOOST_REQUIRE(contains(header, "Connection: keep-alive\r\n"));
+    BOOST_REQUIRE(contains(header, "Content-Type: text/html\r\n"));
+    BOOST_REQUIRE(contains(header, "Content-Length: 1234\r\n"));
+    BOOST_REQUIRE_EQUAL(header.substr(header.size() - 4), "\r\n\r\n");
+}
+
+BOOST_AUTO_TEST_CASE(http_reply__generate__close_empty__no_length)
+{
+    const auto header = http_reply::generate(protocol_status::bad_request,
+        {}, 0, false);
+
+    BOOST_REQUIRE(contains(header, "Connection: close\r\n"));
+    BOOST_REQUIRE(!contains(header, "Content-Length"));
+    BOOST_REQUIRE(!contains(header, "Content-Type"));
+}
+
+BOOST_AUTO_TEST_CASE(http_reply__generate__keep_alive_empty__zero_length)
+{
+    const auto header = http_reply::generate(protocol_status::ok, {}, 0,
+        true);
+
+    BOOST_REQUIRE(contains(header, "Content-Length: 0\r\n"));
+}
+
+BOOST_AUTO_TEST_CASE(http_reply__generate_chunked__transfer_encoding)
+{
+    const auto header = http_reply::generate_chunked(protocol_status::ok,
+        "application/json", true);
+
+    BOOST_REQUIRE(contains(header, "Transfer-Encoding: chunked\r\n"));
+    BOOST_REQUIRE(!contains(header, "Content-Length"));
+}
+
+BOOST_AUTO_TEST_CASE(http_reply__write__appended__matches_generate)
+{
+    data_chunk out{ 'x' };
+    http_reply::write(out, protocol_status::ok, "text/plain", 42, true);
+    const auto expected = "x" + http_reply::generate(protocol_status::ok,
+        "text/plain", 42, true);
+
+    // The date may roll over between the two calls.
+    BOOST_REQUIRE_EQUAL(out.size(), expected.size());
+    BOOST_REQUIRE_EQUAL(std::string(out.begin(), out.begin() + 18),
+        expected.substr(0, 18));
+}
+
+BOOST_AUTO_TEST_CASE(http_reply__generate_upgrade__protocol__named_header)
+{
+    const auto header = http_reply::generate_upgrade("key", "chat",
+        "permessage-deflate");
+
+    BOOST_REQUIRE(contains(header, "\r\nSec-WebSocket-Protocol: chat\r\n"));
+    BOOST_REQUIRE(contains(header,
+        "\r\nSec-WebSocket-Extensions: permessage-deflate\r\n"));
+    BOOST_REQUIRE(contains(header, "\r\nSec-WebSocket-Accept: key\r\n\r\n"));
+}
+
+BOOST_AUTO_TEST_CASE(http_reply__generate_upgrade__no_protocol__omitted)
+{
+    const auto header = http_reply::generate_upgrade("key", "");
+    BOOST_REQUIRE(!contains(header, "Sec-WebSocket-Protocol"));
+    BOOST_REQUIRE(!contains(header, "Sec-WebSocket-Extensions"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
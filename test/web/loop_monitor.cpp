@@ -0,0 +1,126 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <bitcoin/protocol.hpp>
+
+using namespace bc::system;
+using namespace bc::protocol::http;
+
+BOOST_AUTO_TEST_SUITE(loop_monitor_tests)
+
+// histogram
+
+BOOST_AUTO_TEST_CASE(loop_monitor__histogram__default__empty)
+{
+    const loop_monitor::histogram instance;
+    BOOST_REQUIRE_EQUAL(instance.count(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.total(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.maximum(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.percentile(50), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(loop_monitor__histogram__record__zero__first_bucket)
+{
+    loop_monitor::histogram instance;
+    instance.record(0);
+    BOOST_REQUIRE_EQUAL(instance.count(), 1u);
+    BOOST_REQUIRE_EQUAL(instance.bucket(0), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(loop_monitor__histogram__record__powers_of_two__log2_buckets)
+{
+    loop_monitor::histogram instance;
+    instance.record(1);
+    instance.record(2);
+    instance.record(3);
+    instance.record(1024);
+    BOOST_REQUIRE_EQUAL(instance.bucket(1), 1u);
+    BOOST_REQUIRE_EQUAL(instance.bucket(2), 2u);
+    BOOST_REQUIRE_EQUAL(instance.bucket(11), 1u);
+    BOOST_REQUIRE_EQUAL(instance.total(), 1030u);
+    BOOST_REQUIRE_EQUAL(instance.maximum(), 1024u);
+}
+
+BOOST_AUTO_TEST_CASE(loop_monitor__histogram__record__maximum_value__last_bucket)
+{
+    loop_monitor::histogram instance;
+    instance.record(max_uint64);
+    BOOST_REQUIRE_EQUAL(instance.bucket(loop_monitor::histogram::buckets - 1), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(loop_monitor__histogram__percentile__skewed__bucket_upper_bound)
+{
+    loop_monitor::histogram instance;
+    for (size_t index = 0; index < 99; ++index)
+        instance.record(10);
+
+    instance.record(5000);
+    BOOST_REQUIRE_EQUAL(instance.percentile(50), 15u);
+    BOOST_REQUIRE_EQUAL(instance.percentile(100), 5000u);
+}
+
+BOOST_AUTO_TEST_CASE(loop_monitor__histogram__reset__recorded__empty)
+{
+    loop_monitor::histogram instance;
+    instance.record(42);
+    instance.reset();
+    BOOST_REQUIRE_EQUAL(instance.count(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.bucket(6), 0u);
+}
+
+// record_iteration
+
+BOOST_AUTO_TEST_CASE(loop_monitor__record_iteration__always__splits_polling_and_handling)
+{
+    loop_monitor instance;
+    instance.record_iteration(loop_monitor::microseconds(300),
+        loop_monitor::microseconds(100), 7);
+    BOOST_REQUIRE_EQUAL(instance.iterations().total(), 300u);
+    BOOST_REQUIRE_EQUAL(instance.polling().total(), 100u);
+    BOOST_REQUIRE_EQUAL(instance.handling().total(), 200u);
+    BOOST_REQUIRE_EQUAL(instance.events().total(), 7u);
+}
+
+BOOST_AUTO_TEST_CASE(loop_monitor__record_queue_latency__negative__zero)
+{
+    loop_monitor instance;
+    instance.record_queue_latency(loop_monitor::microseconds(-5));
+    BOOST_REQUIRE_EQUAL(instance.queue_latency().count(), 1u);
+    BOOST_REQUIRE_EQUAL(instance.queue_latency().total(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(loop_monitor__record_round_trip__value__recorded)
+{
+    loop_monitor instance;
+    instance.record_round_trip(loop_monitor::microseconds(1500));
+    BOOST_REQUIRE_EQUAL(instance.round_trips().count(), 1u);
+    BOOST_REQUIRE_EQUAL(instance.round_trips().total(), 1500u);
+    instance.reset();
+    BOOST_REQUIRE_EQUAL(instance.round_trips().count(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(loop_monitor__set_budget__value__expected)
+{
+    loop_monitor instance;
+    instance.set_budget(loop_monitor::milliseconds(25));
+    BOOST_REQUIRE(instance.budget() == loop_monitor::milliseconds(25));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
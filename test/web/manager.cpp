@@ -0,0 +1,186 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <bitcoin/protocol.hpp>
+#include "../utility.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+using namespace bc::protocol::http;
+
+BOOST_AUTO_TEST_SUITE(manager_tests)
+
+static connection_ptr make_connection()
+{
+    return std::make_shared<closing_connection>();
+}
+
+static bool handle(connection_ptr, event, void*)
+{
+    return true;
+}
+
+// An admission limit of zero is disabled.
+static manager::admission_limits limits(size_t connections,
+    size_t pending_queries, size_t outbound_bytes, bool reject)
+{
+    return { connections, pending_queries, outbound_bytes, reject };
+}
+
+BOOST_AUTO_TEST_CASE(manager__admit__no_limits__admitted)
+{
+    manager instance(false, handle, {}, {});
+    instance.add_connection(make_connection());
+    instance.set_admission_limits(limits(0, 0, 0, false), nullptr);
+    BOOST_REQUIRE(instance.admit());
+}
+
+BOOST_AUTO_TEST_CASE(manager__admit__connection_limit__paused_then_admitted)
+{
+    manager instance(false, handle, {}, {});
+    instance.set_admission_limits(limits(2, 0, 0, false), nullptr);
+
+    // The listener occupies one of the connection slots.
+    const auto listener = make_connection();
+    instance.add_connection(listener);
+    instance.add_connection(make_connection());
+    BOOST_REQUIRE(instance.admit());
+
+    const auto connection = make_connection();
+    instance.add_connection(connection);
+    BOOST_REQUIRE(!instance.admit());
+
+    instance.remove_connection(connection);
+    BOOST_REQUIRE(instance.admit());
+}
+
+BOOST_AUTO_TEST_CASE(manager__admit__pending_query_limit__rejected)
+{
+    manager instance(false, handle, {}, {});
+    size_t pending = 4;
+    instance.set_admission_limits(limits(0, 5, 0, true), [&]()
+    {
+        return pending;
+    });
+
+    BOOST_REQUIRE(instance.admit());
+    pending = 5;
+    BOOST_REQUIRE(!instance.admit());
+    pending = 0;
+    BOOST_REQUIRE(instance.admit());
+}
+
+BOOST_AUTO_TEST_CASE(manager__admit__outbound_byte_limit__paused_until_drained)
+{
+    manager instance(false, handle, {}, {});
+    instance.set_admission_limits(limits(0, 0, 100, false), nullptr);
+
+    const auto first = make_connection();
+    const auto second = make_connection();
+    instance.add_connection(first);
+    instance.add_connection(second);
+
+    BOOST_REQUIRE_EQUAL(first->write(std::string(60, 'a')), 60);
+    BOOST_REQUIRE_EQUAL(instance.outbound_bytes(), 60u);
+    BOOST_REQUIRE(instance.admit());
+
+    // The limit applies to the total across connections.
+    BOOST_REQUIRE_EQUAL(second->write(std::string(40, 'b')), 40);
+    BOOST_REQUIRE_EQUAL(instance.outbound_bytes(), 100u);
+    BOOST_REQUIRE(!instance.admit());
+
+    // A removed connection no longer counts.
+    instance.remove_connection(second);
+    BOOST_REQUIRE_EQUAL(instance.outbound_bytes(), 60u);
+    BOOST_REQUIRE(instance.admit());
+}
+
+BOOST_AUTO_TEST_CASE(manager__outbound_bytes__buffer_changes__tracked)
+{
+    manager instance(false, handle, {}, {});
+    const auto connection = make_connection();
+    BOOST_REQUIRE_EQUAL(connection->write(std::string(10, 'a')), 10);
+
+    // Bytes buffered before the connection is added are counted.
+    instance.add_connection(connection);
+    BOOST_REQUIRE_EQUAL(instance.outbound_bytes(), 10u);
+
+    BOOST_REQUIRE(connection->write_header(protocol_status::ok, "text/plain",
+        0, true) > 0);
+    BOOST_REQUIRE_EQUAL(instance.outbound_bytes(), connection->buffered());
+
+    // A failed write leaves the total unchanged.
+    const auto total = instance.outbound_bytes();
+    BOOST_REQUIRE_EQUAL(connection->write(std::string(3 * 1024 * 1024,
+        'x')), -1);
+    BOOST_REQUIRE_EQUAL(instance.outbound_bytes(), total);
+}
+
+BOOST_AUTO_TEST_CASE(manager__outbound_bytes__held_response__counted)
+{
+    manager instance(false, handle, {}, {});
+    const auto connection = make_connection();
+    instance.add_connection(connection);
+    const auto first = connection->reserve_slot();
+    const auto second = connection->reserve_slot();
+
+    // A response held behind its predecessor is counted until written.
+    BOOST_REQUIRE(connection->write_response(second, std::string(5, 'b')));
+    BOOST_REQUIRE_EQUAL(connection->buffered(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.outbound_bytes(), 5u);
+
+    BOOST_REQUIRE(connection->write_response(first, std::string(3, 'a')));
+    BOOST_REQUIRE_EQUAL(connection->buffered(), 8u);
+    BOOST_REQUIRE_EQUAL(instance.outbound_bytes(), 8u);
+}
+
+BOOST_AUTO_TEST_CASE(manager__broadcast__high_water__dropped_not_closed)
+{
+    manager instance(false, handle, {}, {});
+    const auto slow = make_connection();
+    const auto fast = make_connection();
+    slow->set_websocket(true);
+    fast->set_websocket(true);
+    BOOST_REQUIRE(slow->write(std::string(2 * 1024 * 1024 - 12, 'a')) > 0);
+
+    instance.broadcast({ slow, fast }, "abc");
+    BOOST_REQUIRE_EQUAL(instance.dropped_frames(), 1u);
+    BOOST_REQUIRE_EQUAL(slow->dropped(), 1u);
+    BOOST_REQUIRE_EQUAL(fast->buffered(), 5u);
+    BOOST_REQUIRE(!slow->closed());
+}
+
+BOOST_AUTO_TEST_CASE(manager__destruct__live_connection__detached)
+{
+    const auto connection = make_connection();
+    {
+        manager instance(false, handle, {}, {});
+        instance.add_connection(connection);
+        BOOST_REQUIRE_EQUAL(connection->write(std::string(10, 'a')), 10);
+    }
+
+    // The connection outlives its manager and remains writable.
+    BOOST_REQUIRE_EQUAL(connection->write(std::string(10, 'b')), 10);
+    BOOST_REQUIRE_EQUAL(connection->buffered(), 20u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,171 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <string>
+#include <bitcoin/protocol.hpp>
+
+using namespace bc::protocol::http;
+
+BOOST_AUTO_TEST_SUITE(route_table_tests)
+
+// A distinct handler, which succeeds without a connection.
+static route_table::handler named(const std::string& name)
+{
+    return [name](connection_ptr connection, const http_request&,
+        const route_table::parameter_map&)
+    {
+        return !connection && !name.empty();
+    };
+}
+
+static bool routed(const route_table& instance, const std::string& method,
+    const std::string& path)
+{
+    route_table::parameter_map parameters;
+    std::string allowed;
+    return instance.find(parameters, allowed, method, path) != nullptr;
+}
+
+BOOST_AUTO_TEST_CASE(route_table__find__empty__not_found)
+{
+    const route_table instance;
+    BOOST_REQUIRE(instance.empty());
+    BOOST_REQUIRE(!routed(instance, "get", "/"));
+}
+
+BOOST_AUTO_TEST_CASE(route_table__add__invalid_pattern__false)
+{
+    route_table instance;
+    BOOST_REQUIRE(!instance.add("GET", "", named("a")));
+    BOOST_REQUIRE(!instance.add("GET", "health", named("a")));
+    BOOST_REQUIRE(!instance.add("GET", "/block/:", named("a")));
+    BOOST_REQUIRE(!instance.add("GET", "/block:height", named("a")));
+    BOOST_REQUIRE(!instance.add("GET", "/health", nullptr));
+}
+
+BOOST_AUTO_TEST_CASE(route_table__add__duplicate_method__false)
+{
+    route_table instance;
+    BOOST_REQUIRE(instance.add("GET", "/health", named("a")));
+    BOOST_REQUIRE(!instance.add("get", "/health", named("b")));
+    BOOST_REQUIRE(instance.add("POST", "/health", named("c")));
+}
+
+BOOST_AUTO_TEST_CASE(route_table__add__conflicting_parameter__false)
+{
+    route_table instance;
+    BOOST_REQUIRE(instance.add("GET", "/block/:height", named("a")));
+    BOOST_REQUIRE(!instance.add("GET", "/block/:hash/header", named("b")));
+    BOOST_REQUIRE(instance.add("GET", "/block/:height/header", named("c")));
+}
+
+BOOST_AUTO_TEST_CASE(route_table__find__shared_prefixes__exact_match)
+{
+    route_table instance;
+    BOOST_REQUIRE(instance.add("GET", "/health", named("a")));
+    BOOST_REQUIRE(instance.add("GET", "/headers", named("b")));
+    BOOST_REQUIRE(instance.add("GET", "/head", named("c")));
+    BOOST_REQUIRE(instance.add("GET", "/", named("d")));
+
+    const auto& table = instance;
+    BOOST_REQUIRE(routed(table, "get", "/health"));
+    BOOST_REQUIRE(routed(table, "get", "/headers"));
+    BOOST_REQUIRE(routed(table, "get", "/head"));
+    BOOST_REQUIRE(routed(table, "get", "/"));
+    BOOST_REQUIRE(!routed(table, "get", "/he"));
+    BOOST_REQUIRE(!routed(table, "get", "/header"));
+    BOOST_REQUIRE(!routed(table, "get", "/healthy"));
+    BOOST_REQUIRE(!routed(table, "get", ""));
+}
+
+BOOST_AUTO_TEST_CASE(route_table__find__parameters__captured)
+{
+    route_table instance;
+    BOOST_REQUIRE(instance.add("GET", "/v1/block/:height/tx/:index",
+        named("a")));
+
+    route_table::parameter_map parameters;
+    std::string allowed;
+    BOOST_REQUIRE(instance.find(parameters, allowed, "get",
+        "/v1/block/42/tx/7") != nullptr);
+    BOOST_REQUIRE_EQUAL(parameters.size(), 2u);
+    BOOST_REQUIRE_EQUAL(parameters["height"], "42");
+    BOOST_REQUIRE_EQUAL(parameters["index"], "7");
+
+    BOOST_REQUIRE(!routed(instance, "get", "/v1/block//tx/7"));
+    BOOST_REQUIRE(!routed(instance, "get", "/v1/block/42/tx"));
+    BOOST_REQUIRE(!routed(instance, "get", "/v1/block/42/tx/7/8"));
+}
+
+BOOST_AUTO_TEST_CASE(route_table__find__static_before_parameter__backtracks)
+{
+    route_table instance;
+    BOOST_REQUIRE(instance.add("GET", "/block/latest", named("a")));
+    BOOST_REQUIRE(instance.add("GET", "/block/:height/header", named("b")));
+
+    route_table::parameter_map parameters;
+    std::string allowed;
+    const auto latest = instance.find(parameters, allowed, "get",
+        "/block/latest");
+    BOOST_REQUIRE(latest != nullptr);
+    BOOST_REQUIRE(parameters.empty());
+
+    // The static segment matches but its remainder does not.
+    const auto header = instance.find(parameters, allowed, "get",
+        "/block/latest/header");
+    BOOST_REQUIRE(header != nullptr);
+    BOOST_REQUIRE(header != latest);
+    BOOST_REQUIRE_EQUAL(parameters["height"], "latest");
+}
+
+BOOST_AUTO_TEST_CASE(route_table__find__other_method__allowed)
+{
+    route_table instance;
+    BOOST_REQUIRE(instance.add("GET", "/health", named("a")));
+    BOOST_REQUIRE(instance.add("head", "/health", named("b")));
+
+    route_table::parameter_map parameters;
+    std::string allowed;
+    BOOST_REQUIRE(instance.find(parameters, allowed, "post", "/health") ==
+        nullptr);
+    BOOST_REQUIRE_EQUAL(allowed, "GET, HEAD");
+
+    BOOST_REQUIRE(instance.find(parameters, allowed, "get", "/health") !=
+        nullptr);
+    BOOST_REQUIRE(allowed.empty());
+
+    BOOST_REQUIRE(instance.find(parameters, allowed, "post", "/other") ==
+        nullptr);
+    BOOST_REQUIRE(allowed.empty());
+}
+
+BOOST_AUTO_TEST_CASE(route_table__find__handler__invocable)
+{
+    route_table instance;
+    BOOST_REQUIRE(instance.add("GET", "/health", named("a")));
+
+    route_table::parameter_map parameters;
+    std::string allowed;
+    const auto handler = instance.find(parameters, allowed, "get", "/health");
+    BOOST_REQUIRE(handler != nullptr);
+    BOOST_REQUIRE((*handler)(nullptr, http_request{}, parameters));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
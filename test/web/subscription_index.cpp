@@ -0,0 +1,129 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <bitcoin/protocol.hpp>
+#include "../utility.hpp"
+
+using namespace bc::protocol::http;
+
+BOOST_AUTO_TEST_SUITE(subscription_index_tests)
+
+static bool contains(const connection_list& list, connection_ptr connection)
+{
+    return std::find(list.begin(), list.end(), connection) != list.end();
+}
+
+BOOST_AUTO_TEST_CASE(subscription_index__subscribers__unknown_topic__empty)
+{
+    subscription_index instance;
+    BOOST_REQUIRE(instance.subscribers("headers").empty());
+    BOOST_REQUIRE_EQUAL(instance.topics(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(subscription_index__subscribe__topics__only_matching)
+{
+    subscription_index instance;
+    const auto first = std::make_shared<closing_connection>();
+    const auto second = std::make_shared<closing_connection>();
+
+    BOOST_REQUIRE(instance.subscribe(first, "address:aa"));
+    BOOST_REQUIRE(instance.subscribe(second, "address:bb"));
+    BOOST_REQUIRE(instance.subscribe(second, "headers"));
+    BOOST_REQUIRE(instance.subscribe(first, "headers"));
+    BOOST_REQUIRE_EQUAL(instance.topics(), 3u);
+
+    const auto aa = instance.subscribers("address:aa");
+    BOOST_REQUIRE_EQUAL(aa.size(), 1u);
+    BOOST_REQUIRE(contains(aa, first));
+
+    const auto headers = instance.subscribers("headers");
+    BOOST_REQUIRE_EQUAL(headers.size(), 2u);
+    BOOST_REQUIRE(contains(headers, first));
+    BOOST_REQUIRE(contains(headers, second));
+}
+
+BOOST_AUTO_TEST_CASE(subscription_index__subscribe__repeated__single)
+{
+    subscription_index instance;
+    const auto subscriber = std::make_shared<closing_connection>();
+    BOOST_REQUIRE(instance.subscribe(subscriber, "headers"));
+    BOOST_REQUIRE(instance.subscribe(subscriber, "headers"));
+    BOOST_REQUIRE_EQUAL(instance.subscribers("headers").size(), 1u);
+    BOOST_REQUIRE_EQUAL(instance.topics(subscriber), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(subscription_index__subscribe__invalid_topic__false)
+{
+    subscription_index instance;
+    const auto subscriber = std::make_shared<closing_connection>();
+    BOOST_REQUIRE(!instance.subscribe(subscriber, ""));
+    BOOST_REQUIRE(!instance.subscribe(subscriber, std::string(
+        subscription_index::maximum_topic_length + 1, 'x')));
+    BOOST_REQUIRE(!instance.subscribe(nullptr, "headers"));
+    BOOST_REQUIRE_EQUAL(instance.topics(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(subscription_index__subscribe__over_limit__false)
+{
+    subscription_index instance(2);
+    const auto subscriber = std::make_shared<closing_connection>();
+    BOOST_REQUIRE(instance.subscribe(subscriber, "a"));
+    BOOST_REQUIRE(instance.subscribe(subscriber, "b"));
+    BOOST_REQUIRE(!instance.subscribe(subscriber, "c"));
+    BOOST_REQUIRE(instance.subscribers("c").empty());
+    BOOST_REQUIRE_EQUAL(instance.topics(subscriber), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(subscription_index__unsubscribe__subscribed__removed)
+{
+    subscription_index instance;
+    const auto subscriber = std::make_shared<closing_connection>();
+    BOOST_REQUIRE(!instance.unsubscribe(subscriber, "headers"));
+    BOOST_REQUIRE(instance.subscribe(subscriber, "headers"));
+    BOOST_REQUIRE(instance.unsubscribe(subscriber, "headers"));
+    BOOST_REQUIRE(!instance.unsubscribe(subscriber, "headers"));
+    BOOST_REQUIRE(instance.subscribers("headers").empty());
+    BOOST_REQUIRE_EQUAL(instance.topics(), 0u);
+    BOOST_REQUIRE_EQUAL(instance.topics(subscriber), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(subscription_index__remove__connection__all_topics)
+{
+    subscription_index instance;
+    const auto first = std::make_shared<closing_connection>();
+    const auto second = std::make_shared<closing_connection>();
+    BOOST_REQUIRE(instance.subscribe(first, "a"));
+    BOOST_REQUIRE(instance.subscribe(first, "b"));
+    BOOST_REQUIRE(instance.subscribe(second, "b"));
+
+    instance.remove(first);
+    BOOST_REQUIRE_EQUAL(instance.topics(first), 0u);
+    BOOST_REQUIRE(instance.subscribers("a").empty());
+    BOOST_REQUIRE_EQUAL(instance.topics(), 1u);
+
+    const auto b = instance.subscribers("b");
+    BOOST_REQUIRE_EQUAL(b.size(), 1u);
+    BOOST_REQUIRE(contains(b, second));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
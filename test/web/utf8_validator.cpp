@@ -0,0 +1,222 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include <bitcoin/protocol.hpp>
+
+using namespace bc::protocol::http;
+
+BOOST_AUTO_TEST_SUITE(utf8_validator_tests)
+
+static const std::vector<utf8_validator::kernel> kernels
+{
+    utf8_validator::kernel::scalar,
+    utf8_validator::kernel::sse2,
+    utf8_validator::kernel::avx2,
+    utf8_validator::kernel::neon
+};
+
+static bool validate(utf8_validator::kernel type, const std::string& text)
+{
+    return utf8_validator::validate(type,
+        reinterpret_cast<const uint8_t*>(text.data()), text.size());
+}
+
+// The reference (code point at a time) validation.
+static bool reference(const std::vector<uint8_t>& data)
+{
+    for (size_t index = 0; index < data.size();)
+    {
+        const auto lead = data[index];
+        const size_t length = lead < 0x80 ? 1 : lead < 0xc0 ? 0 :
+            lead < 0xe0 ? 2 : lead < 0xf0 ? 3 : lead < 0xf8 ? 4 : 0;
+
+        if (length == 0 || data.size() - index < length)
+            return false;
+
+        uint32_t point = length == 1 ? lead : lead & (0xff >> (length + 1));
+        for (size_t next = 1; next < length; ++next)
+        {
+            if ((data[index + next] & 0xc0) != 0x80)
+                return false;
+
+            point = (point << 6) | (data[index + next] & 0x3f);
+        }
+
+        static const uint32_t minimum[]{ 0, 0, 0x80, 0x800, 0x10000 };
+        if (point < minimum[length] || point > 0x10ffff ||
+            (point >= 0xd800 && point <= 0xdfff))
+            return false;
+
+        index += length;
+    }
+
+    return true;
+}
+
+// Text with every length of character, longer than a vector.
+static std::string mixed(size_t repeat)
+{
+    std::string out;
+    for (size_t index = 0; index < repeat; ++index)
+        out += "ascii \xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80 \xed\x9f\xbf "
+            "\xf4\x8f\xbf\xbf";
+
+    return out;
+}
+
+BOOST_AUTO_TEST_CASE(utf8_validator__best__supported)
+{
+    BOOST_REQUIRE(utf8_validator::supported(utf8_validator::kernel::scalar));
+    BOOST_REQUIRE(utf8_validator::supported(utf8_validator::best()));
+}
+
+BOOST_AUTO_TEST_CASE(utf8_validator__validate__valid__true)
+{
+    for (const auto type: kernels)
+    {
+        if (!utf8_validator::supported(type))
+            continue;
+
+        BOOST_REQUIRE(validate(type, ""));
+        BOOST_REQUIRE(validate(type, std::string(1000, 'a')));
+        BOOST_REQUIRE(validate(type, mixed(1)));
+        BOOST_REQUIRE(validate(type, mixed(100)));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(utf8_validator__validate__invalid__false)
+{
+    static const std::vector<std::string> invalid
+    {
+        // Lone continuation, overlong two, three and four byte encodings.
+        "\x80", "\xc0\xaf", "\xc1\xbf", "\xe0\x9f\xbf", "\xf0\x8f\xbf\xbf",
+
+        // Surrogate, above U+10FFFF, invalid leads, truncated characters.
+        "\xed\xa0\x80", "\xf4\x90\x80\x80", "\xf5\x80\x80\x80", "\xff",
+        "\xc3", "\xe2\x82", "\xf0\x9f\x98", "\xe2\x82\x41"
+    };
+
+    for (const auto type: kernels)
+    {
+        if (!utf8_validator::supported(type))
+            continue;
+
+        for (const auto& text: invalid)
+        {
+            // Alone, and at each position of a text longer than a vector.
+            BOOST_REQUIRE(!validate(type, text));
+            for (size_t position = 0; position < 70; ++position)
+            {
+                const auto padded = std::string(position, 'a') + text +
+                    std::string(70 - position, 'b');
+                BOOST_REQUIRE_MESSAGE(!validate(type, padded),
+                    utf8_validator::to_string(type) << " " << position);
+
+                // A truncated character at the end is invalid.
+                BOOST_REQUIRE(!validate(type, mixed(3) +
+                    std::string(position, 'a') + "\xf0\x9f"));
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(utf8_validator__validate__random__reference)
+{
+    std::mt19937 random(42);
+    const auto text = mixed(10);
+
+    for (size_t round = 0; round < 2000; ++round)
+    {
+        // A valid text with up to two bytes changed.
+        const auto size = random() % text.size();
+        std::vector<uint8_t> data(text.begin(), text.begin() + size);
+        for (size_t change = random() % 3; change != 0 && size != 0; --change)
+            data[random() % size] = static_cast<uint8_t>(random());
+
+        const auto expected = reference(data);
+        for (const auto type: kernels)
+        {
+            if (!utf8_validator::supported(type))
+                continue;
+
+            BOOST_REQUIRE_EQUAL(utf8_validator::validate(type, data.data(),
+                data.size()), expected);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(utf8_validator__update__split_characters__complete)
+{
+    const auto text = mixed(5);
+    const auto data = reinterpret_cast<const uint8_t*>(text.data());
+
+    // Every split of the text into two parts.
+    for (size_t split = 0; split <= text.size(); ++split)
+    {
+        utf8_validator instance;
+        BOOST_REQUIRE(instance.update(data, split));
+        BOOST_REQUIRE(instance.update(data + split, text.size() - split));
+        BOOST_REQUIRE(instance.complete());
+    }
+
+    // A byte at a time.
+    utf8_validator instance;
+    for (size_t index = 0; index < text.size(); ++index)
+        BOOST_REQUIRE(instance.update(data + index, 1));
+
+    BOOST_REQUIRE(instance.complete());
+}
+
+BOOST_AUTO_TEST_CASE(utf8_validator__update__partial_character__incomplete)
+{
+    utf8_validator instance;
+    const uint8_t data[]{ 'a', 0xe2, 0x82 };
+    BOOST_REQUIRE(instance.update(data, sizeof(data)));
+    BOOST_REQUIRE(!instance.complete());
+
+    const uint8_t rest[]{ 0xac };
+    BOOST_REQUIRE(instance.update(rest, sizeof(rest)));
+    BOOST_REQUIRE(instance.complete());
+}
+
+BOOST_AUTO_TEST_CASE(utf8_validator__update__invalid_split_character__false)
+{
+    utf8_validator instance;
+    const uint8_t data[]{ 'a', 0xe0 };
+    BOOST_REQUIRE(instance.update(data, sizeof(data)));
+
+    // An overlong three byte encoding, only known once completed.
+    const uint8_t rest[]{ 0x80, 0x80, 'b' };
+    BOOST_REQUIRE(!instance.update(rest, sizeof(rest)));
+    BOOST_REQUIRE(!instance.complete());
+
+    // Invalid until reset.
+    BOOST_REQUIRE(!instance.update(data, 1));
+    instance.reset();
+    BOOST_REQUIRE(instance.update(data, 1));
+    BOOST_REQUIRE(instance.complete());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
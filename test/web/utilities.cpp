@@ -0,0 +1,158 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <string>
+#include <bitcoin/protocol.hpp>
+
+using namespace bc::system;
+using namespace bc::protocol::http;
+
+BOOST_AUTO_TEST_SUITE(utilities_tests)
+
+// accepts_encoding
+
+BOOST_AUTO_TEST_CASE(utilities__accepts_encoding__listed__true)
+{
+    BOOST_REQUIRE(accepts_encoding("gzip, deflate, br", "gzip"));
+    BOOST_REQUIRE(accepts_encoding("deflate, GZIP;q=0.5", "gzip"));
+    BOOST_REQUIRE(accepts_encoding("*", "gzip"));
+}
+
+BOOST_AUTO_TEST_CASE(utilities__accepts_encoding__absent_or_refused__false)
+{
+    BOOST_REQUIRE(!accepts_encoding("", "gzip"));
+    BOOST_REQUIRE(!accepts_encoding("deflate, br", "gzip"));
+    BOOST_REQUIRE(!accepts_encoding("gzip;q=0", "gzip"));
+    BOOST_REQUIRE(!accepts_encoding("gzip; q=0.000, *", "gzip"));
+    BOOST_REQUIRE(!accepts_encoding("*;q=0", "gzip"));
+}
+
+BOOST_AUTO_TEST_CASE(utilities__accepts_encoding__explicit_overrides_wildcard__expected)
+{
+    BOOST_REQUIRE(accepts_encoding("*;q=0, gzip", "gzip"));
+    BOOST_REQUIRE(!accepts_encoding("*;q=0, gzip", "br"));
+}
+
+// parse_ranges
+
+BOOST_AUTO_TEST_CASE(utilities__parse_ranges__single__expected)
+{
+    byte_range_list ranges;
+    BOOST_REQUIRE(parse_ranges(ranges, "bytes=0-499", 10000));
+    BOOST_REQUIRE_EQUAL(ranges.size(), 1u);
+    BOOST_REQUIRE_EQUAL(ranges[0].offset, 0u);
+    BOOST_REQUIRE_EQUAL(ranges[0].length, 500u);
+}
+
+BOOST_AUTO_TEST_CASE(utilities__parse_ranges__open_ended__to_end)
+{
+    byte_range_list ranges;
+    BOOST_REQUIRE(parse_ranges(ranges, "bytes=9500-", 10000));
+    BOOST_REQUIRE_EQUAL(ranges.size(), 1u);
+    BOOST_REQUIRE_EQUAL(ranges[0].offset, 9500u);
+    BOOST_REQUIRE_EQUAL(ranges[0].length, 500u);
+}
+
+BOOST_AUTO_TEST_CASE(utilities__parse_ranges__suffix__final_bytes)
+{
+    byte_range_list ranges;
+    BOOST_REQUIRE(parse_ranges(ranges, "bytes=-500", 10000));
+    BOOST_REQUIRE_EQUAL(ranges.size(), 1u);
+    BOOST_REQUIRE_EQUAL(ranges[0].offset, 9500u);
+    BOOST_REQUIRE_EQUAL(ranges[0].length, 500u);
+}
+
+BOOST_AUTO_TEST_CASE(utilities__parse_ranges__suffix_exceeds_size__whole)
+{
+    byte_range_list ranges;
+    BOOST_REQUIRE(parse_ranges(ranges, "bytes=-500", 100));
+    BOOST_REQUIRE_EQUAL(ranges.size(), 1u);
+    BOOST_REQUIRE_EQUAL(ranges[0].offset, 0u);
+    BOOST_REQUIRE_EQUAL(ranges[0].length, 100u);
+}
+
+BOOST_AUTO_TEST_CASE(utilities__parse_ranges__last_exceeds_size__truncated)
+{
+    byte_range_list ranges;
+    BOOST_REQUIRE(parse_ranges(ranges, "bytes=50-5000", 100));
+    BOOST_REQUIRE_EQUAL(ranges.size(), 1u);
+    BOOST_REQUIRE_EQUAL(ranges[0].offset, 50u);
+    BOOST_REQUIRE_EQUAL(ranges[0].length, 50u);
+}
+
+BOOST_AUTO_TEST_CASE(utilities__parse_ranges__multiple__request_order)
+{
+    byte_range_list ranges;
+    BOOST_REQUIRE(parse_ranges(ranges, "bytes=500-999, 0-99,,-10", 1000));
+    BOOST_REQUIRE_EQUAL(ranges.size(), 3u);
+    BOOST_REQUIRE_EQUAL(ranges[0].offset, 500u);
+    BOOST_REQUIRE_EQUAL(ranges[0].length, 500u);
+    BOOST_REQUIRE_EQUAL(ranges[1].offset, 0u);
+    BOOST_REQUIRE_EQUAL(ranges[1].length, 100u);
+    BOOST_REQUIRE_EQUAL(ranges[2].offset, 990u);
+    BOOST_REQUIRE_EQUAL(ranges[2].length, 10u);
+}
+
+BOOST_AUTO_TEST_CASE(utilities__parse_ranges__unsatisfiable__empty)
+{
+    byte_range_list ranges;
+    BOOST_REQUIRE(parse_ranges(ranges, "bytes=1000-", 1000));
+    BOOST_REQUIRE(ranges.empty());
+    BOOST_REQUIRE(parse_ranges(ranges, "bytes=-0", 1000));
+    BOOST_REQUIRE(ranges.empty());
+    BOOST_REQUIRE(parse_ranges(ranges, "bytes=0-0", 0));
+    BOOST_REQUIRE(ranges.empty());
+}
+
+BOOST_AUTO_TEST_CASE(utilities__parse_ranges__partially_satisfiable__satisfiable_only)
+{
+    byte_range_list ranges;
+    BOOST_REQUIRE(parse_ranges(ranges, "bytes=2000-3000,0-0", 1000));
+    BOOST_REQUIRE_EQUAL(ranges.size(), 1u);
+    BOOST_REQUIRE_EQUAL(ranges[0].offset, 0u);
+    BOOST_REQUIRE_EQUAL(ranges[0].length, 1u);
+}
+
+BOOST_AUTO_TEST_CASE(utilities__parse_ranges__invalid__false)
+{
+    byte_range_list ranges;
+    BOOST_REQUIRE(!parse_ranges(ranges, "", 1000));
+    BOOST_REQUIRE(!parse_ranges(ranges, "items=0-1", 1000));
+    BOOST_REQUIRE(!parse_ranges(ranges, "bytes=", 1000));
+    BOOST_REQUIRE(!parse_ranges(ranges, "bytes=5", 1000));
+    BOOST_REQUIRE(!parse_ranges(ranges, "bytes=5-1", 1000));
+    BOOST_REQUIRE(!parse_ranges(ranges, "bytes=-", 1000));
+    BOOST_REQUIRE(!parse_ranges(ranges, "bytes=a-b", 1000));
+    BOOST_REQUIRE(!parse_ranges(ranges, "bytes=+1-2", 1000));
+    BOOST_REQUIRE(!parse_ranges(ranges,
+        "bytes=0-99999999999999999999999999", 1000));
+}
+
+BOOST_AUTO_TEST_CASE(utilities__parse_ranges__too_many__false)
+{
+    std::string header = "bytes=0-0";
+    for (size_t index = 1; index < 17; ++index)
+        header += "," + std::to_string(index) + "-" + std::to_string(index);
+
+    byte_range_list ranges;
+    BOOST_REQUIRE(!parse_ranges(ranges, header, 1000));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,146 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <string>
+#include <bitcoin/protocol.hpp>
+
+using namespace bc::protocol::http;
+
+BOOST_AUTO_TEST_SUITE(websocket_assembler_tests)
+
+typedef websocket_assembler::result result;
+
+static const uint8_t final_text = 0x81;
+static const uint8_t text = 0x01;
+static const uint8_t continuation = 0x00;
+static const uint8_t final_continuation = 0x80;
+static const size_t limit = 16;
+
+static result append(websocket_assembler& instance, buffer_pool& pool,
+    uint8_t flags, const std::string& payload, size_t maximum=limit)
+{
+    return instance.append(pool, flags,
+        reinterpret_cast<const uint8_t*>(payload.data()), payload.size(),
+        maximum);
+}
+
+static std::string message(const websocket_assembler& instance)
+{
+    const auto& data = instance.message();
+    return { data.begin(), data.end() };
+}
+
+BOOST_AUTO_TEST_CASE(websocket_assembler__append__unfragmented__single)
+{
+    buffer_pool pool;
+    websocket_assembler instance;
+    BOOST_REQUIRE(append(instance, pool, final_text, "abc") == result::single);
+    BOOST_REQUIRE(!instance.in_progress());
+    BOOST_REQUIRE(instance.message().empty());
+}
+
+BOOST_AUTO_TEST_CASE(websocket_assembler__append__fragments__complete)
+{
+    buffer_pool pool;
+    websocket_assembler instance;
+    BOOST_REQUIRE(append(instance, pool, text, "ab") == result::incomplete);
+    BOOST_REQUIRE(instance.in_progress());
+    BOOST_REQUIRE(append(instance, pool, continuation, "") ==
+        result::incomplete);
+    BOOST_REQUIRE(append(instance, pool, continuation, "cd") ==
+        result::incomplete);
+    BOOST_REQUIRE(append(instance, pool, final_continuation, "e") ==
+        result::complete);
+
+    BOOST_REQUIRE(!instance.in_progress());
+    BOOST_REQUIRE_EQUAL(message(instance), "abcde");
+    BOOST_REQUIRE(instance.code() == websocket_op::text);
+    BOOST_REQUIRE_EQUAL(instance.flags(), final_text);
+}
+
+BOOST_AUTO_TEST_CASE(websocket_assembler__reset__complete__buffer_pooled)
+{
+    buffer_pool pool;
+    websocket_assembler instance;
+    BOOST_REQUIRE(append(instance, pool, text, "ab") == result::incomplete);
+    BOOST_REQUIRE(append(instance, pool, final_continuation, "c") ==
+        result::complete);
+
+    instance.reset(pool);
+    BOOST_REQUIRE_EQUAL(pool.size(), 1u);
+    BOOST_REQUIRE(instance.message().empty());
+
+    // The next message takes the pooled buffer.
+    BOOST_REQUIRE(append(instance, pool, text, "x") == result::incomplete);
+    BOOST_REQUIRE_EQUAL(pool.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(websocket_assembler__append__continuation_without_message__invalid)
+{
+    buffer_pool pool;
+    websocket_assembler instance;
+    BOOST_REQUIRE(append(instance, pool, continuation, "a") ==
+        result::invalid);
+    BOOST_REQUIRE(append(instance, pool, final_continuation, "a") ==
+        result::invalid);
+}
+
+BOOST_AUTO_TEST_CASE(websocket_assembler__append__new_message_in_progress__invalid)
+{
+    buffer_pool pool;
+    websocket_assembler instance;
+    BOOST_REQUIRE(append(instance, pool, text, "a") == result::incomplete);
+    BOOST_REQUIRE(append(instance, pool, final_text, "b") == result::invalid);
+}
+
+BOOST_AUTO_TEST_CASE(websocket_assembler__append__after_complete__next_message)
+{
+    buffer_pool pool;
+    websocket_assembler instance;
+    BOOST_REQUIRE(append(instance, pool, text, "a") == result::incomplete);
+    BOOST_REQUIRE(append(instance, pool, final_continuation, "b") ==
+        result::complete);
+    BOOST_REQUIRE(append(instance, pool, final_text, "c") == result::single);
+    BOOST_REQUIRE(append(instance, pool, continuation, "d") ==
+        result::invalid);
+}
+
+BOOST_AUTO_TEST_CASE(websocket_assembler__append__over_limit__oversized)
+{
+    buffer_pool pool;
+    websocket_assembler instance;
+    const std::string half(limit / 2, 'x');
+    BOOST_REQUIRE(append(instance, pool, text, half) == result::incomplete);
+    BOOST_REQUIRE(append(instance, pool, continuation, half) ==
+        result::incomplete);
+    BOOST_REQUIRE(append(instance, pool, final_continuation, "y") ==
+        result::oversized);
+}
+
+BOOST_AUTO_TEST_CASE(websocket_assembler__append__unfragmented_over_limit__oversized)
+{
+    buffer_pool pool;
+    websocket_assembler instance;
+    const std::string payload(limit + 1, 'x');
+    BOOST_REQUIRE(append(instance, pool, final_text, payload) ==
+        result::oversized);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,322 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <bitcoin/protocol.hpp>
+
+using namespace bc::system;
+using namespace bc::protocol::http;
+
+BOOST_AUTO_TEST_SUITE(websocket_decoder_tests)
+
+static const uint8_t mask[4]{ 0x37, 0xfa, 0x21, 0x3d };
+
+// A client frame of the text, masked as the client sends it.
+static data_chunk client_frame(const std::string& text,
+    websocket_op code=websocket_op::text, bool final=true)
+{
+    auto out = websocket_frame::to_header(text.size(), code);
+    out[0] = static_cast<uint8_t>(final ? out[0] : out[0] & 0x7f);
+    out[1] |= 0x80;
+    out.insert(out.end(), mask, mask + sizeof(mask));
+
+    for (size_t index = 0; index < text.size(); ++index)
+        out.push_back(static_cast<uint8_t>(text[index]) ^ mask[index % 4]);
+
+    return out;
+}
+
+static data_chunk join(const data_chunk& left, const data_chunk& right)
+{
+    auto out = left;
+    out.insert(out.end(), right.begin(), right.end());
+    return out;
+}
+
+struct collector
+{
+    bool operator()(const websocket_frame& frame, uint8_t* payload)
+    {
+        messages.emplace_back(payload, payload + frame.data_length());
+        return accept;
+    }
+
+    bool accept = true;
+    std::vector<std::string> messages;
+};
+
+BOOST_AUTO_TEST_CASE(websocket_decoder__decode__two_frames__both_decoded)
+{
+    websocket_decoder decoder;
+    collector handler;
+    auto input = join(client_frame("hello"), client_frame("world"));
+    const auto result = decoder.decode(input, 1024, std::ref(handler));
+    BOOST_REQUIRE(result == websocket_decoder::result::incomplete);
+    BOOST_REQUIRE_EQUAL(handler.messages.size(), 2u);
+    BOOST_REQUIRE_EQUAL(handler.messages[0], "hello");
+    BOOST_REQUIRE_EQUAL(handler.messages[1], "world");
+    BOOST_REQUIRE(input.empty());
+}
+
+BOOST_AUTO_TEST_CASE(websocket_decoder__decode__split_header__resumed)
+{
+    websocket_decoder decoder;
+    collector handler;
+    const auto frame = client_frame("split header");
+    data_chunk input(frame.begin(), frame.begin() + 3);
+    auto result = decoder.decode(input, 1024, std::ref(handler));
+    BOOST_REQUIRE(result == websocket_decoder::result::incomplete);
+    BOOST_REQUIRE(handler.messages.empty());
+    BOOST_REQUIRE_EQUAL(input.size(), 3u);
+
+    input.insert(input.end(), frame.begin() + 3, frame.end());
+    result = decoder.decode(input, 1024, std::ref(handler));
+    BOOST_REQUIRE(result == websocket_decoder::result::incomplete);
+    BOOST_REQUIRE_EQUAL(handler.messages.size(), 1u);
+    BOOST_REQUIRE_EQUAL(handler.messages[0], "split header");
+    BOOST_REQUIRE(input.empty());
+}
+
+BOOST_AUTO_TEST_CASE(websocket_decoder__decode__split_payload__unmasked_once)
+{
+    websocket_decoder decoder;
+    collector handler;
+    const std::string text(300, 'x');
+    const auto frame = join(client_frame(text), client_frame("next"));
+    data_chunk input;
+
+    // Feed a byte at a time across unaligned payload offsets.
+    for (size_t index = 0; index < frame.size(); ++index)
+    {
+        input.push_back(frame[index]);
+        const auto result = decoder.decode(input, 1024, std::ref(handler));
+        BOOST_REQUIRE(result == websocket_decoder::result::incomplete);
+    }
+
+    BOOST_REQUIRE_EQUAL(handler.messages.size(), 2u);
+    BOOST_REQUIRE_EQUAL(handler.messages[0], text);
+    BOOST_REQUIRE_EQUAL(handler.messages[1], "next");
+    BOOST_REQUIRE(input.empty());
+}
+
+BOOST_AUTO_TEST_CASE(websocket_decoder__decode__partial_frame__remainder_kept)
+{
+    websocket_decoder decoder;
+    collector handler;
+    const auto second = client_frame("second");
+    auto input = join(client_frame("first"), second);
+    input.resize(input.size() - 2);
+    const auto result = decoder.decode(input, 1024, std::ref(handler));
+    BOOST_REQUIRE(result == websocket_decoder::result::incomplete);
+    BOOST_REQUIRE_EQUAL(handler.messages.size(), 1u);
+    BOOST_REQUIRE_EQUAL(input.size(), second.size() - 2);
+}
+
+BOOST_AUTO_TEST_CASE(websocket_decoder__decode__oversized__oversized)
+{
+    websocket_decoder decoder;
+    collector handler;
+    auto input = client_frame("too long");
+    const auto result = decoder.decode(input, 4, std::ref(handler));
+    BOOST_REQUIRE(result == websocket_decoder::result::oversized);
+    BOOST_REQUIRE(handler.messages.empty());
+}
+
+BOOST_AUTO_TEST_CASE(websocket_decoder__decode__unmasked__invalid)
+{
+    websocket_decoder decoder;
+    collector handler;
+    auto input = websocket_frame::to_header(2, websocket_op::text);
+    input.push_back('h');
+    input.push_back('i');
+    const auto result = decoder.decode(input, 1024, std::ref(handler));
+    BOOST_REQUIRE(result == websocket_decoder::result::invalid);
+    BOOST_REQUIRE(handler.messages.empty());
+}
+
+BOOST_AUTO_TEST_CASE(websocket_decoder__decode__fragmented_control__invalid)
+{
+    websocket_decoder decoder;
+    collector handler;
+    auto input = client_frame("ping", websocket_op::ping, false);
+    const auto result = decoder.decode(input, 1024, std::ref(handler));
+    BOOST_REQUIRE(result == websocket_decoder::result::invalid);
+}
+
+BOOST_AUTO_TEST_CASE(websocket_decoder__decode__oversized_control__invalid)
+{
+    websocket_decoder decoder;
+    collector handler;
+    auto input = client_frame(std::string(126, 'p'), websocket_op::ping);
+    const auto result = decoder.decode(input, 1024, std::ref(handler));
+    BOOST_REQUIRE(result == websocket_decoder::result::invalid);
+}
+
+BOOST_AUTO_TEST_CASE(websocket_decoder__decode__handler_false__stopped)
+{
+    websocket_decoder decoder;
+    collector handler;
+    handler.accept = false;
+    const auto second = client_frame("second");
+    auto input = join(client_frame("first"), second);
+    const auto result = decoder.decode(input, 1024, std::ref(handler));
+    BOOST_REQUIRE(result == websocket_decoder::result::stopped);
+    BOOST_REQUIRE_EQUAL(handler.messages.size(), 1u);
+    BOOST_REQUIRE_EQUAL(input.size(), second.size());
+}
+
+BOOST_AUTO_TEST_CASE(websocket_decoder__decode__invalid_text__invalid_text)
+{
+    websocket_decoder decoder;
+    collector handler;
+    auto input = client_frame("bad \xc0\xaf text");
+    const auto result = decoder.decode(input, 1024, std::ref(handler));
+    BOOST_REQUIRE(result == websocket_decoder::result::invalid_text);
+    BOOST_REQUIRE(handler.messages.empty());
+}
+
+BOOST_AUTO_TEST_CASE(websocket_decoder__decode__invalid_binary__delivered)
+{
+    websocket_decoder decoder;
+    collector handler;
+    auto input = client_frame("\xc0\xaf", websocket_op::binary);
+    const auto result = decoder.decode(input, 1024, std::ref(handler));
+    BOOST_REQUIRE(result == websocket_decoder::result::incomplete);
+    BOOST_REQUIRE_EQUAL(handler.messages.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(websocket_decoder__decode__invalid_text_partial_payload__failed_early)
+{
+    websocket_decoder decoder;
+    collector handler;
+    auto input = client_frame("\xff" + std::string(100, 'x'));
+    input.resize(input.size() - 50);
+    const auto result = decoder.decode(input, 1024, std::ref(handler));
+    BOOST_REQUIRE(result == websocket_decoder::result::invalid_text);
+}
+
+BOOST_AUTO_TEST_CASE(websocket_decoder__decode__character_split_across_fragments__valid)
+{
+    websocket_decoder decoder;
+    collector handler;
+
+    // The euro sign split between a text frame and its continuation, with a
+    // ping between them.
+    auto input = join(join(client_frame("a\xe2\x82", websocket_op::text, false),
+        client_frame("", websocket_op::ping)),
+        client_frame("\xac", websocket_op::continuation));
+
+    // A byte at a time, to split the character across reads as well.
+    data_chunk buffer;
+    for (const auto byte: input)
+    {
+        buffer.push_back(byte);
+        const auto result = decoder.decode(buffer, 1024, std::ref(handler));
+        BOOST_REQUIRE(result == websocket_decoder::result::incomplete);
+    }
+
+    BOOST_REQUIRE_EQUAL(handler.messages.size(), 3u);
+}
+
+BOOST_AUTO_TEST_CASE(websocket_decoder__decode__text_ends_within_character__invalid_text)
+{
+    websocket_decoder decoder;
+    collector handler;
+    auto input = join(client_frame("a\xe2\x82", websocket_op::text, false),
+        client_frame("b", websocket_op::continuation));
+    const auto result = decoder.decode(input, 1024, std::ref(handler));
+    BOOST_REQUIRE(result == websocket_decoder::result::invalid_text);
+    BOOST_REQUIRE_EQUAL(handler.messages.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(websocket_decoder__decode__final_text_incomplete_character__invalid_text)
+{
+    websocket_decoder decoder;
+    collector handler;
+    auto input = client_frame("a\xe2\x82");
+    const auto result = decoder.decode(input, 1024, std::ref(handler));
+    BOOST_REQUIRE(result == websocket_decoder::result::invalid_text);
+}
+
+BOOST_AUTO_TEST_CASE(websocket_decoder__decode__compressed_text__not_validated)
+{
+    websocket_decoder decoder;
+    collector handler;
+    auto input = client_frame("\xc0\xaf");
+    input[0] |= 0x40;
+    const auto result = decoder.decode(input, 1024, std::ref(handler));
+    BOOST_REQUIRE(result == websocket_decoder::result::incomplete);
+    BOOST_REQUIRE_EQUAL(handler.messages.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(websocket_decoder__decode__large_text__valid)
+{
+    websocket_decoder decoder;
+    collector handler;
+    std::string text;
+    while (text.size() < 10000)
+        text += "\xf0\x9f\x98\x80 \xc3\xa9";
+
+    auto input = client_frame(text);
+    const auto result = decoder.decode(input, 20000, std::ref(handler));
+    BOOST_REQUIRE(result == websocket_decoder::result::incomplete);
+    BOOST_REQUIRE_EQUAL(handler.messages.size(), 1u);
+    BOOST_REQUIRE_EQUAL(handler.messages[0], text);
+}
+
+BOOST_AUTO_TEST_CASE(websocket_decoder__reset__partial_payload__restarts)
+{
+    websocket_decoder decoder;
+    collector handler;
+    const auto frame = client_frame("abcdef");
+    data_chunk input(frame.begin(), frame.end() - 3);
+    decoder.decode(input, 1024, std::ref(handler));
+    decoder.reset();
+
+    // A new connection's frame is unmasked from its start.
+    input = frame;
+    decoder.decode(input, 1024, std::ref(handler));
+    BOOST_REQUIRE_EQUAL(handler.messages.size(), 1u);
+    BOOST_REQUIRE_EQUAL(handler.messages[0], "abcdef");
+}
+
+BOOST_AUTO_TEST_CASE(websocket_frame__to_header__65535__two_byte_length)
+{
+    const auto header = websocket_frame::to_header(65535, websocket_op::binary);
+    BOOST_REQUIRE_EQUAL(header.size(), 4u);
+    BOOST_REQUIRE_EQUAL(header[1], 126u);
+}
+
+BOOST_AUTO_TEST_CASE(websocket_frame__construct__partial_extended_length__incomplete)
+{
+    const auto frame = client_frame(std::string(200, 'z'));
+    const websocket_frame partial(frame.data(), 3);
+    BOOST_REQUIRE(!partial.complete());
+
+    const websocket_frame whole(frame.data(), 8);
+    BOOST_REQUIRE(whole.complete());
+    BOOST_REQUIRE_EQUAL(whole.header_length(), 8u);
+    BOOST_REQUIRE_EQUAL(whole.data_length(), 200u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,238 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <string>
+#include <bitcoin/protocol.hpp>
+
+using namespace bc::system;
+using namespace bc::protocol::http;
+
+BOOST_AUTO_TEST_SUITE(websocket_deflate_tests)
+
+typedef websocket_deflate::parameters parameters;
+
+static parameters negotiate(const websocket_deflate& instance,
+    const std::string& offers, bool expected=true)
+{
+    parameters agreed{};
+    BOOST_REQUIRE_EQUAL(instance.negotiate(agreed, offers), expected);
+    return agreed;
+}
+
+BOOST_AUTO_TEST_CASE(websocket_deflate__negotiate__disabled__false)
+{
+    const websocket_deflate instance;
+    BOOST_REQUIRE(!instance.enabled());
+    negotiate(instance, "permessage-deflate", false);
+}
+
+BOOST_AUTO_TEST_CASE(websocket_deflate__negotiate__no_offer__false)
+{
+    const websocket_deflate instance(6);
+    negotiate(instance, "", false);
+    negotiate(instance, "x-webkit-deflate-frame", false);
+}
+
+BOOST_AUTO_TEST_CASE(websocket_deflate__negotiate__plain_offer__no_context_takeover)
+{
+    const websocket_deflate instance(6);
+    if (!websocket_deflate::available())
+        return;
+
+    const auto agreed = negotiate(instance, "permessage-deflate");
+    BOOST_REQUIRE(agreed.enabled);
+    BOOST_REQUIRE(agreed.server_no_context_takeover);
+    BOOST_REQUIRE(agreed.client_no_context_takeover);
+    BOOST_REQUIRE_EQUAL(agreed.server_window_bits, 15u);
+    BOOST_REQUIRE_EQUAL(agreed.client_window_bits, 15u);
+    BOOST_REQUIRE_EQUAL(websocket_deflate::to_string(agreed),
+        "permessage-deflate; server_no_context_takeover; "
+        "client_no_context_takeover");
+}
+
+BOOST_AUTO_TEST_CASE(websocket_deflate__negotiate__context_takeover__as_offered)
+{
+    const websocket_deflate instance(6, 15, true);
+    if (!websocket_deflate::available())
+        return;
+
+    const auto agreed = negotiate(instance,
+        "permessage-deflate; client_max_window_bits");
+    BOOST_REQUIRE(!agreed.server_no_context_takeover);
+    BOOST_REQUIRE(!agreed.client_no_context_takeover);
+    BOOST_REQUIRE(agreed.client_window_bits_offered);
+    BOOST_REQUIRE_EQUAL(websocket_deflate::to_string(agreed),
+        "permessage-deflate; client_max_window_bits=15");
+}
+
+BOOST_AUTO_TEST_CASE(websocket_deflate__negotiate__window_bits__smallest)
+{
+    const websocket_deflate instance(6, 12, true);
+    if (!websocket_deflate::available())
+        return;
+
+    const auto agreed = negotiate(instance,
+        "permessage-deflate; server_max_window_bits=10; "
+        "client_max_window_bits=\"14\"");
+    BOOST_REQUIRE_EQUAL(agreed.server_window_bits, 10u);
+    BOOST_REQUIRE_EQUAL(agreed.client_window_bits, 12u);
+    BOOST_REQUIRE_EQUAL(websocket_deflate::to_string(agreed),
+        "permessage-deflate; server_max_window_bits=10; "
+        "client_max_window_bits=12");
+}
+
+BOOST_AUTO_TEST_CASE(websocket_deflate__negotiate__invalid_offer__next_offer)
+{
+    const websocket_deflate instance(6);
+    if (!websocket_deflate::available())
+        return;
+
+    // Unknown, repeated and out of range parameters decline an offer.
+    negotiate(instance, "permessage-deflate; foo", false);
+    negotiate(instance, "permessage-deflate; server_no_context_takeover; "
+        "server_no_context_takeover", false);
+    negotiate(instance, "permessage-deflate; server_max_window_bits=8",
+        false);
+    negotiate(instance, "permessage-deflate; client_max_window_bits=16",
+        false);
+
+    const auto agreed = negotiate(instance,
+        "permessage-deflate; server_max_window_bits=8, "
+        "Permessage-Deflate; server_max_window_bits=9");
+    BOOST_REQUIRE_EQUAL(agreed.server_window_bits, 9u);
+}
+
+#ifdef WITH_ZLIB
+
+static parameters agreement(bool takeover)
+{
+    return { true, 15, 15, false, !takeover, !takeover };
+}
+
+static std::string decompress(websocket_deflate& instance,
+    websocket_deflate::session& state, const data_chunk& data,
+    size_t limit=1024)
+{
+    data_chunk out;
+    BOOST_REQUIRE(instance.decompress(out, state, data.data(), data.size(),
+        limit));
+    return { out.begin(), out.end() };
+}
+
+BOOST_AUTO_TEST_CASE(websocket_deflate__decompress__rfc7692_hello__expected)
+{
+    websocket_deflate instance(6);
+    websocket_deflate::session state{ agreement(false) };
+    const data_chunk hello{ 0xf2, 0x48, 0xcd, 0xc9, 0xc9, 0x07, 0x00 };
+    BOOST_REQUIRE_EQUAL(decompress(instance, state, hello), "Hello");
+
+    // The stream is returned to the pool after each message.
+    BOOST_REQUIRE_EQUAL(instance.pooled(), 1u);
+    BOOST_REQUIRE_EQUAL(decompress(instance, state, hello), "Hello");
+    BOOST_REQUIRE_EQUAL(instance.pooled(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(websocket_deflate__decompress__over_limit__false)
+{
+    websocket_deflate instance(6);
+    websocket_deflate::session state{ agreement(false) };
+    const data_chunk hello{ 0xf2, 0x48, 0xcd, 0xc9, 0xc9, 0x07, 0x00 };
+    data_chunk out;
+    BOOST_REQUIRE(!instance.decompress(out, state, hello.data(), hello.size(),
+        4));
+}
+
+BOOST_AUTO_TEST_CASE(websocket_deflate__decompress__invalid__false)
+{
+    websocket_deflate instance(6);
+    websocket_deflate::session state{ agreement(false) };
+    const data_chunk invalid{ 0xff, 0xff, 0xff, 0xff };
+    data_chunk out;
+    BOOST_REQUIRE(!instance.decompress(out, state, invalid.data(),
+        invalid.size(), 1024));
+}
+
+BOOST_AUTO_TEST_CASE(websocket_deflate__compress__below_threshold__null)
+{
+    websocket_deflate instance(6);
+    websocket_deflate::session state{ agreement(false) };
+    const std::string message(64, 'a');
+    const auto data = reinterpret_cast<const uint8_t*>(message.data());
+    BOOST_REQUIRE(instance.compress(state, data, message.size()) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(websocket_deflate__compress__no_context_takeover__round_trip)
+{
+    websocket_deflate server(6);
+    websocket_deflate client(6);
+    websocket_deflate::session sender{ agreement(false) };
+    websocket_deflate::session receiver{ agreement(false) };
+    std::string message;
+
+    for (auto index = 0; index < 100; ++index)
+        message += "{\"id\":" + std::to_string(index) + ",\"result\":null}";
+
+    const auto data = reinterpret_cast<const uint8_t*>(message.data());
+
+    for (auto count = 0; count < 2; ++count)
+    {
+        const auto compressed = server.compress(sender, data, message.size());
+        BOOST_REQUIRE(compressed != nullptr);
+        BOOST_REQUIRE_LT(compressed->size(), message.size());
+        BOOST_REQUIRE_EQUAL(decompress(client, receiver, *compressed, 8192),
+            message);
+    }
+
+    // No state is held between messages.
+    BOOST_REQUIRE(!sender.deflater);
+    BOOST_REQUIRE(!receiver.inflater);
+    BOOST_REQUIRE_EQUAL(server.pooled(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(websocket_deflate__compress__context_takeover__round_trip)
+{
+    websocket_deflate server(6, 15, true);
+    websocket_deflate client(6, 15, true);
+    websocket_deflate::session sender{ agreement(true) };
+    websocket_deflate::session receiver{ agreement(true) };
+    const std::string message(1000, 'x');
+    const auto data = reinterpret_cast<const uint8_t*>(message.data());
+
+    const auto first = server.compress(sender, data, message.size());
+    BOOST_REQUIRE(first != nullptr);
+    const auto first_size = first->size();
+    BOOST_REQUIRE_EQUAL(decompress(client, receiver, *first), message);
+
+    // The repeated message refers to the shared window.
+    const auto second = server.compress(sender, data, message.size());
+    BOOST_REQUIRE(second != nullptr);
+    BOOST_REQUIRE_LE(second->size(), first_size);
+    BOOST_REQUIRE_EQUAL(decompress(client, receiver, *second), message);
+
+    BOOST_REQUIRE(sender.deflater);
+    BOOST_REQUIRE(receiver.inflater);
+    server.release(sender);
+    BOOST_REQUIRE(!sender.deflater);
+    BOOST_REQUIRE_EQUAL(server.pooled(), 1u);
+}
+
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,112 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <bitcoin/protocol.hpp>
+
+using namespace bc::system;
+using namespace bc::protocol::http;
+
+BOOST_AUTO_TEST_SUITE(websocket_keepalive_tests)
+
+typedef websocket_keepalive::clock clock;
+typedef websocket_keepalive::microseconds microseconds;
+
+static const clock::time_point start = clock::now();
+static const auto interval = std::chrono::seconds(30);
+
+static bool pong(websocket_keepalive& instance, const data_chunk& payload,
+    const clock::time_point& now)
+{
+    return instance.pong(payload.data(), payload.size(), now);
+}
+
+BOOST_AUTO_TEST_CASE(websocket_keepalive__due__interval__expected)
+{
+    websocket_keepalive instance;
+    instance.start(start);
+    BOOST_REQUIRE(!instance.due(start + interval / 2, interval));
+    BOOST_REQUIRE(instance.due(start + interval, interval));
+
+    instance.ping(start + interval);
+    BOOST_REQUIRE(!instance.due(start + interval, interval));
+    BOOST_REQUIRE(instance.due(start + interval * 2, interval));
+}
+
+BOOST_AUTO_TEST_CASE(websocket_keepalive__pong__matching__sampled)
+{
+    websocket_keepalive instance;
+    instance.start(start);
+    BOOST_REQUIRE(instance.round_trip() == microseconds(0));
+
+    const auto payload = instance.ping(start);
+    BOOST_REQUIRE_EQUAL(payload.size(), websocket_keepalive::payload_size);
+    BOOST_REQUIRE(instance.outstanding());
+    BOOST_REQUIRE(pong(instance, payload, start + microseconds(800)));
+    BOOST_REQUIRE(!instance.outstanding());
+    BOOST_REQUIRE(instance.round_trip() == microseconds(800));
+    BOOST_REQUIRE(instance.last_round_trip() == microseconds(800));
+
+    // A repeated pong does not answer a ping.
+    BOOST_REQUIRE(!pong(instance, payload, start + microseconds(900)));
+}
+
+BOOST_AUTO_TEST_CASE(websocket_keepalive__pong__samples__smoothed)
+{
+    websocket_keepalive instance;
+    instance.start(start);
+    BOOST_REQUIRE(pong(instance, instance.ping(start),
+        start + microseconds(800)));
+
+    const auto later = start + interval;
+    BOOST_REQUIRE(pong(instance, instance.ping(later),
+        later + microseconds(1600)));
+    BOOST_REQUIRE(instance.last_round_trip() == microseconds(1600));
+    BOOST_REQUIRE(instance.round_trip() == microseconds(900));
+}
+
+BOOST_AUTO_TEST_CASE(websocket_keepalive__pong__unsolicited__ignored)
+{
+    websocket_keepalive instance;
+    instance.start(start);
+    const data_chunk heartbeat{ 'h', 'i' };
+    BOOST_REQUIRE(!pong(instance, heartbeat, start));
+
+    instance.ping(start);
+    BOOST_REQUIRE(!pong(instance, heartbeat, start));
+    BOOST_REQUIRE(instance.outstanding());
+}
+
+BOOST_AUTO_TEST_CASE(websocket_keepalive__ping__unanswered__missed)
+{
+    websocket_keepalive instance;
+    instance.start(start);
+    instance.ping(start);
+    BOOST_REQUIRE_EQUAL(instance.missed(), 0u);
+    instance.ping(start + interval);
+    BOOST_REQUIRE_EQUAL(instance.missed(), 1u);
+    const auto payload = instance.ping(start + interval * 2);
+    BOOST_REQUIRE_EQUAL(instance.missed(), 2u);
+
+    // Only the latest ping is answered, which clears the count.
+    BOOST_REQUIRE(pong(instance, payload, start + interval * 2));
+    BOOST_REQUIRE_EQUAL(instance.missed(), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
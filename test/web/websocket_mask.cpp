@@ -0,0 +1,156 @@
+/**
+ * Copyright (c) 2011-2019 libbitcoin developers (see AUTHORS)
+ *
+ * This file is part of libbitcoin.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <bitcoin/protocol.hpp>
+
+using namespace bc::protocol::http;
+
+BOOST_AUTO_TEST_SUITE(websocket_mask_tests)
+
+// The mask of the RFC 6455 section 5.7 examples.
+static const uint8_t mask[websocket_mask::mask_size]{ 0x37, 0xfa, 0x21, 0x3d };
+
+static const std::vector<websocket_mask::kernel> kernels
+{
+    websocket_mask::kernel::scalar,
+    websocket_mask::kernel::sse2,
+    websocket_mask::kernel::avx2,
+    websocket_mask::kernel::neon
+};
+
+static std::vector<uint8_t> payload(size_t size)
+{
+    std::vector<uint8_t> out(size);
+    for (size_t index = 0; index < size; ++index)
+        out[index] = static_cast<uint8_t>(index * 31 + 7);
+
+    return out;
+}
+
+// The reference (byte at a time) unmasking.
+static void reference(uint8_t* data, size_t size, size_t offset)
+{
+    for (size_t index = 0; index < size; ++index)
+        data[index] ^= mask[(offset + index) % 4];
+}
+
+BOOST_AUTO_TEST_CASE(websocket_mask__best__supported)
+{
+    BOOST_REQUIRE(websocket_mask::supported(websocket_mask::kernel::scalar));
+    BOOST_REQUIRE(websocket_mask::supported(websocket_mask::best()));
+    BOOST_REQUIRE(!websocket_mask::to_string(websocket_mask::best()).empty());
+}
+
+BOOST_AUTO_TEST_CASE(websocket_mask__apply__empty__unchanged)
+{
+    uint8_t byte = 0x42;
+    websocket_mask::apply(&byte, 0, mask);
+    BOOST_REQUIRE_EQUAL(byte, 0x42);
+}
+
+BOOST_AUTO_TEST_CASE(websocket_mask__apply__rfc6455_example__unmasked)
+{
+    // A masked "Hello".
+    std::vector<uint8_t> data{ 0x7f, 0x9f, 0x4d, 0x51, 0x58 };
+    websocket_mask::apply(data.data(), data.size(), mask);
+    BOOST_REQUIRE(data == std::vector<uint8_t>({ 'H', 'e', 'l', 'l', 'o' }));
+}
+
+// Sizes either side of the vector minimum (512), and with scalar tails.
+static const std::vector<size_t> vector_sizes
+{
+    511, 512, 513, 575, 1000, 4097
+};
+
+static void require_matches_reference(websocket_mask::kernel kernel,
+    size_t size)
+{
+    for (size_t alignment = 0; alignment < 32; ++alignment)
+    {
+        for (size_t offset = 0; offset < 4; ++offset)
+        {
+            auto expected = payload(alignment + size);
+            auto actual = expected;
+            reference(expected.data() + alignment, size, offset);
+            websocket_mask::apply(kernel, actual.data() + alignment, size,
+                mask, offset);
+            BOOST_REQUIRE(actual == expected);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(websocket_mask__apply__all_kernels__matches_reference)
+{
+    // Every short size (below the vector minimum) at every alignment and
+    // offset, as served by the scalar path of each kernel.
+    for (const auto kernel: kernels)
+    {
+        if (!websocket_mask::supported(kernel))
+            continue;
+
+        for (size_t size = 0; size < 100; ++size)
+            require_matches_reference(kernel, size);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(websocket_mask__apply__all_kernels_vector_sizes__matches_reference)
+{
+    // Sizes that reach the vector loops, at every alignment and offset.
+    for (const auto kernel: kernels)
+    {
+        if (!websocket_mask::supported(kernel))
+            continue;
+
+        for (const auto size: vector_sizes)
+            require_matches_reference(kernel, size);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(websocket_mask__apply__large_payload__matches_reference)
+{
+    const size_t size = 65536 + 13;
+    auto expected = payload(size + 1);
+    auto actual = expected;
+    reference(expected.data() + 1, size, 0);
+    websocket_mask::apply(actual.data() + 1, size, mask);
+    BOOST_REQUIRE(actual == expected);
+}
+
+BOOST_AUTO_TEST_CASE(websocket_mask__apply__in_parts__matches_whole)
+{
+    auto expected = payload(1000);
+    auto actual = expected;
+    websocket_mask::apply(expected.data(), expected.size(), mask);
+
+    // A payload unmasked as it arrives, in parts of uneven size.
+    size_t offset = 0;
+    for (const size_t part: { 3, 250, 17, 730 })
+    {
+        websocket_mask::apply(actual.data() + offset, part, mask, offset);
+        offset += part;
+    }
+
+    BOOST_REQUIRE(actual == expected);
+}
+
+BOOST_AUTO_TEST_SUITE_END()